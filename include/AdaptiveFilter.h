@@ -0,0 +1,160 @@
+#ifndef ADAPTIVE_FILTER_H
+#define ADAPTIVE_FILTER_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+enum AdaptiveAlgorithm
+{
+	ADAPT_LMS,			/* w += mu e x */
+	ADAPT_LEAKY_LMS,	/* w += mu e x - leakage w */
+	ADAPT_SIGN_ERROR,	/* w += mu sign(e) x */
+	ADAPT_NLMS			/* w += mu e x / (epsilon + |x|^2) */
+};
+
+/* Algorithm and word lengths of an adaptive FIR. x and the desired signal
+ * are in dataFormat; the filter output is rounded into accFormat, the error
+ * d - y into errorFormat. mu, the leakage and epsilon are quantized to
+ * stepFormat. The scaled error g = mu e (or its sign-error or normalized
+ * form) is held in errorFormat and g x is rounded into weightFormat.
+ *
+ * updateDelay models a pipelined update (delayed LMS): the error of sample
+ * n is applied to the weights used for sample n + 1 + updateDelay. */
+struct AdaptiveFilterConfig
+{
+	unsigned int numTaps;
+	AdaptiveAlgorithm algorithm;
+	double stepSize;
+	double leakage;
+	double epsilon;
+	unsigned int updateDelay;
+	FixedPointFormat dataFormat;
+	FixedPointFormat weightFormat;
+	FixedPointFormat accFormat;
+	FixedPointFormat errorFormat;
+	FixedPointFormat stepFormat;
+	RoundingMode rounding;
+	OverflowMode overflow;
+
+	AdaptiveFilterConfig(unsigned int taps = 16,
+		AdaptiveAlgorithm alg = ADAPT_LMS, double mu = 1.0 / 64)
+		: numTaps(taps),
+		algorithm(alg),
+		stepSize(mu),
+		leakage(0.0),
+		epsilon(1.0 / 1024),
+		updateDelay(0),
+		dataFormat(16, 15),
+		weightFormat(24, 22),
+		accFormat(24, 20),
+		errorFormat(18, 15),
+		stepFormat(18, 17),
+		rounding(ROUND_HALF_UP),
+		overflow(OVERFLOW_SATURATE)
+	{
+	}
+};
+
+/* Adaptive FIR on raw values in the configured formats:
+ *
+ *   y[n] = sum_k w[k] x[n-k]
+ *   e[n] = d[n] - y[n]
+ *
+ * Filtering and the weight update run in one pass over the taps: the pass
+ * for sample n first applies the pending update from sample n - 1 -
+ * updateDelay to each weight and then accumulates its product. Sums are
+ * exact and rounded once into accFormat; each updated weight is rounded and
+ * wrapped or saturated to weightFormat. */
+class AdaptiveFilter
+{
+public:
+
+	explicit AdaptiveFilter(const AdaptiveFilterConfig &config,
+		const std::vector<double> &initialWeights = std::vector<double>());
+
+	const AdaptiveFilterConfig &config(void) const { return m_config; }
+
+	/* One sample; returns y[n] */
+	std::int64_t process(std::int64_t x, std::int64_t desired);
+	FixedPoint process(const FixedPoint &x, const FixedPoint &desired);
+	/* n samples; y and error may be null */
+	void process(const std::int64_t *x, const std::int64_t *desired,
+		std::int64_t *y, std::int64_t *error, std::size_t n);
+
+	std::int64_t error(void) const { return m_error; }
+	const std::vector<std::int64_t> &weights(void) const { return m_weights; }
+	void reset(void);
+
+private:
+
+	AdaptiveFilterConfig m_config;
+	std::int64_t m_mu;
+	std::int64_t m_leak;
+	std::int64_t m_epsilon;
+	std::vector<std::int64_t> m_initialWeights;
+	std::vector<std::int64_t> m_weights;
+
+	/* x history twice over so every window is contiguous */
+	std::vector<std::int64_t> m_history;
+	std::size_t m_historyLength;
+	std::size_t m_pos;
+	/* scaled errors waiting to be applied */
+	std::vector<std::int64_t> m_gains;
+	std::size_t m_gainPos;
+	std::int64_t m_error;
+};
+
+/* Complex adaptive FIR, y[n] = sum_k w[k] x[n-k] with the update
+ * w[k] += g conj(x[n-k]). Sign-error uses sign(Re e) + j sign(Im e); NLMS
+ * normalizes by sum |x|^2. Real and imaginary parts are kept in separate
+ * arrays. */
+class ComplexAdaptiveFilter
+{
+public:
+
+	explicit ComplexAdaptiveFilter(const AdaptiveFilterConfig &config,
+		const std::vector<std::complex<double> > &initialWeights =
+			std::vector<std::complex<double> >());
+
+	const AdaptiveFilterConfig &config(void) const { return m_config; }
+
+	std::complex<std::int64_t> process(std::complex<std::int64_t> x,
+		std::complex<std::int64_t> desired);
+	ComplexFixedPoint process(const ComplexFixedPoint &x,
+		const ComplexFixedPoint &desired);
+	void process(const std::complex<std::int64_t> *x,
+		const std::complex<std::int64_t> *desired,
+		std::complex<std::int64_t> *y, std::complex<std::int64_t> *error,
+		std::size_t n);
+
+	std::complex<std::int64_t> error(void) const { return m_error; }
+	std::vector<std::complex<std::int64_t> > weights(void) const;
+	void reset(void);
+
+private:
+
+	AdaptiveFilterConfig m_config;
+	std::int64_t m_mu;
+	std::int64_t m_leak;
+	std::int64_t m_epsilon;
+	std::vector<std::int64_t> m_initialReal;
+	std::vector<std::int64_t> m_initialImag;
+	std::vector<std::int64_t> m_weightsReal;
+	std::vector<std::int64_t> m_weightsImag;
+
+	std::vector<std::int64_t> m_historyReal;
+	std::vector<std::int64_t> m_historyImag;
+	std::size_t m_historyLength;
+	std::size_t m_pos;
+	std::vector<std::int64_t> m_gainsReal;
+	std::vector<std::int64_t> m_gainsImag;
+	std::size_t m_gainPos;
+	std::complex<std::int64_t> m_error;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef AUTOMATIC_GAIN_CONTROL_H
+#define AUTOMATIC_GAIN_CONTROL_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+enum AgcDetector
+{
+	AGC_DETECT_POWER,		/* |y|^2 */
+	AGC_DETECT_MAGNITUDE	/* max(|Re y|, |Im y|) + min(|Re y|, |Im y|) / 2 */
+};
+
+/* Loop parameters and word lengths of a log-domain AGC. targetLevel is the
+ * wanted mean detector output (a power or a magnitude, in output units)
+ * and loopGain the fraction of the log2 level error corrected per update;
+ * gains are linear. The detector mean over an update interval is rounded
+ * into detectorFormat; its log2, the target, the error and the loop
+ * integrator are in logFormat, in log2 units of amplitude. loopGain is
+ * quantized to loopGainFormat and the linear gain to gainFormat. The log2
+ * and 2^x tables have 2^lutBits + 1 entries. */
+struct AgcConfig
+{
+	AgcDetector detector;
+	double targetLevel;
+	double loopGain;
+	double initialGain;
+	double minGain;
+	double maxGain;
+	/* Samples per gain update, a power of two */
+	unsigned int updateInterval;
+	unsigned int lutBits;
+	FixedPointFormat inputFormat;
+	FixedPointFormat outputFormat;
+	FixedPointFormat detectorFormat;
+	FixedPointFormat logFormat;
+	FixedPointFormat loopGainFormat;
+	FixedPointFormat gainFormat;
+	RoundingMode rounding;
+	OverflowMode overflow;
+
+	AgcConfig(AgcDetector det = AGC_DETECT_POWER, double target = 0.25,
+		unsigned int interval = 16)
+		: detector(det),
+		targetLevel(target),
+		loopGain(1.0 / 8),
+		initialGain(1.0),
+		minGain(1.0 / 256),
+		maxGain(64.0),
+		updateInterval(interval),
+		lutBits(6),
+		inputFormat(16, 15),
+		outputFormat(16, 15),
+		detectorFormat(24, 21),
+		logFormat(16, 10),
+		loopGainFormat(16, 15),
+		gainFormat(24, 16),
+		rounding(ROUND_HALF_UP),
+		overflow(OVERFLOW_SATURATE)
+	{
+	}
+};
+
+/* Closed-loop AGC on complex samples, as an RTL loop would be built:
+ *
+ *   y[n] = g x[n]
+ *   L    = log2(mean of detector(y) over updateInterval samples)
+ *   G   += loopGain (log2(targetLevel) - L),  clamped to the gain limits
+ *   g    = 2^G
+ *
+ * For the power detector the error is halved, so G stays a log2 amplitude.
+ * log2 is a leading-one position plus a table of the next lutBits
+ * mantissa bits, and 2^G a table of G's first lutBits fractional bits
+ * shifted by its integer part. The tables come from the CoefficientCache.
+ * Products g x are rounded and saturated or wrapped into outputFormat.
+ *
+ * The gain is constant within an update interval, so each interval is
+ * processed as a block: one loop multiplies, one accumulates the detector.
+ * Intervals carry over between process() calls. A longer interval trades
+ * loop bandwidth for throughput. */
+class AutomaticGainControl
+{
+public:
+
+	explicit AutomaticGainControl(const AgcConfig &config);
+
+	const AgcConfig &config(void) const { return m_config; }
+
+	ComplexFixedPoint process(const ComplexFixedPoint &x);
+	void process(const std::vector<ComplexFixedPoint> &in,
+		std::vector<ComplexFixedPoint> &out);
+	/* in and out may be the same array */
+	void process(const std::complex<std::int64_t> *in,
+		std::complex<std::int64_t> *out, std::size_t n);
+
+	/* Current gain word, and its log2 in logFormat */
+	FixedPoint gain(void) const;
+	FixedPoint logGain(void) const;
+	void reset(void);
+
+private:
+
+	AgcConfig m_config;
+	unsigned int m_intervalBits;
+	std::int64_t m_target;
+	std::int64_t m_loopGain;
+	std::int64_t m_minLog;
+	std::int64_t m_maxLog;
+	std::int64_t m_initialLog;
+	/* log2(1 + i / 2^lutBits) in logFormat, 2^(i / 2^lutBits) with
+	 * gainFormat's fractional bits */
+	std::vector<std::int64_t> m_logTable;
+	std::vector<std::int64_t> m_expTable;
+
+	std::int64_t m_log;
+	std::int64_t m_gain;
+	std::int64_t m_detectorSum;
+	std::size_t m_count;
+
+	std::int64_t log2Value(std::int64_t v) const;
+	std::int64_t exp2Value(std::int64_t logValue) const;
+	void update(void);
+};
+
+#endif
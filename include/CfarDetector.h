@@ -0,0 +1,132 @@
+#ifndef CFAR_DETECTOR_H
+#define CFAR_DETECTOR_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Quantization.h"
+
+enum CfarMethod
+{
+	CFAR_CA,	/* cell averaging: mean of both training windows */
+	CFAR_GO,	/* greatest of the two window means */
+	CFAR_SO,	/* smallest of the two window means */
+	CFAR_OS		/* rank-th smallest training cell */
+};
+
+/* Windows and word lengths of a range CFAR. Each side of the cell under
+ * test has guardCells guard cells and then trainingCells training cells.
+ * A cell is detected when it exceeds threshold times the noise estimate;
+ * the threshold is quantized to thresholdFormat. Power cells are in
+ * cellFormat; complex maps are squared and rounded into it. */
+struct CfarConfig
+{
+	CfarMethod method;
+	unsigned int guardCells;
+	unsigned int trainingCells;
+	/* 1 to 2 trainingCells, for CFAR_OS */
+	unsigned int rank;
+	double threshold;
+	FixedPointFormat cellFormat;
+	FixedPointFormat thresholdFormat;
+	RoundingMode rounding;
+	OverflowMode overflow;
+
+	CfarConfig(CfarMethod m = CFAR_CA, unsigned int guard = 2,
+		unsigned int training = 16, double alpha = 8.0)
+		: method(m),
+		guardCells(guard),
+		trainingCells(training),
+		rank(3 * training / 2),
+		threshold(alpha),
+		cellFormat(33, 30),
+		thresholdFormat(16, 8),
+		rounding(ROUND_HALF_UP),
+		overflow(OVERFLOW_SATURATE)
+	{
+	}
+};
+
+struct CfarDetection
+{
+	std::uint32_t doppler;
+	std::uint32_t range;
+	std::int64_t cell;
+	/* Noise estimate, rounded to cellFormat */
+	std::int64_t noise;
+};
+
+/* CFAR along range over a row-major range-Doppler map,
+ * cells[doppler * numRange + range].
+ *
+ * Window sums come from a running (prefix) sum of each row. Every window
+ * sum is then a difference of two prefix values, so the interior of a row
+ * is evaluated with loops across range bins that carry no dependence.
+ * Prefix sums wrap modulo 2^64, and the differences are still exact. The
+ * test cell * n > threshold * sum is done in integers, with n the number
+ * of cells behind the sum, so nothing is divided.
+ *
+ * Windows are cut off at the ends of a row:
+ *   - CA averages the cells that remain.
+ *   - GO and SO fall back to the one remaining side.
+ *   - OS scales rank in proportion to the cells that remain.
+ *   - Cells with no training cells at all are not tested.
+ *
+ * Doppler rows are split into contiguous blocks, one per thread. Each
+ * thread walks its rows in tiles of TILE_ROWS. A complex tile is squared
+ * into a buffer that stays in cache and is detected straight away.
+ * Detections come out in row-major order for any number of threads. */
+class CfarDetector
+{
+public:
+
+	static const std::size_t TILE_ROWS = 8;
+
+	explicit CfarDetector(const CfarConfig &config,
+		unsigned int numThreads = 0);
+
+	/* Threshold on the mean of numTraining exponentially distributed
+	 * cells giving the false alarm rate pfa with CA-CFAR:
+	 * numTraining (pfa^(-1/numTraining) - 1) */
+	static double caThreshold(double pfa, unsigned int numTraining);
+
+	const CfarConfig &config(void) const { return m_config; }
+
+	std::vector<CfarDetection> detect(const std::int64_t *cells,
+		std::size_t numDoppler, std::size_t numRange) const;
+	/* Cells in inputFormat, squared into cellFormat */
+	std::vector<CfarDetection> detect(const std::complex<std::int64_t> *cells,
+		std::size_t numDoppler, std::size_t numRange,
+		FixedPointFormat inputFormat) const;
+
+private:
+
+	/* Per-thread row buffers */
+	struct Workspace
+	{
+		std::vector<std::uint64_t> prefix;
+		std::vector<std::int64_t> lagSum;
+		std::vector<std::int64_t> leadSum;
+		std::vector<std::uint32_t> lagCount;
+		std::vector<std::uint32_t> leadCount;
+		std::vector<std::int64_t> training;
+		std::vector<std::int64_t> tile;
+	};
+
+	CfarConfig m_config;
+	unsigned int m_numThreads;
+	std::int64_t m_threshold;
+
+	std::vector<CfarDetection> run(std::size_t numDoppler,
+		std::size_t numRange,
+		const std::function<const std::int64_t *(Workspace &, std::size_t,
+			std::size_t)> &loadTile) const;
+	void detectRow(const std::int64_t *row, std::size_t numRange,
+		std::uint32_t doppler, Workspace &work,
+		std::vector<CfarDetection> &out) const;
+	void windowSums(std::size_t numRange, Workspace &work) const;
+};
+
+#endif
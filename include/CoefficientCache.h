@@ -0,0 +1,26 @@
+#ifndef COEFFICIENT_CACHE_H
+#define COEFFICIENT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Quantization.h"
+
+typedef std::shared_ptr<const std::vector<std::int64_t> > CoefficientTable;
+
+/* Process-wide cache of quantized coefficient tables. A table of doubles is
+ * quantized to a given format once, with the rounding of
+ * FixedPoint::quantize, and shared by every block built from the same
+ * values and format. Safe to use from several threads. */
+class CoefficientCache
+{
+public:
+
+	static CoefficientTable quantize(const std::vector<double> &values,
+		FixedPointFormat format);
+	static std::size_t size(void);
+	static void clear(void);
+};
+
+#endif
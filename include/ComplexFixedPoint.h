@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include "FixedPoint.h"
+#include "Quantization.h"
 
 class ComplexFixedPoint;
 typedef ComplexFixedPoint CFxp;
@@ -30,6 +31,10 @@ public:
 	int64_t maxVal(void) const { return m_maxVal; }
 	int64_t minHeldVal(void) const { return m_minHeldVal; }
 	int64_t maxHeldVal(void) const { return m_maxHeldVal; }
+	FixedPointFormat format(void) const
+	{
+		return FixedPointFormat(m_width, m_fracBits);
+	}
 
 	CFxp &operator = (const CFxp &rhs);
 	friend bool operator == (const CFxp &lhs, const CFxp & rhs);
@@ -44,10 +49,19 @@ public:
 	CFxp &truncateTo(unsigned int newWidth);
 	CFxp &saturateTo(unsigned int newWidth);
 	CFxp &saturateBy(unsigned int numMsbsToRemove);
-	CFxp &roundBy(unsigned int numLsbsToRemove);
-	CFxp &roundTo(unsigned int newWidth);
+	CFxp &roundBy(unsigned int numLsbsToRemove,
+		RoundingMode mode = ROUND_HALF_UP);
+	CFxp &roundTo(unsigned int newWidth, RoundingMode mode = ROUND_HALF_UP);
 	CFxp &signExtendBy(unsigned int numMsbsToAdd);
 	CFxp &signExtendTo(unsigned int newWidth);
+	/* Aligns, rounds and saturates or wraps into newFormat in one step, as
+	 * an HDL resize */
+	CFxp &resize(FixedPointFormat newFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+	/* Register write: rhs resized into this value's format */
+	CFxp &assign(const CFxp &rhs, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
 	std::complex<float> toFloat(void) const;
 	std::complex<double> toDouble(void) const;
 
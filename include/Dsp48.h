@@ -0,0 +1,121 @@
+#ifndef DSP48_H
+#define DSP48_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Quantization.h"
+
+/* Port widths and boundary behaviour of a DSP slice. The defaults match a
+ * DSP48E2: 30 bit A, 18 bit B, 27 bit D and pre-adder, 27x18 multiplier,
+ * 48 bit C/P and cascade. Values entering a port keep only the port's bits,
+ * as the hardware does; the pre-adder and post-adder wrap or saturate. */
+struct Dsp48Config
+{
+	unsigned int aWidth;
+	unsigned int bWidth;
+	unsigned int dWidth;
+	unsigned int preAddWidth;
+	unsigned int pWidth;
+	bool usePreAdder;
+	bool preSubtract;
+	OverflowMode preAddOverflow;
+	OverflowMode postAddOverflow;
+
+	Dsp48Config(void)
+		: aWidth(30),
+		bWidth(18),
+		dWidth(27),
+		preAddWidth(27),
+		pWidth(48),
+		usePreAdder(false),
+		preSubtract(false),
+		preAddOverflow(OVERFLOW_WRAP),
+		postAddOverflow(OVERFLOW_WRAP)
+	{
+	}
+};
+
+/* One DSP slice with every pipeline register enabled:
+ *
+ *   stage 1: A, B, C, D input registers
+ *   stage 2: A2, B2 and AD (pre-adder output, or A when it is unused)
+ *   stage 3: M = AD * B2
+ *   stage 4: P = Z + M, Z selected from 0, C, PCIN or P
+ *
+ * ACOUT is the A2 register, so slices chained through ACOUT/PCOUT form the
+ * classic systolic FIR. */
+class Dsp48Slice
+{
+public:
+
+	enum ZSelect
+	{
+		Z_ZERO,
+		Z_C,
+		Z_PCIN,
+		Z_P
+	};
+
+	explicit Dsp48Slice(const Dsp48Config &config = Dsp48Config());
+
+	/* Combinational pieces of the datapath */
+	std::int64_t multiplierInput(std::int64_t a, std::int64_t d) const;
+	std::int64_t multiply(std::int64_t ad, std::int64_t b) const;
+	std::int64_t postAdd(std::int64_t z, std::int64_t m) const;
+
+	/* Advance one clock; returns the new P */
+	std::int64_t clock(std::int64_t a, std::int64_t b, std::int64_t c,
+		std::int64_t d, std::int64_t pcin, ZSelect z);
+
+	std::int64_t p(void) const { return m_p; }
+	std::int64_t acout(void) const { return m_a2; }
+	const Dsp48Config &config(void) const { return m_config; }
+	void reset(void);
+
+private:
+
+	Dsp48Config m_config;
+	std::int64_t m_a;
+	std::int64_t m_b;
+	std::int64_t m_c;
+	std::int64_t m_d;
+	std::int64_t m_a2;
+	std::int64_t m_ad;
+	std::int64_t m_b2;
+	std::int64_t m_m;
+	std::int64_t m_p;
+};
+
+/* Systolic FIR of one slice per coefficient, bit-exact with a chain of
+ * Dsp48Slice objects linked through ACOUT/PCOUT:
+ *
+ *   y[n] = P_{N-1}, P_k = post(P_{k-1} + h[k] x[n - latency() - k])
+ *
+ * with the post-adder wrap or saturation applied after every slice. Blocks
+ * are computed slice by slice across all samples of the block, so the inner
+ * loop is a plain integer multiply-add over an array. */
+class Dsp48Chain
+{
+public:
+
+	Dsp48Chain(const std::vector<std::int64_t> &coefficients,
+		const Dsp48Config &config = Dsp48Config());
+
+	std::size_t numSlices(void) const { return m_coefs.size(); }
+	/* Clocks from an input sample to its first product at the output */
+	std::size_t latency(void) const { return m_coefs.size() + 2; }
+
+	std::int64_t clock(std::int64_t x);
+	void process(const std::int64_t *x, std::int64_t *y, std::size_t n);
+	void reset(void);
+
+private:
+
+	Dsp48Slice m_slice;
+	std::vector<std::int64_t> m_coefs;
+	std::vector<std::int64_t> m_work;
+	std::size_t m_historyLength;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef FARROW_RESAMPLER_H
+#define FARROW_RESAMPLER_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Quantization.h"
+
+/* Arbitrary-ratio resampler built from a Farrow structure:
+ *
+ *   y = sum_m mu^m sum_k C[m][k] x[k]
+ *
+ * evaluated as M+1 fixed FIR branches followed by Horner's rule in the
+ * fractional delay mu. The output position advances by ratio = input rate /
+ * output rate input samples per output, held in an unsigned phase
+ * accumulator with phaseBits fractional bits; mu is its muBits MSBs, as a
+ * hardware NCO would provide.
+ *
+ * Branch sums are exact, then rounded into accFormat. Horner steps multiply
+ * by mu, drop muBits LSBs, add the next branch and wrap or saturate to
+ * accFormat; the result is requantized to outputFormat. Nothing in the
+ * sample loop uses floating point.
+ *
+ * Each block is processed in two passes: a scalar pass steps the phase
+ * accumulator to find every output's input window and mu, then the branch
+ * filters and Horner steps run across all outputs of the block. */
+class FarrowResampler
+{
+public:
+
+	/* Lagrange interpolator of the given order (order + 1 taps) */
+	FarrowResampler(double ratio, unsigned int order,
+		FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+		FixedPointFormat accFormat, FixedPointFormat outputFormat,
+		unsigned int muBits = 16, unsigned int phaseBits = 32,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	/* Arbitrary branch coefficients, coefficients[m][k] */
+	FarrowResampler(double ratio,
+		const std::vector<std::vector<double> > &coefficients,
+		FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+		FixedPointFormat accFormat, FixedPointFormat outputFormat,
+		unsigned int muBits = 16, unsigned int phaseBits = 32,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	/* Farrow coefficients of a Lagrange interpolator over taps at
+	 * -floor(order/2) .. order - floor(order/2), interpolating between the
+	 * taps at 0 and 1 */
+	static std::vector<std::vector<double> > lagrange(unsigned int order);
+
+	unsigned int numTaps(void) const { return m_numTaps; }
+	unsigned int polynomialOrder(void) const { return m_coefs.size() - 1; }
+	/* Input samples between an input and the interpolation interval */
+	unsigned int delay(void) const { return m_delay; }
+	FixedPointFormat outputFormat(void) const { return m_outputFormat; }
+
+	/* Append the outputs for n more input samples; return their number */
+	std::size_t process(const std::int64_t *in, std::size_t n,
+		std::vector<std::int64_t> &out);
+	std::size_t process(const std::complex<std::int64_t> *in, std::size_t n,
+		std::vector<std::complex<std::int64_t> > &out);
+	void reset(void);
+
+private:
+
+	std::vector<std::vector<std::int64_t> > m_coefs;
+	unsigned int m_numTaps;
+	unsigned int m_delay;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_coefFormat;
+	FixedPointFormat m_accFormat;
+	FixedPointFormat m_outputFormat;
+	unsigned int m_muBits;
+	unsigned int m_phaseBits;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	std::uint64_t m_step;
+	std::uint64_t m_phase;
+
+	std::vector<std::int64_t> m_history;
+	std::vector<std::int64_t> m_historyImag;
+	std::vector<std::size_t> m_bases;
+	std::vector<std::int64_t> m_mus;
+	std::vector<std::int64_t> m_work;
+	std::vector<std::int64_t> m_partIn;
+	std::vector<std::int64_t> m_partOut;
+
+	void init(double ratio, const std::vector<std::vector<double> > &coefs);
+	std::size_t schedule(std::size_t n);
+	void filter(std::vector<std::int64_t> &history,
+		const std::int64_t *in, std::size_t n, std::size_t numOutputs,
+		std::int64_t *out);
+};
+
+#endif
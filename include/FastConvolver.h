@@ -0,0 +1,111 @@
+#ifndef FAST_CONVOLVER_H
+#define FAST_CONVOLVER_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FixedPointFft.h"
+#include "Quantization.h"
+
+enum FastConvolutionMode
+{
+	FAST_CONVOLUTION,	/* y[n] = sum_k h[k] x[n-k] */
+	FAST_CORRELATION	/* y[n] = sum_k conj(h[k]) x[n-(N-1)+k], a matched filter */
+};
+
+enum FastConvolutionMethod
+{
+	OVERLAP_SAVE,
+	OVERLAP_ADD
+};
+
+/* Long FIR or matched filter evaluated in the frequency domain, as an FPGA
+ * fast convolution core does it. Blocks of blockSize() = fftSize - N + 1
+ * new samples are aligned into dataFormat, transformed, multiplied by the
+ * tap spectrum (computed once and quantized to coefFormat, so coefFormat
+ * needs enough integer bits for the spectrum's peak), inverse transformed
+ * and either trimmed (overlap-save) or added to the previous block's tail
+ * (overlap-add). Products are rounded back to the data LSB; both FFTs follow
+ * their own scale schedules (see FixedPointFft).
+ *
+ * Outputs are the filter's true output in outputFormat: the scaling of the
+ * two transforms is folded into the final requantization, so the schedules
+ * only trade precision against headroom. In correlation mode y[n] peaks at
+ * n = start + N - 1 for a copy of h starting at sample start.
+ *
+ * Blocks completed by one call are transformed together using the FFT's
+ * interleaved batch layout. */
+class FastConvolver
+{
+public:
+
+	FastConvolver(const std::vector<std::complex<double> > &taps,
+		FastConvolutionMode mode, std::size_t fftSize,
+		FixedPointFormat inputFormat, FixedPointFormat dataFormat,
+		FixedPointFormat coefFormat, FixedPointFormat twiddleFormat,
+		FixedPointFormat outputFormat,
+		unsigned int forwardSchedule = FixedPointFft::SCALE_ALL,
+		unsigned int inverseSchedule = 0,
+		FastConvolutionMethod method = OVERLAP_SAVE,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	/* Real taps; only these can be used with real data */
+	FastConvolver(const std::vector<double> &taps, FastConvolutionMode mode,
+		std::size_t fftSize, FixedPointFormat inputFormat,
+		FixedPointFormat dataFormat, FixedPointFormat coefFormat,
+		FixedPointFormat twiddleFormat, FixedPointFormat outputFormat,
+		unsigned int forwardSchedule = FixedPointFft::SCALE_ALL,
+		unsigned int inverseSchedule = 0,
+		FastConvolutionMethod method = OVERLAP_SAVE,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	std::size_t numTaps(void) const { return m_numTaps; }
+	std::size_t fftSize(void) const { return m_forward.size(); }
+	/* New input samples consumed per transform */
+	std::size_t blockSize(void) const { return m_blockSize; }
+
+	/* Append the outputs of every block completed by n more inputs; output
+	 * i corresponds to input i. Returns the number appended. */
+	std::size_t process(const std::complex<std::int64_t> *in, std::size_t n,
+		std::vector<std::complex<std::int64_t> > &out);
+	std::size_t process(const std::int64_t *in, std::size_t n,
+		std::vector<std::int64_t> &out);
+	void reset(void);
+
+private:
+
+	std::size_t m_numTaps;
+	std::size_t m_blockSize;
+	bool m_realTaps;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_dataFormat;
+	FixedPointFormat m_coefFormat;
+	FixedPointFormat m_outputFormat;
+	unsigned int m_resultFracBits;
+	FastConvolutionMethod m_method;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	FixedPointFft m_forward;
+	FixedPointFft m_inverse;
+	std::vector<std::int64_t> m_spectrumReal;
+	std::vector<std::int64_t> m_spectrumImag;
+
+	/* overlap-save history or overlap-add pending input, then new input */
+	std::vector<std::int64_t> m_inputReal;
+	std::vector<std::int64_t> m_inputImag;
+	/* overlap-add tail of N - 1 values in dataFormat */
+	std::vector<std::int64_t> m_tailReal;
+	std::vector<std::int64_t> m_tailImag;
+	std::vector<std::int64_t> m_workReal;
+	std::vector<std::int64_t> m_workImag;
+	std::vector<std::complex<std::int64_t> > m_result;
+
+	void init(const std::vector<std::complex<double> > &taps,
+		FastConvolutionMode mode);
+	std::size_t history(void) const;
+};
+
+#endif
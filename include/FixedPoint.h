@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include <iostream>
+#include "Quantization.h"
 
 class FixedPoint;
 typedef FixedPoint Fxp;
@@ -27,6 +28,10 @@ public:
 	int64_t maxVal(void) const { return m_maxVal; }
 	int64_t minHeldVal(void) const { return m_minHeldVal; }
 	int64_t maxHeldVal(void) const { return m_maxHeldVal; }
+	FixedPointFormat format(void) const
+	{
+		return FixedPointFormat(m_width, m_fracBits);
+	}
 
 	Fxp &operator = (const Fxp &rhs);
 	friend bool operator == (const Fxp &lhs, const Fxp & rhs);
@@ -39,10 +44,19 @@ public:
 	Fxp &truncateTo(unsigned int newWidth);
 	Fxp &saturateTo(unsigned int newWidth);
 	Fxp &saturateBy(unsigned int numMsbsToRemove);
-	Fxp &roundBy(unsigned int numLsbsToRemove);
-	Fxp &roundTo(unsigned int newWidth);
+	Fxp &roundBy(unsigned int numLsbsToRemove,
+		RoundingMode mode = ROUND_HALF_UP);
+	Fxp &roundTo(unsigned int newWidth, RoundingMode mode = ROUND_HALF_UP);
 	Fxp &signExtendBy(unsigned int numMsbsToAdd);
 	Fxp &signExtendTo(unsigned int newWidth);
+	/* Aligns, rounds and saturates or wraps into newFormat in one step, as
+	 * an HDL resize */
+	Fxp &resize(FixedPointFormat newFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+	/* Register write: rhs resized into this value's format */
+	Fxp &assign(const Fxp &rhs, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
 	float toFloat(void) const;
 	double toDouble(void) const;
 
@@ -0,0 +1,597 @@
+#ifndef FIXED_POINT_EXPRESSION_H
+#define FIXED_POINT_EXPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* Lazy FixedPoint arithmetic over arrays and scalars.
+ *
+ * Operators on FixedPointArray operands, and on scalars wrapped by lazy(),
+ * build an expression tree instead of computing temporaries. Each node
+ * infers its format when it is built, with the same rules and range_errors
+ * as the FixedPoint operation it stands for, so an invalid expression fails
+ * before anything is computed. Assigning the expression to a
+ * FixedPointArray then evaluates it in one pass over the elements: every
+ * element goes through the whole chain in registers, with no per-step
+ * setWidth(), checkSize() or min/max tracking. For example
+ *
+ *   FixedPointArray y(((x * gain) + offset).roundBy(4).saturateTo(16));
+ *   y = (x * lazy(coef)).roundTo(16, ROUND_HALF_EVEN);
+ *
+ * where gain is an Fxp broadcast to every element. roundBy() throws
+ * range_error after the pass if any element carried into the sign bit, as
+ * FixedPoint::roundBy() does; the destination is then left unchanged.
+ * Arrays are held by reference, so an expression must not outlive the
+ * arrays it was built from. */
+
+class FixedPointArray;
+class ScalarExpression;
+template <class E> class RoundExpression;
+template <class E> class TruncateExpression;
+template <class E> class SaturateExpression;
+template <class E> class SignExtendExpression;
+template <class E> class ResizeExpression;
+
+/* Nodes hold their operands by value, arrays by reference */
+template <class E>
+struct ExpressionOperand
+{
+	typedef E type;
+};
+
+template <>
+struct ExpressionOperand<FixedPointArray>
+{
+	typedef const FixedPointArray &type;
+};
+
+template <class E>
+class FixedPointExpression
+{
+public:
+
+	const E &self(void) const { return static_cast<const E &>(*this); }
+
+	RoundExpression<E> roundBy(unsigned int numLsbsToRemove,
+		RoundingMode mode = ROUND_HALF_UP) const;
+	RoundExpression<E> roundTo(unsigned int newWidth,
+		RoundingMode mode = ROUND_HALF_UP) const;
+	TruncateExpression<E> truncateBy(unsigned int numLsbsToRemove) const;
+	TruncateExpression<E> truncateTo(unsigned int newWidth) const;
+	SaturateExpression<E> saturateTo(unsigned int newWidth) const;
+	SaturateExpression<E> saturateBy(unsigned int numMsbsToRemove) const;
+	SignExtendExpression<E> signExtendTo(unsigned int newWidth) const;
+	SignExtendExpression<E> signExtendBy(unsigned int numMsbsToAdd) const;
+	ResizeExpression<E> resize(FixedPointFormat newFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+
+	/* Element i of the result, or the result of a scalar expression */
+	Fxp value(std::size_t i = 0) const;
+
+protected:
+
+	/* Scalars have size 0 and broadcast to any array size */
+	static std::size_t combinedSize(std::size_t a, std::size_t b)
+	{
+		if (a != 0 && b != 0 && a != b)
+		{
+			throw std::runtime_error("Array sizes do not match");
+		}
+		return std::max(a, b);
+	}
+};
+
+/* An Fxp broadcast to every element */
+class ScalarExpression : public FixedPointExpression<ScalarExpression>
+{
+public:
+
+	explicit ScalarExpression(const Fxp &v)
+		: m_value(v.val()),
+		m_format(v.format())
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return 0; }
+	std::int64_t evaluate(std::size_t, bool &) const { return m_value; }
+
+private:
+
+	std::int64_t m_value;
+	FixedPointFormat m_format;
+};
+
+inline ScalarExpression lazy(const Fxp &v)
+{
+	return ScalarExpression(v);
+}
+
+/* lhs + rhs with the binary points aligned, as Fxp operator + */
+template <class L, class R>
+class SumExpression : public FixedPointExpression<SumExpression<L, R> >
+{
+public:
+
+	SumExpression(const L &lhs, const R &rhs)
+		: m_lhs(lhs),
+		m_rhs(rhs),
+		m_format(sumFormat(lhs.format(), rhs.format())),
+		m_lhsShift(m_format.fracBits() - lhs.format().fracBits()),
+		m_rhsShift(m_format.fracBits() - rhs.format().fracBits()),
+		m_size(FixedPointExpression<SumExpression<L, R> >::combinedSize(
+			lhs.size(), rhs.size()))
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_size; }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		std::uint64_t a = (std::uint64_t)m_lhs.evaluate(i, overflow);
+		std::uint64_t b = (std::uint64_t)m_rhs.evaluate(i, overflow);
+		return (std::int64_t)((a << m_lhsShift) + (b << m_rhsShift));
+	}
+
+private:
+
+	typename ExpressionOperand<L>::type m_lhs;
+	typename ExpressionOperand<R>::type m_rhs;
+	FixedPointFormat m_format;
+	unsigned int m_lhsShift;
+	unsigned int m_rhsShift;
+	std::size_t m_size;
+
+	static FixedPointFormat sumFormat(FixedPointFormat a, FixedPointFormat b)
+	{
+		unsigned int fracBits = std::max(a.fracBits(), b.fracBits());
+		unsigned int difference = fracBits - std::min(a.fracBits(),
+			b.fracBits());
+		return FixedPointFormat(std::max(a.width(), b.width()) + 1 + difference,
+			fracBits);
+	}
+};
+
+/* lhs * rhs at full precision, as Fxp operator * */
+template <class L, class R>
+class ProductExpression
+	: public FixedPointExpression<ProductExpression<L, R> >
+{
+public:
+
+	ProductExpression(const L &lhs, const R &rhs)
+		: m_lhs(lhs),
+		m_rhs(rhs),
+		m_format(lhs.format().width() + rhs.format().width(),
+			lhs.format().fracBits() + rhs.format().fracBits()),
+		m_size(FixedPointExpression<ProductExpression<L, R> >::combinedSize(
+			lhs.size(), rhs.size()))
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_size; }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		return m_lhs.evaluate(i, overflow) * m_rhs.evaluate(i, overflow);
+	}
+
+private:
+
+	typename ExpressionOperand<L>::type m_lhs;
+	typename ExpressionOperand<R>::type m_rhs;
+	FixedPointFormat m_format;
+	std::size_t m_size;
+};
+
+template <class E>
+class RoundExpression : public FixedPointExpression<RoundExpression<E> >
+{
+public:
+
+	RoundExpression(const E &operand, unsigned int numLsbsToRemove,
+		RoundingMode mode)
+		: m_operand(operand),
+		m_format(checkedFormat(operand.format(), numLsbsToRemove)),
+		m_numLsbs(numLsbsToRemove),
+		m_mode(mode),
+		m_limit(operand.format().maxVal() >> numLsbsToRemove)
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_operand.size(); }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		std::int64_t rounded = roundShift(m_operand.evaluate(i, overflow),
+			m_numLsbs, m_mode);
+		overflow |= rounded > m_limit;
+		return rounded;
+	}
+
+private:
+
+	typename ExpressionOperand<E>::type m_operand;
+	FixedPointFormat m_format;
+	unsigned int m_numLsbs;
+	RoundingMode m_mode;
+	std::int64_t m_limit;
+
+	static FixedPointFormat checkedFormat(FixedPointFormat f, unsigned int n)
+	{
+		if (n >= f.width())
+		{
+			throw std::range_error("Round width out of range");
+		}
+		return FixedPointFormat(f.width() - n,
+			(f.fracBits() > n) ? f.fracBits() - n : 0);
+	}
+};
+
+template <class E>
+class TruncateExpression
+	: public FixedPointExpression<TruncateExpression<E> >
+{
+public:
+
+	TruncateExpression(const E &operand, unsigned int numLsbsToRemove)
+		: m_operand(operand),
+		m_format(checkedFormat(operand.format(), numLsbsToRemove)),
+		m_numLsbs(numLsbsToRemove)
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_operand.size(); }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		return m_operand.evaluate(i, overflow) >> m_numLsbs;
+	}
+
+private:
+
+	typename ExpressionOperand<E>::type m_operand;
+	FixedPointFormat m_format;
+	unsigned int m_numLsbs;
+
+	static FixedPointFormat checkedFormat(FixedPointFormat f, unsigned int n)
+	{
+		if (n >= f.width())
+		{
+			throw std::range_error("Truncation width out of range");
+		}
+		return FixedPointFormat(f.width() - n,
+			(f.fracBits() > n) ? f.fracBits() - n : 0);
+	}
+};
+
+template <class E>
+class SaturateExpression
+	: public FixedPointExpression<SaturateExpression<E> >
+{
+public:
+
+	SaturateExpression(const E &operand, unsigned int newWidth)
+		: m_operand(operand),
+		m_format(checkedFormat(operand.format(), newWidth))
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_operand.size(); }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		return saturateValue(m_operand.evaluate(i, overflow),
+			m_format.width());
+	}
+
+private:
+
+	typename ExpressionOperand<E>::type m_operand;
+	FixedPointFormat m_format;
+
+	static FixedPointFormat checkedFormat(FixedPointFormat f,
+		unsigned int newWidth)
+	{
+		if ((newWidth == 0) || (newWidth > f.width())
+			|| (newWidth < f.fracBits()))
+		{
+			throw std::range_error("Saturation width out of range");
+		}
+		return FixedPointFormat(newWidth, f.fracBits());
+	}
+};
+
+template <class E>
+class SignExtendExpression
+	: public FixedPointExpression<SignExtendExpression<E> >
+{
+public:
+
+	SignExtendExpression(const E &operand, unsigned int numMsbsToAdd)
+		: m_operand(operand),
+		m_format(checkedFormat(operand.format(), numMsbsToAdd))
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_operand.size(); }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		return m_operand.evaluate(i, overflow);
+	}
+
+private:
+
+	typename ExpressionOperand<E>::type m_operand;
+	FixedPointFormat m_format;
+
+	static FixedPointFormat checkedFormat(FixedPointFormat f, unsigned int n)
+	{
+		if (n > FixedPoint::MAX_WIDTH - f.width())
+		{
+			throw std::range_error("Sign extend width out of range");
+		}
+		return FixedPointFormat(f.width() + n, f.fracBits());
+	}
+};
+
+/* As Fxp::resize() */
+template <class E>
+class ResizeExpression : public FixedPointExpression<ResizeExpression<E> >
+{
+public:
+
+	ResizeExpression(const E &operand, FixedPointFormat newFormat,
+		RoundingMode rounding, OverflowMode overflow)
+		: m_operand(operand),
+		m_format(newFormat),
+		m_fromFracBits(operand.format().fracBits()),
+		m_rounding(rounding),
+		m_overflow(overflow)
+	{
+	}
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_operand.size(); }
+	std::int64_t evaluate(std::size_t i, bool &overflow) const
+	{
+		return resizeValue(m_operand.evaluate(i, overflow), m_fromFracBits,
+			m_format, m_rounding, m_overflow);
+	}
+
+private:
+
+	typename ExpressionOperand<E>::type m_operand;
+	FixedPointFormat m_format;
+	unsigned int m_fromFracBits;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+};
+
+/* Raw values sharing one format; the operand and destination of fused
+ * expressions */
+class FixedPointArray : public FixedPointExpression<FixedPointArray>
+{
+public:
+
+	FixedPointArray(std::size_t size, FixedPointFormat format);
+	/* Values outside the format throw range_error */
+	FixedPointArray(const std::vector<std::int64_t> &values,
+		FixedPointFormat format);
+	FixedPointArray(const FixedPointArray &other) = default;
+	/* Takes the size and inferred format of the expression */
+	template <class E>
+	FixedPointArray(const FixedPointExpression<E> &expr);
+
+	static FixedPointArray quantize(const std::vector<double> &values,
+		FixedPointFormat format);
+
+	FixedPointFormat format(void) const { return m_format; }
+	std::size_t size(void) const { return m_values.size(); }
+	const std::int64_t *data(void) const { return m_values.data(); }
+	std::int64_t evaluate(std::size_t i, bool &) const { return m_values[i]; }
+
+	Fxp operator [] (std::size_t i) const;
+	/* v must have the array's format, as Fxp operator = */
+	void set(std::size_t i, const Fxp &v);
+	std::vector<double> toDouble(void) const;
+
+	/* The expression's format must match the array's, as Fxp operator =;
+	 * the array takes the expression's size, scalars fill it */
+	FixedPointArray &operator = (const FixedPointArray &rhs);
+	template <class E>
+	FixedPointArray &operator = (const FixedPointExpression<E> &expr);
+	/* Resizes each element into the array's format, as Fxp::assign() */
+	template <class E>
+	FixedPointArray &assign(const FixedPointExpression<E> &expr,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+private:
+
+	std::vector<std::int64_t> m_values;
+	FixedPointFormat m_format;
+
+	template <class E>
+	static std::vector<std::int64_t> evaluateAll(const E &expr,
+		std::size_t size);
+};
+
+template <class L, class R>
+SumExpression<L, R> operator + (const FixedPointExpression<L> &lhs,
+	const FixedPointExpression<R> &rhs)
+{
+	return SumExpression<L, R>(lhs.self(), rhs.self());
+}
+
+template <class L>
+SumExpression<L, ScalarExpression> operator + (
+	const FixedPointExpression<L> &lhs, const Fxp &rhs)
+{
+	return SumExpression<L, ScalarExpression>(lhs.self(), lazy(rhs));
+}
+
+template <class R>
+SumExpression<ScalarExpression, R> operator + (const Fxp &lhs,
+	const FixedPointExpression<R> &rhs)
+{
+	return SumExpression<ScalarExpression, R>(lazy(lhs), rhs.self());
+}
+
+template <class L, class R>
+ProductExpression<L, R> operator * (const FixedPointExpression<L> &lhs,
+	const FixedPointExpression<R> &rhs)
+{
+	return ProductExpression<L, R>(lhs.self(), rhs.self());
+}
+
+template <class L>
+ProductExpression<L, ScalarExpression> operator * (
+	const FixedPointExpression<L> &lhs, const Fxp &rhs)
+{
+	return ProductExpression<L, ScalarExpression>(lhs.self(), lazy(rhs));
+}
+
+template <class R>
+ProductExpression<ScalarExpression, R> operator * (const Fxp &lhs,
+	const FixedPointExpression<R> &rhs)
+{
+	return ProductExpression<ScalarExpression, R>(lazy(lhs), rhs.self());
+}
+
+template <class E>
+RoundExpression<E> FixedPointExpression<E>::roundBy(
+	unsigned int numLsbsToRemove, RoundingMode mode) const
+{
+	return RoundExpression<E>(self(), numLsbsToRemove, mode);
+}
+
+template <class E>
+RoundExpression<E> FixedPointExpression<E>::roundTo(unsigned int newWidth,
+	RoundingMode mode) const
+{
+	return roundBy(self().format().width() - newWidth, mode);
+}
+
+template <class E>
+TruncateExpression<E> FixedPointExpression<E>::truncateBy(
+	unsigned int numLsbsToRemove) const
+{
+	return TruncateExpression<E>(self(), numLsbsToRemove);
+}
+
+template <class E>
+TruncateExpression<E> FixedPointExpression<E>::truncateTo(
+	unsigned int newWidth) const
+{
+	return truncateBy(self().format().width() - newWidth);
+}
+
+template <class E>
+SaturateExpression<E> FixedPointExpression<E>::saturateTo(
+	unsigned int newWidth) const
+{
+	return SaturateExpression<E>(self(), newWidth);
+}
+
+template <class E>
+SaturateExpression<E> FixedPointExpression<E>::saturateBy(
+	unsigned int numMsbsToRemove) const
+{
+	return saturateTo(self().format().width() - numMsbsToRemove);
+}
+
+template <class E>
+SignExtendExpression<E> FixedPointExpression<E>::signExtendTo(
+	unsigned int newWidth) const
+{
+	return signExtendBy(newWidth - self().format().width());
+}
+
+template <class E>
+SignExtendExpression<E> FixedPointExpression<E>::signExtendBy(
+	unsigned int numMsbsToAdd) const
+{
+	return SignExtendExpression<E>(self(), numMsbsToAdd);
+}
+
+template <class E>
+ResizeExpression<E> FixedPointExpression<E>::resize(
+	FixedPointFormat newFormat, RoundingMode rounding,
+	OverflowMode overflow) const
+{
+	return ResizeExpression<E>(self(), newFormat, rounding, overflow);
+}
+
+template <class E>
+Fxp FixedPointExpression<E>::value(std::size_t i) const
+{
+	bool overflow = false;
+	std::int64_t v = self().evaluate(i, overflow);
+	if (overflow)
+	{
+		throw std::range_error("Rounding overflows width");
+	}
+	FixedPointFormat f = self().format();
+	return Fxp(v, f.width(), f.fracBits());
+}
+
+/* The fused pass: one straight-line evaluation per element; overflow is
+ * collected as a flag so the loop body has no branches */
+template <class E>
+std::vector<std::int64_t> FixedPointArray::evaluateAll(const E &expr,
+	std::size_t size)
+{
+	std::vector<std::int64_t> values(size);
+	std::int64_t *out = values.data();
+	bool overflow = false;
+	for (std::size_t i = 0; i < size; i++)
+	{
+		out[i] = expr.evaluate(i, overflow);
+	}
+	if (overflow)
+	{
+		throw std::range_error("Rounding overflows width");
+	}
+	return values;
+}
+
+template <class E>
+FixedPointArray::FixedPointArray(const FixedPointExpression<E> &expr)
+	: m_values(evaluateAll(expr.self(), expr.self().size())),
+	m_format(expr.self().format())
+{
+}
+
+template <class E>
+FixedPointArray &FixedPointArray::operator = (
+	const FixedPointExpression<E> &expr)
+{
+	if (expr.self().format() != m_format)
+	{
+		throw std::runtime_error(
+			"Size of lhs and rhs of assignment must match");
+	}
+	std::size_t n = expr.self().size() ? expr.self().size() : size();
+	m_values = evaluateAll(expr.self(), n);
+	return *this;
+}
+
+template <class E>
+FixedPointArray &FixedPointArray::assign(const FixedPointExpression<E> &expr,
+	RoundingMode rounding, OverflowMode overflow)
+{
+	ResizeExpression<E> resized(expr.self(), m_format, rounding, overflow);
+	std::size_t n = expr.self().size() ? expr.self().size() : size();
+	m_values = evaluateAll(resized, n);
+	return *this;
+}
+
+#endif
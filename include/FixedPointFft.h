@@ -0,0 +1,61 @@
+#ifndef FIXED_POINT_FFT_H
+#define FIXED_POINT_FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Quantization.h"
+
+/* Radix-2 decimation in time FFT on raw complex values, modelled on a
+ * hardware pipeline: data stays in dataFormat through every stage, twiddle
+ * products are rounded back to the data LSB, and stage s divides its
+ * outputs by 2 when bit s of scaleSchedule is set. Each stage's outputs
+ * wrap or saturate to the data width. The result is
+ *
+ *   X[k] = 2^-scaleShift() sum_n x[n] exp(-/+j 2 pi k n / size)
+ *
+ * with the + sign for the inverse transform (no 1/size factor). Twiddles
+ * are quantized to twiddleFormat, saturating +1; the trivial twiddle of
+ * each butterfly group passes data through exactly, so a format without
+ * an integer bit such as (16, 15) is usable. */
+class FixedPointFft
+{
+public:
+
+	static const unsigned int SCALE_ALL = ~0U;
+
+	FixedPointFft(std::size_t size, FixedPointFormat dataFormat,
+		FixedPointFormat twiddleFormat, unsigned int scaleSchedule = SCALE_ALL,
+		bool inverse = false, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	std::size_t size(void) const { return m_size; }
+	unsigned int numStages(void) const { return m_numStages; }
+	/* Number of stages that divide by 2 */
+	unsigned int scaleShift(void) const { return m_scaleShift; }
+	FixedPointFormat dataFormat(void) const { return m_dataFormat; }
+
+	/* In place transform of count interleaved transforms: bin k of
+	 * transform t is at [k * count + t], so the butterfly loops run across
+	 * transforms */
+	void transform(std::int64_t *real, std::int64_t *imag,
+		std::size_t count = 1) const;
+	void transform(std::vector<std::complex<std::int64_t> > &x) const;
+
+private:
+
+	std::size_t m_size;
+	unsigned int m_numStages;
+	FixedPointFormat m_dataFormat;
+	FixedPointFormat m_twiddleFormat;
+	unsigned int m_scaleSchedule;
+	unsigned int m_scaleShift;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	std::vector<std::int64_t> m_twiddleReal;
+	std::vector<std::int64_t> m_twiddleImag;
+	std::vector<std::size_t> m_bitReverse;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FIXED_POINT_REGISTER_H
+#define FIXED_POINT_REGISTER_H
+
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+class FixedPointRegister;
+typedef FixedPointRegister FxpReg;
+class ComplexFixedPointRegister;
+typedef ComplexFixedPointRegister CFxpReg;
+
+/* A FixedPoint whose format is set at construction. Anything assigned to it
+ * is resized into that format with the register's rounding and overflow
+ * modes, as an HDL register with resize() on its input, instead of
+ * throwing on a format mismatch like FixedPoint::operator=. */
+class FixedPointRegister : public FixedPoint
+{
+public:
+
+	FixedPointRegister(FixedPointFormat format,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+	FixedPointRegister(const FxpReg &other);
+
+	RoundingMode rounding(void) const { return m_rounding; }
+	OverflowMode overflow(void) const { return m_overflow; }
+
+	FxpReg &operator = (const Fxp &rhs);
+	FxpReg &operator = (const FxpReg &rhs);
+
+private:
+
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+};
+
+class ComplexFixedPointRegister : public ComplexFixedPoint
+{
+public:
+
+	ComplexFixedPointRegister(FixedPointFormat format,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+	ComplexFixedPointRegister(const CFxpReg &other);
+
+	RoundingMode rounding(void) const { return m_rounding; }
+	OverflowMode overflow(void) const { return m_overflow; }
+
+	CFxpReg &operator = (const CFxp &rhs);
+	CFxpReg &operator = (const CFxpReg &rhs);
+
+private:
+
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+};
+
+#endif
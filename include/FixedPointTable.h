@@ -0,0 +1,180 @@
+#ifndef FIXED_POINT_TABLE_H
+#define FIXED_POINT_TABLE_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* Compile-time generation of quantized coefficient and twiddle tables.
+ *
+ * A table declared constexpr is quantized by the compiler with the same
+ * rounding as FixedPoint::quantize and lands in read-only memory; a value
+ * that does not fit the format is a compile error. For example
+ *
+ *   static constexpr FixedPointTable<64> window(FxpFormat(18, 17),
+ *       [](std::size_t i) { return hannWindow(i, 64); });
+ *   static constexpr ComplexFixedPointTable<256> w =
+ *       ComplexFixedPointTable<256>::twiddles(FxpFormat(16, 14));
+ */
+
+static constexpr double CONSTEXPR_PI = 3.14159265358979323846;
+
+/* sin and cos usable in constant expressions: reduction to [-pi/4, pi/4]
+ * followed by Taylor series, accurate to a few ulps for table arguments */
+constexpr double constexprSinCos(double x, bool cosine)
+{
+	const double halfPi = CONSTEXPR_PI / 2;
+	double turns = x / halfPi;
+	long long quadrant = (long long)(turns + (turns >= 0 ? 0.5 : -0.5));
+	double r = x - quadrant * halfPi;
+	if (cosine)
+	{
+		quadrant++;
+	}
+
+	double r2 = r * r;
+	double sinTerm = r;
+	double sinSum = r;
+	double cosTerm = 1.0;
+	double cosSum = 1.0;
+	for (int n = 1; n <= 10; n++)
+	{
+		sinTerm *= -r2 / ((2 * n) * (2 * n + 1));
+		cosTerm *= -r2 / ((2 * n - 1) * (2 * n));
+		sinSum += sinTerm;
+		cosSum += cosTerm;
+	}
+
+	switch (((quadrant % 4) + 4) % 4)
+	{
+	case 0: return sinSum;
+	case 1: return cosSum;
+	case 2: return -sinSum;
+	default: return -cosSum;
+	}
+}
+
+constexpr double constexprSin(double x)
+{
+	return constexprSinCos(x, false);
+}
+
+constexpr double constexprCos(double x)
+{
+	return constexprSinCos(x, true);
+}
+
+/* Symmetric windows of length n, sample i */
+constexpr double hannWindow(std::size_t i, std::size_t n)
+{
+	return 0.5 - 0.5 * constexprCos(2 * CONSTEXPR_PI * i / (n - 1));
+}
+
+constexpr double hammingWindow(std::size_t i, std::size_t n)
+{
+	return 0.54 - 0.46 * constexprCos(2 * CONSTEXPR_PI * i / (n - 1));
+}
+
+constexpr double blackmanWindow(std::size_t i, std::size_t n)
+{
+	return 0.42 - 0.5 * constexprCos(2 * CONSTEXPR_PI * i / (n - 1))
+		+ 0.08 * constexprCos(4 * CONSTEXPR_PI * i / (n - 1));
+}
+
+template <std::size_t N>
+class FixedPointTable
+{
+public:
+
+	/* Quantize generator(i) for i = 0 .. N - 1 */
+	template <typename Generator>
+	constexpr FixedPointTable(FixedPointFormat format, Generator generator)
+		: m_format(format),
+		m_vals()
+	{
+		for (std::size_t i = 0; i < N; i++)
+		{
+			m_vals[i] = quantizeValue(generator(i), format);
+		}
+	}
+
+	constexpr FixedPointTable(FixedPointFormat format, const double (&values)[N])
+		: m_format(format),
+		m_vals()
+	{
+		for (std::size_t i = 0; i < N; i++)
+		{
+			m_vals[i] = quantizeValue(values[i], format);
+		}
+	}
+
+	constexpr std::size_t size(void) const { return N; }
+	constexpr FixedPointFormat format(void) const { return m_format; }
+	constexpr std::int64_t val(std::size_t i) const { return m_vals[i]; }
+	constexpr const std::int64_t *data(void) const { return m_vals; }
+
+	FixedPoint operator [] (std::size_t i) const
+	{
+		return FixedPoint(m_vals[i], m_format.width(), m_format.fracBits());
+	}
+
+private:
+
+	FixedPointFormat m_format;
+	std::int64_t m_vals[N];
+};
+
+template <std::size_t N>
+class ComplexFixedPointTable
+{
+public:
+
+	/* Quantize generator(i), a std::complex<double>, for i = 0 .. N - 1 */
+	template <typename Generator>
+	constexpr ComplexFixedPointTable(FixedPointFormat format,
+		Generator generator)
+		: m_format(format),
+		m_real(),
+		m_imag()
+	{
+		for (std::size_t i = 0; i < N; i++)
+		{
+			std::complex<double> c = generator(i);
+			m_real[i] = quantizeValue(c.real(), format);
+			m_imag[i] = quantizeValue(c.imag(), format);
+		}
+	}
+
+	/* DFT twiddles exp(-j 2 pi k / N) */
+	static constexpr ComplexFixedPointTable twiddles(FixedPointFormat format)
+	{
+		return ComplexFixedPointTable(format, [](std::size_t k)
+		{
+			double angle = -2 * CONSTEXPR_PI * k / N;
+			return std::complex<double>(constexprCos(angle),
+				constexprSin(angle));
+		});
+	}
+
+	constexpr std::size_t size(void) const { return N; }
+	constexpr FixedPointFormat format(void) const { return m_format; }
+	constexpr std::int64_t real(std::size_t i) const { return m_real[i]; }
+	constexpr std::int64_t imag(std::size_t i) const { return m_imag[i]; }
+
+	ComplexFixedPoint operator [] (std::size_t i) const
+	{
+		return ComplexFixedPoint(m_real[i], m_imag[i], m_format.width(),
+			m_format.fracBits());
+	}
+
+private:
+
+	FixedPointFormat m_format;
+	std::int64_t m_real[N];
+	std::int64_t m_imag[N];
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef MONTE_CARLO_ANALYZER_H
+#define MONTE_CARLO_ANALYZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Random.h"
+
+struct MonteCarloReport
+{
+	std::size_t numTrials;
+	std::size_t numSamples;
+	/* mean squares of the reference and of the error */
+	double signalPower;
+	double noisePower;
+	double sqnrDb;
+	/* (SQNR - 1.76) / 6.02 */
+	double enob;
+	double maxError;
+	double meanError;
+	double rmsError;
+	/* the trial with the lowest SQNR */
+	std::size_t worstTrial;
+	double worstTrialSqnrDb;
+	/* Averaged Hann-windowed periodogram of the error, spectrumSize bins
+	 * from DC, scaled so the bins sum to the error's mean square; empty
+	 * when no spectrum was requested */
+	std::vector<double> errorSpectrum;
+
+	std::string summary(void) const;
+};
+
+/* Runs a fixed-point model and a double-precision reference side by side on
+ * random stimuli and accumulates error statistics.
+ *
+ * Trial t draws its stimulus from Xoshiro256(seed, t), so every trial is
+ * reproducible on its own. Trials are accumulated in fixed groups of
+ * GROUP_SIZE, in trial order within a group, and the groups are merged in
+ * order, so the report is bit-identical for any number of threads. Both
+ * models see the same stimulus and must return outputs of the same
+ * length; complex outputs can be returned as interleaved real and
+ * imaginary parts. Models are called concurrently and must not share
+ * mutable state. */
+class MonteCarloAnalyzer
+{
+public:
+
+	static const std::size_t GROUP_SIZE = 16;
+
+	typedef std::function<std::vector<double>(Xoshiro256 &)> Stimulus;
+	typedef std::function<std::vector<double>(const std::vector<double> &)>
+		Model;
+
+	/* spectrumSize is 0 or a power of two */
+	MonteCarloAnalyzer(const Stimulus &stimulus, const Model &fixedModel,
+		const Model &referenceModel, std::size_t spectrumSize = 0,
+		unsigned int numThreads = 0);
+
+	MonteCarloReport run(std::size_t numTrials, std::uint64_t seed) const;
+
+private:
+
+	struct Accumulator
+	{
+		double signalSum;
+		double noiseSum;
+		double errorSum;
+		double maxError;
+		std::size_t numSamples;
+		std::size_t worstTrial;
+		double worstSqnrDb;
+		std::size_t numSegments;
+		std::vector<double> spectrum;
+	};
+
+	Stimulus m_stimulus;
+	Model m_fixedModel;
+	Model m_referenceModel;
+	std::size_t m_spectrumSize;
+	unsigned int m_numThreads;
+	std::vector<double> m_window;
+	double m_windowPower;
+
+	void runTrial(std::size_t trial, std::uint64_t seed,
+		Accumulator &acc) const;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef MULTICHANNEL_H
+#define MULTICHANNEL_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* Raw values of numChannels channels sharing one format, stored
+ * lane-interleaved: frame-major with the channels of a frame contiguous,
+ * data()[frame * numChannels() + channel]. Loops across channels then run
+ * over adjacent values, including in recursive filters that cannot be
+ * vectorized along time. */
+class MultichannelBuffer
+{
+public:
+
+	MultichannelBuffer(unsigned int numChannels, std::size_t numFrames,
+		FixedPointFormat format);
+
+	unsigned int numChannels(void) const { return m_numChannels; }
+	std::size_t numFrames(void) const { return m_numFrames; }
+	FixedPointFormat format(void) const { return m_format; }
+	void resize(std::size_t numFrames);
+
+	std::int64_t *data(void) { return m_data.data(); }
+	const std::int64_t *data(void) const { return m_data.data(); }
+	std::int64_t *frame(std::size_t f) { return &m_data[f * m_numChannels]; }
+	const std::int64_t *frame(std::size_t f) const
+	{
+		return &m_data[f * m_numChannels];
+	}
+
+	FixedPoint get(std::size_t frame, unsigned int channel) const;
+	void set(std::size_t frame, unsigned int channel, const FixedPoint &v);
+
+	/* Copy one channel to or from a contiguous array of numFrames values */
+	void readChannel(unsigned int channel, std::int64_t *out) const;
+	void writeChannel(unsigned int channel, const std::int64_t *in);
+
+private:
+
+	unsigned int m_numChannels;
+	std::size_t m_numFrames;
+	FixedPointFormat m_format;
+	std::vector<std::int64_t> m_data;
+};
+
+/* Complex channels as separate real and imaginary lane-interleaved planes */
+class ComplexMultichannelBuffer
+{
+public:
+
+	ComplexMultichannelBuffer(unsigned int numChannels, std::size_t numFrames,
+		FixedPointFormat format);
+
+	unsigned int numChannels(void) const { return m_real.numChannels(); }
+	std::size_t numFrames(void) const { return m_real.numFrames(); }
+	FixedPointFormat format(void) const { return m_real.format(); }
+	void resize(std::size_t numFrames);
+
+	MultichannelBuffer &real(void) { return m_real; }
+	const MultichannelBuffer &real(void) const { return m_real; }
+	MultichannelBuffer &imag(void) { return m_imag; }
+	const MultichannelBuffer &imag(void) const { return m_imag; }
+
+	ComplexFixedPoint get(std::size_t frame, unsigned int channel) const;
+	void set(std::size_t frame, unsigned int channel,
+		const ComplexFixedPoint &v);
+
+private:
+
+	MultichannelBuffer m_real;
+	MultichannelBuffer m_imag;
+};
+
+/* Runs batch operations on multichannel buffers. Channels are split into
+ * groups of groupSize adjacent lanes and whole groups are spread over
+ * numThreads threads (0 for all cores); within a group every loop runs
+ * across channels. The destination's format selects the result format and
+ * the destination is resized to the input's length. */
+class MultichannelEngine
+{
+public:
+
+	static const unsigned int DEFAULT_GROUP_SIZE = 64;
+
+	explicit MultichannelEngine(unsigned int numThreads = 0,
+		unsigned int groupSize = DEFAULT_GROUP_SIZE);
+
+	unsigned int numThreads(void) const { return m_numThreads; }
+	unsigned int groupSize(void) const { return m_groupSize; }
+
+	/* fn(channelBegin, channelEnd) over all channels, once per thread */
+	void forEachGroup(unsigned int numChannels,
+		const std::function<void(unsigned int, unsigned int)> &fn) const;
+
+	void requantize(const MultichannelBuffer &in, MultichannelBuffer &out,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+	/* out = a * b, sample by sample */
+	void multiply(const MultichannelBuffer &a, const MultichannelBuffer &b,
+		MultichannelBuffer &out, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+	/* out = gains[channel] * in */
+	void multiply(const MultichannelBuffer &in,
+		const std::vector<std::int64_t> &gains, FixedPointFormat gainFormat,
+		MultichannelBuffer &out, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+	/* acc += in; acc keeps its length and format */
+	void accumulate(const MultichannelBuffer &in, MultichannelBuffer &acc,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+
+	void requantize(const ComplexMultichannelBuffer &in,
+		ComplexMultichannelBuffer &out, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+	void multiply(const ComplexMultichannelBuffer &a,
+		const ComplexMultichannelBuffer &b, ComplexMultichannelBuffer &out,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+	void multiply(const ComplexMultichannelBuffer &in,
+		const std::vector<std::complex<std::int64_t> > &gains,
+		FixedPointFormat gainFormat, ComplexMultichannelBuffer &out,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+	void accumulate(const ComplexMultichannelBuffer &in,
+		ComplexMultichannelBuffer &acc, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE) const;
+
+private:
+
+	unsigned int m_numThreads;
+	unsigned int m_groupSize;
+};
+
+/* The same FIR on every channel with per-channel history. Sums are exact
+ * and rounded once into outputFormat. */
+class MultichannelFir
+{
+public:
+
+	MultichannelFir(const std::vector<double> &coefficients,
+		FixedPointFormat coefFormat, unsigned int numChannels,
+		FixedPointFormat inputFormat, FixedPointFormat outputFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	unsigned int numChannels(void) const { return m_numChannels; }
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	std::vector<std::int64_t> m_coefs;
+	FixedPointFormat m_coefFormat;
+	unsigned int m_numChannels;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	/* the last numTaps - 1 input frames, oldest first */
+	std::vector<std::int64_t> m_history;
+};
+
+/* The same direct form I biquad on every channel,
+ *
+ *   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ *
+ * with a = {1, a1, a2}. The sum is exact and rounded into outputFormat,
+ * which is also the format of the fed back y. */
+class MultichannelBiquad
+{
+public:
+
+	MultichannelBiquad(const std::vector<double> &b,
+		const std::vector<double> &a, FixedPointFormat coefFormat,
+		unsigned int numChannels, FixedPointFormat inputFormat,
+		FixedPointFormat outputFormat, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	unsigned int numChannels(void) const { return m_numChannels; }
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	std::int64_t m_b[3];
+	std::int64_t m_a[2];
+	FixedPointFormat m_coefFormat;
+	unsigned int m_numChannels;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	std::vector<std::int64_t> m_x1;
+	std::vector<std::int64_t> m_x2;
+	std::vector<std::int64_t> m_y1;
+	std::vector<std::int64_t> m_y2;
+};
+
+#endif
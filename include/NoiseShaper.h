@@ -0,0 +1,68 @@
+#ifndef NOISE_SHAPER_H
+#define NOISE_SHAPER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FixedPoint.h"
+#include "Quantization.h"
+#include "Random.h"
+
+/* Requantizes one or more channels from inputFormat to outputFormat (fewer
+ * fractional bits) with error feedback noise shaping and optional TPDF
+ * dither, as in a DAC or output stage:
+ *
+ *   v[n] = x[n] - sum_k h[k] e[n-1-k]
+ *   y[n] = Q(v[n] + d[n])
+ *   e[n] = y[n] - v[n]
+ *
+ * giving a noise transfer function NTF(z) = 1 - sum_k h[k] z^-(k+1), e.g.
+ * h = {1} for 1 - z^-1 or h = {2, -1} for (1 - z^-1)^2. The h[k] are
+ * quantized with filterFracBits fractional bits and the feedback sum is
+ * rounded to the input LSB. d[n] is triangular dither of +/-1 output LSB
+ * from a per-channel seeded PRNG. Outputs saturate to the output width;
+ * the error is taken before saturation so clipping cannot destabilize the
+ * loop.
+ *
+ * Samples are processed in frames of numChannels interleaved values. The
+ * recursion runs along time, so the inner loop runs across channels with
+ * all state stored channel-contiguous. */
+class NoiseShaper
+{
+public:
+
+	NoiseShaper(FixedPointFormat inputFormat, FixedPointFormat outputFormat,
+		const std::vector<double> &errorFilter = std::vector<double>(),
+		unsigned int filterFracBits = 12, bool dither = false,
+		std::uint64_t seed = 0, unsigned int numChannels = 1,
+		RoundingMode rounding = ROUND_HALF_UP);
+
+	unsigned int numChannels(void) const { return m_numChannels; }
+	FixedPointFormat inputFormat(void) const { return m_inputFormat; }
+	FixedPointFormat outputFormat(void) const { return m_outputFormat; }
+
+	FixedPoint process(const FixedPoint &x);
+	void process(const std::int64_t *in, std::int64_t *out,
+		std::size_t numFrames);
+	void reset(void);
+
+private:
+
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_outputFormat;
+	unsigned int m_shift;
+	std::vector<std::int64_t> m_filter;
+	unsigned int m_filterFracBits;
+	bool m_dither;
+	std::uint64_t m_seed;
+	unsigned int m_numChannels;
+	RoundingMode m_rounding;
+
+	/* error history, m_filter.size() rows of m_numChannels, as a ring */
+	std::vector<std::int64_t> m_errors;
+	std::size_t m_errorPos;
+	std::vector<Xoshiro256> m_rngs;
+	std::vector<std::int64_t> m_feedback;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/* Number of threads used when a caller asks for 0 (i.e. "all cores") */
+inline unsigned int defaultThreadCount(void)
+{
+	unsigned int n = std::thread::hardware_concurrency();
+	return n ? n : 1;
+}
+
+/* Splits [begin, end) into at most numThreads contiguous chunks and calls
+ * fn(chunkBegin, chunkEnd, chunkIndex) for each chunk on its own thread.
+ * Chunk boundaries depend only on the range and the thread count. The first
+ * exception thrown by any chunk is rethrown in the calling thread. */
+inline void parallelFor(std::size_t begin, std::size_t end,
+	const std::function<void(std::size_t, std::size_t, unsigned int)> &fn,
+	unsigned int numThreads = 0)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+
+	if (numThreads == 0)
+	{
+		numThreads = defaultThreadCount();
+	}
+
+	std::size_t count = end - begin;
+	if (numThreads > count)
+	{
+		numThreads = count;
+	}
+
+	if (numThreads == 1)
+	{
+		fn(begin, end, 0);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	std::vector<std::exception_ptr> errors(numThreads);
+	for (unsigned int t = 0; t < numThreads; t++)
+	{
+		std::size_t chunkBegin = begin + count * t / numThreads;
+		std::size_t chunkEnd = begin + count * (t + 1) / numThreads;
+		threads.emplace_back([&fn, &errors, chunkBegin, chunkEnd, t]()
+		{
+			try
+			{
+				fn(chunkBegin, chunkEnd, t);
+			}
+			catch (...)
+			{
+				errors[t] = std::current_exception();
+			}
+		});
+	}
+
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+
+	for (std::exception_ptr &error : errors)
+	{
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+#endif
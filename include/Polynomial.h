@@ -0,0 +1,88 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "CoefficientCache.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* Fixed-point Horner evaluation of c[0] + c[1] x + ... + c[N] x^N.
+ *
+ * Coefficients are quantized to coefFormat through CoefficientCache and
+ * moved to the accumulator's binary point once at construction. Every Horner
+ * step multiplies the accumulator by x, removes the input's fractional bits
+ * with the given rounding mode, adds the next coefficient and wraps or
+ * saturates to accFormat. The result is requantized to outputFormat the same
+ * way. The accumulator and input widths together may not exceed 63 bits. */
+class FixedPointPolynomial
+{
+public:
+
+	FixedPointPolynomial(const std::vector<double> &coefficients,
+		FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+		FixedPointFormat accFormat, FixedPointFormat outputFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	unsigned int order(void) const { return m_coefs.size() - 1; }
+	FixedPointFormat inputFormat(void) const { return m_inputFormat; }
+	FixedPointFormat outputFormat(void) const { return m_outputFormat; }
+
+	FixedPoint evaluate(const FixedPoint &x) const;
+	void evaluate(const std::int64_t *x, std::int64_t *y, std::size_t n) const;
+
+private:
+
+	std::vector<std::int64_t> m_coefs;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_accFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+};
+
+/* Segmented polynomial with 2^segmentBits segments. The segmentBits MSBs of
+ * the input (in offset binary, so segment 0 holds the most negative values)
+ * select a segment, and that segment's polynomial is evaluated at the local
+ * offset t in [0, 1) formed by the remaining input bits, exactly as a ROM
+ * addressed by the MSBs followed by a Horner datapath would. Batch
+ * evaluation gathers each sample's coefficients from one flat table. */
+class PiecewisePolynomial
+{
+public:
+
+	PiecewisePolynomial(const std::vector<std::vector<double> > &segments,
+		unsigned int segmentBits, FixedPointFormat inputFormat,
+		FixedPointFormat coefFormat, FixedPointFormat accFormat,
+		FixedPointFormat outputFormat, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	/* Per-segment coefficients (in t) interpolating f at Chebyshev nodes */
+	static std::vector<std::vector<double> > fit(
+		const std::function<double(double)> &f, FixedPointFormat inputFormat,
+		unsigned int segmentBits, unsigned int order);
+
+	unsigned int order(void) const { return m_order; }
+	unsigned int segmentBits(void) const { return m_segmentBits; }
+	FixedPointFormat inputFormat(void) const { return m_inputFormat; }
+	FixedPointFormat outputFormat(void) const { return m_outputFormat; }
+
+	FixedPoint evaluate(const FixedPoint &x) const;
+	void evaluate(const std::int64_t *x, std::int64_t *y, std::size_t n) const;
+
+private:
+
+	std::vector<std::int64_t> m_coefs;
+	unsigned int m_order;
+	unsigned int m_segmentBits;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_accFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+};
+
+#endif
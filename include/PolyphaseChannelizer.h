@@ -0,0 +1,80 @@
+#ifndef POLYPHASE_CHANNELIZER_H
+#define POLYPHASE_CHANNELIZER_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FixedPointFft.h"
+#include "Multichannel.h"
+#include "Quantization.h"
+
+/* Uniform DFT filter bank splitting a complex stream into M channels, each
+ * produced every D input samples with D = M (critically sampled) or
+ * D = M / 2 (2x oversampled). For output frame m,
+ *
+ *   v_p[m] = sum_l h[lM + p] x[(m + 1) D - 1 - lM - p]
+ *   y_k[m] = exp(-j 2 pi k m D / M) sum_p v_p[m] exp(j 2 pi k p / M)
+ *
+ * so channel k is the band centred on 2 pi k / M, filtered by the
+ * prototype h and brought to baseband. The stages are:
+ *
+ *   commutator and polyphase branches: exact sums of input x coefFormat
+ *       products, rounded into branchFormat
+ *   M point inverse FFT in branchFormat with twiddleFormat twiddles and
+ *       the given scale schedule (see FixedPointFft)
+ *   the (-1)^km rotation of the oversampled bank, then requantization to
+ *       outputFormat
+ *
+ * Frames are processed in blocks small enough to stay in cache, with the
+ * branch outputs of a block laid out so the branch filters and the FFT
+ * run across frames. */
+class PolyphaseChannelizer
+{
+public:
+
+	PolyphaseChannelizer(unsigned int numChannels,
+		const std::vector<double> &prototype, bool oversampled,
+		FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+		FixedPointFormat branchFormat, FixedPointFormat twiddleFormat,
+		FixedPointFormat outputFormat,
+		unsigned int fftScaleSchedule = FixedPointFft::SCALE_ALL,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	unsigned int numChannels(void) const { return m_numChannels; }
+	/* Input samples per output frame */
+	unsigned int decimation(void) const { return m_decimation; }
+	const FixedPointFft &fft(void) const { return m_fft; }
+
+	/* Consume n input samples and append every completed frame to out,
+	 * which must have numChannels() channels in outputFormat. Returns the
+	 * number of frames appended. */
+	std::size_t process(const std::complex<std::int64_t> *in, std::size_t n,
+		ComplexMultichannelBuffer &out);
+	void reset(void);
+
+private:
+
+	unsigned int m_numChannels;
+	unsigned int m_decimation;
+	std::size_t m_tapsPerBranch;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_coefFormat;
+	FixedPointFormat m_branchFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	FixedPointFft m_fft;
+	/* m_branches[p][l] = h[lM + p] */
+	std::vector<std::vector<std::int64_t> > m_branches;
+
+	/* input history followed by samples not yet in a frame */
+	std::vector<std::int64_t> m_inputReal;
+	std::vector<std::int64_t> m_inputImag;
+	std::size_t m_frameCount;
+	std::vector<std::int64_t> m_workReal;
+	std::vector<std::int64_t> m_workImag;
+};
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+/* Width and binary point position of a fixed-point signal, with the same
+ * validity rules as FixedPoint */
+class FixedPointFormat
+{
+public:
+
+	static const int MAX_WIDTH = 64;
+
+	constexpr FixedPointFormat(unsigned int width,
+		unsigned int fractionalBits = 0)
+		: m_width(checkedWidth(width)),
+		m_fracBits(checkedFracBits(fractionalBits, width))
+	{
+	}
+
+	constexpr unsigned int width(void) const { return m_width; }
+	constexpr unsigned int fracBits(void) const { return m_fracBits; }
+	constexpr std::int64_t minVal(void) const
+	{
+		return (m_width == 64) ? INT64_MIN : -(1LL << (m_width - 1));
+	}
+	constexpr std::int64_t maxVal(void) const
+	{
+		return (m_width == 64) ? INT64_MAX : (1LL << (m_width - 1)) - 1;
+	}
+
+	friend constexpr bool operator == (const FixedPointFormat &lhs,
+		const FixedPointFormat &rhs)
+	{
+		return lhs.m_width == rhs.m_width && lhs.m_fracBits == rhs.m_fracBits;
+	}
+	friend constexpr bool operator != (const FixedPointFormat &lhs,
+		const FixedPointFormat &rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+private:
+
+	unsigned int m_width;
+	unsigned int m_fracBits;
+
+	static constexpr unsigned int checkedWidth(unsigned int width)
+	{
+		return ((width == 0) || (width > MAX_WIDTH))
+			? throw std::range_error("Width outside allowed range")
+			: width;
+	}
+
+	static constexpr unsigned int checkedFracBits(unsigned int fractionalBits,
+		unsigned int width)
+	{
+		return (fractionalBits > width)
+			? throw std::range_error("Fractional bits outside allowed range")
+			: fractionalBits;
+	}
+};
+typedef FixedPointFormat FxpFormat;
+
+/* Exact 2^n for n <= 64, usable in constant expressions */
+constexpr double powerOfTwo(unsigned int n)
+{
+	double result = 1.0;
+	for (unsigned int i = 0; i < n; i++)
+	{
+		result *= 2.0;
+	}
+	return result;
+}
+
+/* floor(v * 2^fracBits + 0.5), the rounding of FixedPoint::quantize. Values
+ * outside the format throw range_error, which is a compile error when
+ * evaluated in a constant expression. */
+constexpr std::int64_t quantizeValue(double v, FixedPointFormat format)
+{
+	double scaled = v * powerOfTwo(format.fracBits()) + 0.5;
+	if (!(scaled >= -9223372036854775808.0 && scaled < 9223372036854775808.0))
+	{
+		throw std::range_error("Values exceed size");
+	}
+
+	std::int64_t result = (std::int64_t)scaled;
+	if ((double)result > scaled)
+	{
+		result--;
+	}
+
+	if (result < format.minVal() || result > format.maxVal())
+	{
+		throw std::range_error("Values exceed size");
+	}
+	return result;
+}
+
+/* How LSBs are removed when the binary point moves left */
+enum RoundingMode
+{
+	ROUND_FLOOR,		/* truncate, as truncateBy() */
+	ROUND_HALF_UP,		/* round half towards +inf, as roundBy() */
+	ROUND_HALF_EVEN,	/* convergent: round half to the even neighbour */
+	ROUND_HALF_AWAY,	/* symmetric: round half away from zero */
+	ROUND_TOWARD_ZERO,	/* truncate the magnitude */
+	ROUND_CEIL			/* towards +inf */
+};
+
+/* What happens to values that do not fit in the destination width */
+enum OverflowMode
+{
+	OVERFLOW_WRAP,		/* keep the LSBs, as two's complement hardware */
+	OVERFLOW_SATURATE	/* clamp to the largest magnitude, as saturateTo() */
+};
+
+/* The kernels below work on raw integer values so batch loops over arrays
+ * stay free of FixedPoint temporaries. */
+
+/* Every mode is floor((v + bias) / 2^numLsbs) for a bias in
+ * [0, 2^numLsbs - 1] that depends only on the sign of v and the parity of
+ * the result, so no mode branches on the value. The bias is 0 when
+ * numLsbs is 0. */
+inline std::uint64_t roundingBias(std::int64_t v, unsigned int numLsbs,
+	RoundingMode mode)
+{
+	std::uint64_t full = (1ULL << numLsbs) - 1;
+	std::uint64_t half = (1ULL << numLsbs) >> 1;
+	std::uint64_t negative = (std::uint64_t)(v >> 63);
+	std::uint64_t odd = (std::uint64_t)(v >> numLsbs) & 0x1;
+	std::uint64_t bias;
+	switch (mode)
+	{
+	case ROUND_HALF_UP: bias = half; break;
+	case ROUND_HALF_EVEN: bias = half - 1 + odd; break;
+	case ROUND_HALF_AWAY: bias = half + negative; break;
+	case ROUND_TOWARD_ZERO: bias = full & negative; break;
+	case ROUND_CEIL: bias = full; break;
+	default: bias = 0; break;
+	}
+	return bias & full;
+}
+
+/* Removes numLsbs (0 to 63) LSBs of v using the given rounding mode. The
+ * bias is added to the removed LSBs only, so only their carry reaches the
+ * result and nothing can overflow. */
+inline std::int64_t roundShift(std::int64_t v, unsigned int numLsbs,
+	RoundingMode mode)
+{
+	std::uint64_t lsbs = (std::uint64_t)v & ((1ULL << numLsbs) - 1);
+	std::uint64_t carry = (lsbs + roundingBias(v, numLsbs, mode)) >> numLsbs;
+	return (v >> numLsbs) + (std::int64_t)carry;
+}
+
+template <RoundingMode MODE>
+inline void roundShiftLoop(const std::int64_t *in, std::int64_t *out,
+	std::size_t count, unsigned int numLsbs)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		out[i] = roundShift(in[i], numLsbs, MODE);
+	}
+}
+
+/* roundShift() over an array; in and out may be the same array. The mode is
+ * resolved once, so each loop body is straight-line code the compiler can
+ * vectorize. */
+inline void roundShiftValues(const std::int64_t *in, std::int64_t *out,
+	std::size_t count, unsigned int numLsbs, RoundingMode mode)
+{
+	switch (mode)
+	{
+	case ROUND_HALF_UP:
+		roundShiftLoop<ROUND_HALF_UP>(in, out, count, numLsbs);
+		break;
+	case ROUND_HALF_EVEN:
+		roundShiftLoop<ROUND_HALF_EVEN>(in, out, count, numLsbs);
+		break;
+	case ROUND_HALF_AWAY:
+		roundShiftLoop<ROUND_HALF_AWAY>(in, out, count, numLsbs);
+		break;
+	case ROUND_TOWARD_ZERO:
+		roundShiftLoop<ROUND_TOWARD_ZERO>(in, out, count, numLsbs);
+		break;
+	case ROUND_CEIL:
+		roundShiftLoop<ROUND_CEIL>(in, out, count, numLsbs);
+		break;
+	default:
+		roundShiftLoop<ROUND_FLOOR>(in, out, count, numLsbs);
+		break;
+	}
+}
+
+/* v / 2^numLsbs rounded, for numLsbs of 64 or more. The quotient lies in
+ * [-0.5, 0.5), reaching -0.5 only for INT64_MIN and 64 LSBs, so the result
+ * is -1, 0 or 1 depending on the mode and the sign of v. */
+inline std::int64_t roundShiftAll(std::int64_t v, unsigned int numLsbs,
+	RoundingMode mode)
+{
+	switch (mode)
+	{
+	case ROUND_FLOOR: return (v < 0) ? -1 : 0;
+	case ROUND_CEIL: return (v > 0) ? 1 : 0;
+	case ROUND_HALF_AWAY: return (v == INT64_MIN && numLsbs == 64) ? -1 : 0;
+	default: return 0;
+	}
+}
+
+/* Moves the binary point of v from fromFracBits to toFracBits. A left shift
+ * of 64 or more bits leaves no bits of v, as in hardware. */
+inline std::int64_t alignValue(std::int64_t v, unsigned int fromFracBits,
+	unsigned int toFracBits, RoundingMode mode)
+{
+	if (toFracBits >= fromFracBits)
+	{
+		unsigned int shift = toFracBits - fromFracBits;
+		return (shift >= 64) ? 0 : (std::int64_t)((std::uint64_t)v << shift);
+	}
+	unsigned int shift = fromFracBits - toFracBits;
+	return (shift >= 64) ? roundShiftAll(v, shift, mode)
+		: roundShift(v, shift, mode);
+}
+
+inline std::int64_t saturateValue(std::int64_t v, unsigned int width)
+{
+	if (width >= 64)
+	{
+		return v;
+	}
+	std::int64_t maxVal = (1LL << (width - 1)) - 1;
+	std::int64_t minVal = -maxVal - 1;
+	return (v > maxVal) ? maxVal : ((v < minVal) ? minVal : v);
+}
+
+inline std::int64_t wrapValue(std::int64_t v, unsigned int width)
+{
+	unsigned int shift = 64 - width;
+	return (std::int64_t)((std::uint64_t)v << shift) >> shift;
+}
+
+inline std::int64_t overflowValue(std::int64_t v, unsigned int width,
+	OverflowMode mode)
+{
+	return (mode == OVERFLOW_SATURATE) ? saturateValue(v, width)
+		: wrapValue(v, width);
+}
+
+/* Moves v from fromFracBits into format in one step: the binary point is
+ * aligned, LSBs rounded off and the result saturated or wrapped to the
+ * format's width. Saturation is decided before a left shift, so the shift
+ * cannot overflow 64 bits. */
+inline std::int64_t resizeValue(std::int64_t v, unsigned int fromFracBits,
+	FixedPointFormat format, RoundingMode rounding, OverflowMode overflow)
+{
+	unsigned int toFracBits = format.fracBits();
+	if (overflow == OVERFLOW_SATURATE && toFracBits > fromFracBits)
+	{
+		/* Past 63 bits any nonzero value saturates */
+		unsigned int shift = toFracBits - fromFracBits;
+		std::int64_t maxIn = (shift >= 64) ? 0 : format.maxVal() >> shift;
+		std::int64_t minIn = (shift >= 64) ? 0 : format.minVal() >> shift;
+		if (v > maxIn)
+		{
+			return format.maxVal();
+		}
+		if (v < minIn)
+		{
+			return format.minVal();
+		}
+	}
+	return overflowValue(alignValue(v, fromFracBits, toFracBits, rounding),
+		format.width(), overflow);
+}
+
+/* resizeValue() over an array; in and out may be the same array */
+inline void resizeValues(const std::int64_t *in, std::int64_t *out,
+	std::size_t count, unsigned int fromFracBits, FixedPointFormat format,
+	RoundingMode rounding, OverflowMode overflow)
+{
+	for (std::size_t i = 0; i < count; i++)
+	{
+		out[i] = resizeValue(in[i], fromFracBits, format, rounding, overflow);
+	}
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+/* Small, fast, deterministic PRNGs for stimulus generation and dither. The
+ * sequences depend only on the seed, so results are reproducible across
+ * platforms and thread counts. */
+
+/* SplitMix64: used to expand a single seed into independent streams */
+inline std::uint64_t splitMix64(std::uint64_t &state)
+{
+	std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* xoshiro256** generator */
+class Xoshiro256
+{
+public:
+
+	explicit Xoshiro256(std::uint64_t seed = 0, std::uint64_t stream = 0)
+	{
+		std::uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+		for (int i = 0; i < 4; i++)
+		{
+			m_s[i] = splitMix64(state);
+		}
+	}
+
+	std::uint64_t next(void)
+	{
+		std::uint64_t result = rotl(m_s[1] * 5, 7) * 9;
+		std::uint64_t t = m_s[1] << 17;
+		m_s[2] ^= m_s[0];
+		m_s[3] ^= m_s[1];
+		m_s[1] ^= m_s[2];
+		m_s[0] ^= m_s[3];
+		m_s[2] ^= t;
+		m_s[3] = rotl(m_s[3], 45);
+		return result;
+	}
+
+	/* Uniform integer in [lo, hi], both inclusive */
+	std::int64_t uniform(std::int64_t lo, std::int64_t hi)
+	{
+		std::uint64_t span = (std::uint64_t)hi - (std::uint64_t)lo;
+		if (span == ~0ULL)
+		{
+			return (std::int64_t)next();
+		}
+		return (std::int64_t)((std::uint64_t)lo + next() % (span + 1));
+	}
+
+	/* Uniform double in [0, 1) */
+	double uniformDouble(void)
+	{
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+private:
+
+	std::uint64_t m_s[4];
+
+	static std::uint64_t rotl(std::uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+};
+
+#endif
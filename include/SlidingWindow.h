@@ -0,0 +1,191 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Multichannel.h"
+#include "Quantization.h"
+
+/* Windowed statistics over lane-interleaved multichannel streams, updated
+ * recursively so the cost per sample does not depend on the window length.
+ * A single stream is a buffer with one channel. Windows start out filled
+ * with zeros, and state carries over between process() calls. Like
+ * MultichannelFir, buffers must have the formats given at construction and
+ * out is resized to the input's length. */
+
+/* Sum of the last windowLength inputs: sum += x[n] - x[n - windowLength].
+ * The accumulator is exactly wide enough for any window of inputs, so the
+ * recursion never drifts; it is rounded once into outputFormat. */
+class MovingSum
+{
+public:
+
+	MovingSum(std::size_t windowLength, unsigned int numChannels,
+		FixedPointFormat inputFormat, FixedPointFormat outputFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	/* inputFormat widened by ceil(log2(windowLength)) bits */
+	static FixedPointFormat accumulatorFormat(FixedPointFormat inputFormat,
+		std::size_t windowLength);
+
+	std::size_t windowLength(void) const { return m_windowLength; }
+	unsigned int numChannels(void) const { return m_numChannels; }
+	FixedPointFormat accumulatorFormat(void) const { return m_accFormat; }
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	std::size_t m_windowLength;
+	unsigned int m_numChannels;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_accFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	/* ring of the last windowLength input frames */
+	std::vector<std::int64_t> m_history;
+	std::size_t m_position;
+	std::vector<std::int64_t> m_sum;
+};
+
+/* Sum of x^2, or of |x|^2 for complex inputs, over the last windowLength
+ * samples. Squares are exact, in twice the input's width and fractional
+ * bits (one bit more for |x|^2), and summed by a MovingSum. */
+class MovingPower
+{
+public:
+
+	MovingPower(std::size_t windowLength, unsigned int numChannels,
+		FixedPointFormat inputFormat, bool isComplex,
+		FixedPointFormat outputFormat, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	static FixedPointFormat squareFormat(FixedPointFormat inputFormat,
+		bool isComplex);
+
+	FixedPointFormat accumulatorFormat(void) const
+	{
+		return m_sum.accumulatorFormat();
+	}
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void process(const ComplexMultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	FixedPointFormat m_inputFormat;
+	bool m_complex;
+	MovingSum m_sum;
+	MultichannelBuffer m_squares;
+};
+
+/* sqrt(power / windowLength), the RMS over the window. The exact power sum
+ * is divided and square-rooted in 128 bits; the root is rounded down and
+ * saturated into outputFormat, which may have at most 32 more fractional
+ * bits than the input. */
+class MovingRms
+{
+public:
+
+	MovingRms(std::size_t windowLength, unsigned int numChannels,
+		FixedPointFormat inputFormat, bool isComplex,
+		FixedPointFormat outputFormat);
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void process(const ComplexMultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	std::size_t m_windowLength;
+	MovingPower m_power;
+	FixedPointFormat m_outputFormat;
+	int m_shift;
+	MultichannelBuffer m_sums;
+
+	void root(MultichannelBuffer &out, const MultichannelEngine &engine) const;
+};
+
+enum PeakMode
+{
+	PEAK_MAX,
+	PEAK_MIN,
+	PEAK_ABS	/* largest magnitude, saturated into the format */
+};
+
+/* Largest (or smallest) input of the last windowLength samples. Each
+ * channel keeps a monotonic deque of candidates: a new sample evicts every
+ * candidate it dominates and the front expires after windowLength samples,
+ * so each sample is pushed and popped at most once. Output has the input's
+ * format. */
+class SlidingPeak
+{
+public:
+
+	SlidingPeak(std::size_t windowLength, unsigned int numChannels,
+		FixedPointFormat format, PeakMode mode = PEAK_MAX);
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	std::size_t m_windowLength;
+	unsigned int m_numChannels;
+	FixedPointFormat m_format;
+	PeakMode m_mode;
+	/* samples seen */
+	std::uint64_t m_count;
+	/* per channel ring of (sample index, key), lane-interleaved by slot */
+	std::vector<std::uint64_t> m_index;
+	std::vector<std::int64_t> m_key;
+	std::vector<std::size_t> m_head;
+	std::vector<std::size_t> m_size;
+};
+
+/* Exponential average with alpha = 2^-shift, as a leaky integrator
+ *
+ *   acc += x[n] - round(acc / 2^shift),   y[n] = acc / 2^shift
+ *
+ * acc holds y with shift extra fractional bits and one guard bit, so the
+ * only quantization inside the loop is the feedback term; y is rounded into
+ * outputFormat. */
+class ExponentialAverage
+{
+public:
+
+	ExponentialAverage(unsigned int shift, unsigned int numChannels,
+		FixedPointFormat inputFormat, FixedPointFormat outputFormat,
+		RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	FixedPointFormat accumulatorFormat(void) const { return m_accFormat; }
+
+	void process(const MultichannelBuffer &in, MultichannelBuffer &out,
+		const MultichannelEngine &engine = MultichannelEngine());
+	void reset(void);
+
+private:
+
+	unsigned int m_shift;
+	unsigned int m_numChannels;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_accFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	std::vector<std::int64_t> m_acc;
+};
+
+#endif
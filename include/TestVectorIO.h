@@ -0,0 +1,89 @@
+#ifndef TEST_VECTOR_IO_H
+#define TEST_VECTOR_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "FixedPoint.h"
+#include "ComplexFixedPoint.h"
+
+/* Text encodings understood by HDL simulators. Hex and binary hold the
+ * two's complement bit pattern of the declared width, zero padded, as read
+ * by $readmemh/$readmemb; decimal holds the signed integer value. */
+enum TestVectorFormat
+{
+	TV_HEX,
+	TV_BINARY,
+	TV_DECIMAL
+};
+
+/* Writes raw integer values, one line per sample. Complex samples are
+ * written as "real imag" on one line. Output is staged in a large buffer
+ * and handed to the OS in big blocks. */
+class TestVectorWriter
+{
+public:
+
+	static const std::size_t BUFFER_SIZE = 1 << 20;
+
+	TestVectorWriter(const std::string &path, TestVectorFormat format,
+		unsigned int width);
+	~TestVectorWriter();
+
+	void write(std::int64_t v);
+	void write(const Fxp &v);
+	void write(const CFxp &v);
+	void write(const std::int64_t *v, std::size_t n);
+	void flush(void);
+
+private:
+
+	std::FILE *m_file;
+	TestVectorFormat m_format;
+	unsigned int m_width;
+	std::vector<char> m_buffer;
+	std::size_t m_used;
+
+	TestVectorWriter(const TestVectorWriter &);
+	TestVectorWriter &operator = (const TestVectorWriter &);
+
+	void append(std::int64_t v);
+	void endLine(void);
+	void reserve(std::size_t n);
+};
+
+/* Reads a test vector file of the given format and width. The file is
+ * memory mapped and split into newline-aligned chunks that are parsed in
+ * parallel. Blank lines and // comments are ignored; a line may hold several
+ * whitespace separated values, which are returned in file order. */
+class TestVectorReader
+{
+public:
+
+	TestVectorReader(const std::string &path, TestVectorFormat format,
+		unsigned int width);
+	~TestVectorReader();
+
+	std::vector<std::int64_t> readRaw(unsigned int numThreads = 0) const;
+	std::vector<Fxp> readFixedPoint(unsigned int fractionalBits,
+		unsigned int numThreads = 0) const;
+	std::vector<CFxp> readComplexFixedPoint(unsigned int fractionalBits,
+		unsigned int numThreads = 0) const;
+
+private:
+
+	TestVectorFormat m_format;
+	unsigned int m_width;
+	const char *m_data;
+	std::size_t m_size;
+
+	TestVectorReader(const TestVectorReader &);
+	TestVectorReader &operator = (const TestVectorReader &);
+
+	void parseChunk(const char *begin, const char *end,
+		std::vector<std::int64_t> &out) const;
+};
+
+#endif
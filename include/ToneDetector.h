@@ -0,0 +1,143 @@
+#ifndef TONE_DETECTOR_H
+#define TONE_DETECTOR_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* Banks of single-bin DFTs for tone and pilot detection. The K bins of a
+ * bank are its lanes: all per-bin state is stored bin-contiguous and every
+ * loop inside a sample runs across bins. Bins of output r are appended at
+ * out[r * numBins() + k]. Coefficients are quantized through the
+ * CoefficientCache, so banks built from the same frequencies share them. */
+
+/* Goertzel resonators over blocks of blockLength samples:
+ *
+ *   s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+ *   X    = exp(jw) s[N-1] - s[N-2]
+ *
+ * with w = 2 pi frequency, frequencies in cycles per sample. For bins on
+ * the N-point grid (frequency = k / N) X is the DFT bin of the block; off
+ * the grid its magnitude is that of the DTFT at w. Each feedback product
+ * is rounded to the state LSB and wrapped or saturated to stateFormat, as
+ * a hardware resonator would; X is exact and rounded into outputFormat.
+ * coefFormat must hold 2 cos(w), so it needs two integer bits. State
+ * resets after every block. */
+class GoertzelBank
+{
+public:
+
+	GoertzelBank(const std::vector<double> &frequencies,
+		std::size_t blockLength, FixedPointFormat inputFormat,
+		FixedPointFormat coefFormat, FixedPointFormat stateFormat,
+		FixedPointFormat outputFormat, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	std::size_t numBins(void) const { return m_numBins; }
+	std::size_t blockLength(void) const { return m_blockLength; }
+	FixedPointFormat outputFormat(void) const { return m_outputFormat; }
+
+	/* Append the bins of every block completed by n more input samples;
+	 * return the number of blocks */
+	std::size_t process(const std::int64_t *in, std::size_t n,
+		std::vector<std::complex<std::int64_t> > &out);
+	std::size_t process(const std::complex<std::int64_t> *in, std::size_t n,
+		std::vector<std::complex<std::int64_t> > &out);
+	/* One sample; returns true and sets bins when it completes a block */
+	bool process(const FixedPoint &x, std::vector<ComplexFixedPoint> &bins);
+	bool process(const ComplexFixedPoint &x,
+		std::vector<ComplexFixedPoint> &bins);
+	void reset(void);
+
+private:
+
+	std::size_t m_numBins;
+	std::size_t m_blockLength;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_coefFormat;
+	FixedPointFormat m_stateFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	/* 2 cos(w), cos(w) and sin(w) per bin */
+	std::vector<std::int64_t> m_feedback;
+	std::vector<std::int64_t> m_cos;
+	std::vector<std::int64_t> m_sin;
+	/* s[n-1] and s[n-2] per bin, real and imaginary planes */
+	std::vector<std::int64_t> m_s1Real;
+	std::vector<std::int64_t> m_s2Real;
+	std::vector<std::int64_t> m_s1Imag;
+	std::vector<std::int64_t> m_s2Imag;
+	std::size_t m_count;
+
+	void step(std::int64_t x, std::int64_t *s1, std::int64_t *s2);
+	void finish(std::complex<std::int64_t> *out);
+};
+
+/* Sliding DFT over the last length samples, updated every sample for bins
+ * k of the length-point grid:
+ *
+ *   S[n] = r exp(j 2 pi k / length) (S[n-1] + x[n] - r^length x[n-length])
+ *
+ * S is the DFT of the window with sample m from the newest weighted by
+ * r^(m+1). The damping r must keep every quantized twiddle strictly inside
+ * the unit circle, so rounding errors decay instead of accumulating; they
+ * stay within about 1 / (1 - r) state LSBs. Quantized twiddles cancel the
+ * oldest sample only to the coefficient precision, so coefFormat should be
+ * well beyond the state's accuracy needs. The comb term is rounded to the
+ * state LSB, each twiddle product is rounded and wrapped or saturated to
+ * stateFormat, and S is rounded into outputFormat. The window starts out
+ * filled with zeros. */
+class SlidingDftBank
+{
+public:
+
+	SlidingDftBank(const std::vector<std::size_t> &bins, std::size_t length,
+		FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+		FixedPointFormat stateFormat, FixedPointFormat outputFormat,
+		double damping, RoundingMode rounding = ROUND_HALF_UP,
+		OverflowMode overflow = OVERFLOW_SATURATE);
+
+	std::size_t numBins(void) const { return m_numBins; }
+	std::size_t length(void) const { return m_length; }
+	FixedPointFormat outputFormat(void) const { return m_outputFormat; }
+
+	/* Append numBins() outputs per input sample */
+	void process(const std::int64_t *in, std::size_t n,
+		std::vector<std::complex<std::int64_t> > &out);
+	void process(const std::complex<std::int64_t> *in, std::size_t n,
+		std::vector<std::complex<std::int64_t> > &out);
+	void process(const FixedPoint &x, std::vector<ComplexFixedPoint> &bins);
+	void process(const ComplexFixedPoint &x,
+		std::vector<ComplexFixedPoint> &bins);
+	void reset(void);
+
+private:
+
+	std::size_t m_numBins;
+	std::size_t m_length;
+	FixedPointFormat m_inputFormat;
+	FixedPointFormat m_coefFormat;
+	FixedPointFormat m_stateFormat;
+	FixedPointFormat m_outputFormat;
+	RoundingMode m_rounding;
+	OverflowMode m_overflow;
+	/* r exp(jw) per bin and r^length */
+	std::vector<std::int64_t> m_twiddleReal;
+	std::vector<std::int64_t> m_twiddleImag;
+	std::int64_t m_comb;
+	std::vector<std::int64_t> m_stateReal;
+	std::vector<std::int64_t> m_stateImag;
+	/* ring of the last length inputs */
+	std::vector<std::complex<std::int64_t> > m_history;
+	std::size_t m_position;
+
+	void step(std::complex<std::int64_t> x,
+		std::complex<std::int64_t> *out);
+};
+
+#endif
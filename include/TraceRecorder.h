@@ -0,0 +1,194 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ComplexFixedPoint.h"
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* Binary trace files of raw fixed-point values, for diffing a bit-true model
+ * against HDL simulation.
+ *
+ * The file is the 8 byte magic "FXPTRC01" followed by records in host byte
+ * order. A signal record is 'S', u32 id, u8 width, u8 fracBits, u8 complex,
+ * u16 name length and the name. A data record is 'D', u32 id, u64 first
+ * sample index, u64 sample stride, u32 count and count raw int64 values, or
+ * count (real, imag) pairs for complex signals. */
+
+/* Which samples of a signal are kept: firstSample, firstSample + decimation
+ * and so on, up to but excluding endSample */
+struct TraceFilter
+{
+	std::uint64_t firstSample;
+	std::uint64_t endSample;
+	std::uint64_t decimation;
+
+	TraceFilter(std::uint64_t first = 0, std::uint64_t end = UINT64_MAX,
+		std::uint64_t step = 1)
+		: firstSample(first),
+		endSample(end),
+		decimation(step)
+	{
+	}
+};
+
+class TraceRecorder;
+
+/* One traced signal. Every record() call counts as one sample, whether or
+ * not the filter keeps it. A signal must be recorded by one thread at a
+ * time: kept samples are staged in the signal's own block without locking,
+ * and only a full block is handed to the recorder's writer thread.
+ * Recording after the recorder is closed throws runtime_error. */
+class TraceSignal
+{
+public:
+
+	static const std::size_t BLOCK_SAMPLES = 4096;
+
+	const std::string &name(void) const { return m_name; }
+	FixedPointFormat format(void) const { return m_format; }
+	bool isComplex(void) const { return m_complex; }
+	/* Samples seen so far, kept or not */
+	std::uint64_t numSamples(void) const { return m_count; }
+
+	/* Raw values in the signal's format */
+	void record(std::int64_t v);
+	void record(std::int64_t re, std::int64_t im);
+	void record(const std::int64_t *v, std::size_t n);
+	/* The value's format must match the signal's */
+	void record(const Fxp &v);
+	void record(const CFxp &v);
+
+private:
+
+	friend class TraceRecorder;
+
+	TraceRecorder &m_recorder;
+	std::uint32_t m_id;
+	std::string m_name;
+	FixedPointFormat m_format;
+	bool m_complex;
+	TraceFilter m_filter;
+	std::uint64_t m_count;
+	std::uint64_t m_next;
+	std::uint64_t m_blockFirst;
+	std::vector<std::int64_t> m_block;
+	std::size_t m_blockSamples;
+
+	TraceSignal(TraceRecorder &recorder, std::uint32_t id,
+		const std::string &name, FixedPointFormat format, bool isComplex,
+		const TraceFilter &filter);
+	TraceSignal(const TraceSignal &);
+	TraceSignal &operator = (const TraceSignal &);
+
+	bool keep(void);
+	void submit(void);
+};
+
+/* Owns the trace file and its writer thread. Signals encode their own
+ * records; the writer thread only writes them, in the order received, so
+ * recording threads never wait on the file. */
+class TraceRecorder
+{
+public:
+
+	TraceRecorder(const std::string &path);
+	~TraceRecorder();
+
+	/* Names must be unique; throws once the recorder is closed */
+	TraceSignal &addSignal(const std::string &name, FixedPointFormat format,
+		bool isComplex = false, const TraceFilter &filter = TraceFilter());
+
+	/* Writes every staged sample. No signal may be recorded meanwhile. */
+	void flush(void);
+	/* Flushes and closes the file; throws if any write failed */
+	void close(void);
+
+private:
+
+	friend class TraceSignal;
+
+	std::FILE *m_file;
+	std::vector<std::unique_ptr<TraceSignal> > m_signals;
+	std::mutex m_mutex;
+	std::condition_variable m_ready;
+	std::condition_variable m_drained;
+	std::deque<std::vector<char> > m_queue;
+	bool m_writing;
+	bool m_stop;
+	bool m_failed;
+	std::thread m_writer;
+
+	TraceRecorder(const TraceRecorder &);
+	TraceRecorder &operator = (const TraceRecorder &);
+
+	void enqueue(std::vector<char> &record);
+	void writerLoop(void);
+};
+
+/* Everything recorded for one signal, sorted by sample index */
+struct TraceSignalData
+{
+	std::string name;
+	FixedPointFormat format;
+	bool isComplex;
+	std::vector<std::uint64_t> samples;
+	/* One value per sample, or (real, imag) pairs */
+	std::vector<std::int64_t> values;
+
+	TraceSignalData(const std::string &signalName, FixedPointFormat fmt,
+		bool complexValues)
+		: name(signalName),
+		format(fmt),
+		isComplex(complexValues)
+	{
+	}
+};
+
+class TraceReader
+{
+public:
+
+	TraceReader(const std::string &path);
+
+	/* In the order they were added */
+	const std::vector<TraceSignalData> &signals(void) const
+	{
+		return m_signals;
+	}
+	/* NULL if there is no such signal */
+	const TraceSignalData *find(const std::string &name) const;
+
+private:
+
+	std::vector<TraceSignalData> m_signals;
+};
+
+struct TraceMismatch
+{
+	bool found;
+	std::string signal;
+	std::uint64_t sample;
+	std::string description;
+	/* Samples compared across all signals */
+	std::uint64_t numCompared;
+};
+
+/* The earliest sample at which a signal of expected differs from the signal
+ * of the same name in actual; ties go to the signal added first. Only
+ * sample indices present in both traces are compared, so traces with
+ * different filters can be diffed. A missing signal or a different format
+ * is a mismatch at sample 0. Signals are compared in parallel. */
+TraceMismatch compareTraces(const TraceReader &expected,
+	const TraceReader &actual, unsigned int numThreads = 0);
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef WORD_LENGTH_OPTIMIZER_H
+#define WORD_LENGTH_OPTIMIZER_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "FixedPoint.h"
+#include "Quantization.h"
+
+/* One signal whose format is searched. Its integer bits (sign included)
+ * are fixed, e.g. from integerBitsFor() applied to the minHeldVal() and
+ * maxHeldVal() seen in a simulation; its fractional bits are searched in
+ * [minFracBits, maxFracBits]. cost weights the signal's width, e.g. by how
+ * many registers or multiplier inputs carry it. */
+struct WordLengthSignal
+{
+	std::string name;
+	unsigned int integerBits;
+	unsigned int minFracBits;
+	unsigned int maxFracBits;
+	double cost;
+
+	WordLengthSignal(const std::string &signalName, unsigned int intBits,
+		unsigned int minFrac, unsigned int maxFrac, double weight = 1.0)
+		: name(signalName),
+		integerBits(intBits),
+		minFracBits(minFrac),
+		maxFracBits(maxFrac),
+		cost(weight)
+	{
+	}
+};
+
+enum AccuracyMetric
+{
+	METRIC_SQNR_DB,		/* at least target dB */
+	METRIC_MAX_ERROR	/* at most target */
+};
+
+struct WordLengthResult
+{
+	std::vector<FixedPointFormat> formats;
+	/* SQNR in dB or max error, as requested */
+	double metric;
+	/* sum of cost * width */
+	double cost;
+	/* bit-true simulations run, cached ones excluded */
+	std::size_t numSimulations;
+};
+
+/* Searches the cheapest format assignment that meets an accuracy target.
+ *
+ * The model is bit-true: given one format per signal and the stimulus,
+ * already quantized to stimulusFormat, it returns its outputs as doubles.
+ * It is called concurrently for different assignments, so it must not
+ * share mutable state between calls. A model that throws range_error, as
+ * FixedPoint does on overflow, counts as failing the target.
+ *
+ * Outputs are compared against a reference: the model run with every
+ * signal at maxFracBits, unless setReference() supplies one. The search
+ * finds each signal's smallest fractional bits with all others at their
+ * maximum (a binary search per signal, signals in parallel), raises the
+ * most effective signals until the combination meets the target, then
+ * removes bits greedily, trying every signal in parallel at each step and
+ * taking the largest saving that still meets the target. Each assignment
+ * is simulated once; results are cached. The search is deterministic and
+ * independent of numThreads. */
+class WordLengthOptimizer
+{
+public:
+
+	typedef std::function<std::vector<double>(
+		const std::vector<FixedPointFormat> &,
+		const std::vector<FixedPoint> &)> Model;
+
+	WordLengthOptimizer(const Model &model,
+		const std::vector<WordLengthSignal> &signals,
+		const std::vector<double> &stimulus, FixedPointFormat stimulusFormat,
+		unsigned int numThreads = 0);
+
+	/* Smallest integer bits, sign included, holding [minVal, maxVal] */
+	static unsigned int integerBitsFor(double minVal, double maxVal);
+
+	void setReference(const std::vector<double> &reference);
+
+	std::vector<FixedPointFormat> formats(
+		const std::vector<unsigned int> &fracBits) const;
+	/* Accuracy of one assignment of fractional bits */
+	double evaluate(const std::vector<unsigned int> &fracBits,
+		AccuracyMetric metric);
+	WordLengthResult optimize(AccuracyMetric metric, double target);
+
+private:
+
+	struct ErrorStats
+	{
+		double signalPower;
+		double noisePower;
+		double maxError;
+	};
+
+	Model m_model;
+	std::vector<WordLengthSignal> m_signals;
+	std::vector<FixedPoint> m_stimulus;
+	unsigned int m_numThreads;
+	std::vector<double> m_reference;
+	bool m_haveReference;
+
+	std::mutex m_mutex;
+	std::map<std::vector<unsigned int>, ErrorStats> m_cache;
+	std::size_t m_numSimulations;
+
+	ErrorStats simulate(const std::vector<unsigned int> &fracBits);
+	std::vector<ErrorStats> simulateAll(
+		const std::vector<std::vector<unsigned int> > &candidates);
+	void ensureReference(void);
+	static double metricValue(const ErrorStats &stats, AccuracyMetric metric);
+	static bool meets(const ErrorStats &stats, AccuracyMetric metric,
+		double target);
+};
+
+#endif
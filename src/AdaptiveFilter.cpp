@@ -0,0 +1,374 @@
+#include "AdaptiveFilter.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+static unsigned int bitsFor(size_t n)
+{
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < n)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+/* Every intermediate below is exact in 63 bits; complex products add one */
+static void checkConfig(const AdaptiveFilterConfig &c, unsigned int extraBits)
+{
+	const FixedPointFormat &data = c.dataFormat;
+	const FixedPointFormat &weight = c.weightFormat;
+	const FixedPointFormat &acc = c.accFormat;
+	const FixedPointFormat &err = c.errorFormat;
+	const FixedPointFormat &step = c.stepFormat;
+
+	if (c.numTaps == 0)
+	{
+		throw range_error("Adaptive filter needs at least one tap");
+	}
+	if (c.stepSize < 0 || c.leakage < 0 || c.epsilon < 0)
+	{
+		throw range_error("Step size, leakage and epsilon must not be negative");
+	}
+	if (acc.fracBits() > data.fracBits() + weight.fracBits()
+		|| weight.fracBits() > data.fracBits() + err.fracBits())
+	{
+		throw range_error("Fractional bits must not grow through the datapath");
+	}
+
+	unsigned int tapBits = bitsFor(c.numTaps) + extraBits;
+	unsigned int common = max(data.fracBits(), acc.fracBits());
+	unsigned int diffWidth = max(data.width() + common - data.fracBits(),
+		acc.width() + common - acc.fracBits()) + 1;
+	if (data.width() + weight.width() + tapBits > 63
+		|| err.width() + data.width() + extraBits > 63
+		|| step.width() + err.width() > 63
+		|| step.width() + weight.width() > 63
+		|| diffWidth > 63
+		|| (c.algorithm == ADAPT_NLMS && 2 * data.width() + tapBits > 63))
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+}
+
+/* d - y, rounded into the error format */
+static int64_t errorValue(int64_t desired, int64_t y,
+	const AdaptiveFilterConfig &c)
+{
+	unsigned int common = max(c.dataFormat.fracBits(), c.accFormat.fracBits());
+	int64_t diff = alignValue(desired, c.dataFormat.fracBits(), common,
+		c.rounding) - alignValue(y, c.accFormat.fracBits(), common, c.rounding);
+	return overflowValue(alignValue(diff, common, c.errorFormat.fracBits(),
+		c.rounding), c.errorFormat.width(), c.overflow);
+}
+
+/* mu e, mu sign(e) or mu e / (epsilon + power) in the error format */
+static int64_t scaledError(int64_t e, int64_t power, int64_t mu,
+	int64_t epsilon, const AdaptiveFilterConfig &c)
+{
+	unsigned int stepFracBits = c.stepFormat.fracBits();
+	int64_t g;
+	if (c.algorithm == ADAPT_SIGN_ERROR)
+	{
+		int64_t sign = (e > 0) - (e < 0);
+		g = alignValue(sign * mu, stepFracBits, c.errorFormat.fracBits(),
+			c.rounding);
+	}
+	else if (c.algorithm == ADAPT_NLMS)
+	{
+		/* power has 2 * data fractional bits; the quotient truncates */
+		__int128 num = (__int128)(mu * e) << (2 * c.dataFormat.fracBits());
+		__int128 q = num / (power + epsilon);
+		const __int128 limit = (__int128)1 << 62;
+		q = (q > limit) ? limit : ((q < -limit) ? -limit : q);
+		g = roundShift((int64_t)q, stepFracBits, c.rounding);
+	}
+	else
+	{
+		g = roundShift(mu * e, stepFracBits, c.rounding);
+	}
+	return overflowValue(g, c.errorFormat.width(), c.overflow);
+}
+
+static void quantizeSteps(const AdaptiveFilterConfig &c, int64_t &mu,
+	int64_t &leak, int64_t &epsilon)
+{
+	mu = quantizeValue(c.stepSize, c.stepFormat);
+	leak = (c.algorithm == ADAPT_LEAKY_LMS)
+		? quantizeValue(c.leakage, c.stepFormat) : 0;
+	epsilon = max(alignValue(quantizeValue(c.epsilon, c.stepFormat),
+		c.stepFormat.fracBits(), 2 * c.dataFormat.fracBits(), c.rounding),
+		(int64_t)1);
+}
+
+AdaptiveFilter::AdaptiveFilter(const AdaptiveFilterConfig &config,
+	const vector<double> &initialWeights)
+	: m_config(config),
+	m_initialWeights(config.numTaps, 0),
+	m_historyLength(config.numTaps + config.updateDelay + 1)
+{
+	checkConfig(config, 0);
+	quantizeSteps(config, m_mu, m_leak, m_epsilon);
+	if (initialWeights.size() > config.numTaps)
+	{
+		throw runtime_error("More initial weights than taps");
+	}
+	for (size_t k = 0; k < initialWeights.size(); k++)
+	{
+		m_initialWeights[k] = quantizeValue(initialWeights[k],
+			config.weightFormat);
+	}
+	reset();
+}
+
+int64_t AdaptiveFilter::process(int64_t x, int64_t desired)
+{
+	int64_t y;
+	process(&x, &desired, &y, NULL, 1);
+	return y;
+}
+
+Fxp AdaptiveFilter::process(const Fxp &x, const Fxp &desired)
+{
+	const FixedPointFormat &data = m_config.dataFormat;
+	if (x.width() != data.width() || x.fracBits() != data.fracBits()
+		|| desired.width() != data.width()
+		|| desired.fracBits() != data.fracBits())
+	{
+		throw runtime_error("Input format does not match adaptive filter");
+	}
+	return Fxp(process(x.val(), desired.val()), m_config.accFormat.width(),
+		m_config.accFormat.fracBits());
+}
+
+void AdaptiveFilter::process(const int64_t *x, const int64_t *desired,
+	int64_t *y, int64_t *error, size_t n)
+{
+	const AdaptiveFilterConfig &c = m_config;
+	size_t numTaps = c.numTaps;
+	size_t length = m_historyLength;
+	unsigned int stepFracBits = c.stepFormat.fracBits();
+	unsigned int updateShift = c.dataFormat.fracBits()
+		+ c.errorFormat.fracBits() - c.weightFormat.fracBits();
+	unsigned int outputShift = c.dataFormat.fracBits()
+		+ c.weightFormat.fracBits() - c.accFormat.fracBits();
+	unsigned int weightWidth = c.weightFormat.width();
+	int64_t leak = m_leak;
+	int64_t *w = &m_weights[0];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		m_history[m_pos] = x[i];
+		m_history[m_pos + length] = x[i];
+
+		/* window[-k] = x[n-k], past[-k] = x[n-1-delay-k] */
+		const int64_t *window = &m_history[m_pos + length];
+		const int64_t *past = window - 1 - c.updateDelay;
+		int64_t g = m_gains[m_gainPos];
+
+		int64_t sum = 0;
+		for (size_t k = 0; k < numTaps; k++)
+		{
+			int64_t updated = w[k] - roundShift(w[k] * leak, stepFracBits,
+				c.rounding) + roundShift(g * past[-(ptrdiff_t)k], updateShift,
+				c.rounding);
+			w[k] = overflowValue(updated, weightWidth, c.overflow);
+			sum += w[k] * window[-(ptrdiff_t)k];
+		}
+
+		int64_t power = 0;
+		if (c.algorithm == ADAPT_NLMS)
+		{
+			for (size_t k = 0; k < numTaps; k++)
+			{
+				power += window[-(ptrdiff_t)k] * window[-(ptrdiff_t)k];
+			}
+		}
+
+		int64_t out = overflowValue(roundShift(sum, outputShift, c.rounding),
+			c.accFormat.width(), c.overflow);
+		m_error = errorValue(desired[i], out, c);
+		m_gains[m_gainPos] = scaledError(m_error, power, m_mu, m_epsilon, c);
+		m_gainPos = (m_gainPos + 1) % m_gains.size();
+		m_pos = (m_pos + 1) % length;
+
+		if (y)
+		{
+			y[i] = out;
+		}
+		if (error)
+		{
+			error[i] = m_error;
+		}
+	}
+}
+
+void AdaptiveFilter::reset(void)
+{
+	m_weights = m_initialWeights;
+	m_history.assign(2 * m_historyLength, 0);
+	m_pos = 0;
+	m_gains.assign(m_config.updateDelay + 1, 0);
+	m_gainPos = 0;
+	m_error = 0;
+}
+
+ComplexAdaptiveFilter::ComplexAdaptiveFilter(
+	const AdaptiveFilterConfig &config,
+	const vector<complex<double> > &initialWeights)
+	: m_config(config),
+	m_initialReal(config.numTaps, 0),
+	m_initialImag(config.numTaps, 0),
+	m_historyLength(config.numTaps + config.updateDelay + 1)
+{
+	checkConfig(config, 1);
+	quantizeSteps(config, m_mu, m_leak, m_epsilon);
+	if (initialWeights.size() > config.numTaps)
+	{
+		throw runtime_error("More initial weights than taps");
+	}
+	for (size_t k = 0; k < initialWeights.size(); k++)
+	{
+		m_initialReal[k] = quantizeValue(initialWeights[k].real(),
+			config.weightFormat);
+		m_initialImag[k] = quantizeValue(initialWeights[k].imag(),
+			config.weightFormat);
+	}
+	reset();
+}
+
+complex<int64_t> ComplexAdaptiveFilter::process(complex<int64_t> x,
+	complex<int64_t> desired)
+{
+	complex<int64_t> y;
+	process(&x, &desired, &y, NULL, 1);
+	return y;
+}
+
+CFxp ComplexAdaptiveFilter::process(const CFxp &x, const CFxp &desired)
+{
+	const FixedPointFormat &data = m_config.dataFormat;
+	if (x.width() != data.width() || x.fracBits() != data.fracBits()
+		|| desired.width() != data.width()
+		|| desired.fracBits() != data.fracBits())
+	{
+		throw runtime_error("Input format does not match adaptive filter");
+	}
+	complex<int64_t> y = process((complex<int64_t>)x,
+		(complex<int64_t>)desired);
+	return CFxp(y, m_config.accFormat.width(), m_config.accFormat.fracBits());
+}
+
+void ComplexAdaptiveFilter::process(const complex<int64_t> *x,
+	const complex<int64_t> *desired, complex<int64_t> *y,
+	complex<int64_t> *error, size_t n)
+{
+	const AdaptiveFilterConfig &c = m_config;
+	size_t numTaps = c.numTaps;
+	size_t length = m_historyLength;
+	unsigned int stepFracBits = c.stepFormat.fracBits();
+	unsigned int updateShift = c.dataFormat.fracBits()
+		+ c.errorFormat.fracBits() - c.weightFormat.fracBits();
+	unsigned int outputShift = c.dataFormat.fracBits()
+		+ c.weightFormat.fracBits() - c.accFormat.fracBits();
+	unsigned int weightWidth = c.weightFormat.width();
+	int64_t leak = m_leak;
+	int64_t *wr = &m_weightsReal[0];
+	int64_t *wi = &m_weightsImag[0];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		m_historyReal[m_pos] = x[i].real();
+		m_historyReal[m_pos + length] = x[i].real();
+		m_historyImag[m_pos] = x[i].imag();
+		m_historyImag[m_pos + length] = x[i].imag();
+
+		const int64_t *windowReal = &m_historyReal[m_pos + length];
+		const int64_t *windowImag = &m_historyImag[m_pos + length];
+		const int64_t *pastReal = windowReal - 1 - c.updateDelay;
+		const int64_t *pastImag = windowImag - 1 - c.updateDelay;
+		int64_t gr = m_gainsReal[m_gainPos];
+		int64_t gi = m_gainsImag[m_gainPos];
+
+		int64_t sumReal = 0;
+		int64_t sumImag = 0;
+		for (size_t k = 0; k < numTaps; k++)
+		{
+			/* w += g conj(x) */
+			int64_t xr = pastReal[-(ptrdiff_t)k];
+			int64_t xi = pastImag[-(ptrdiff_t)k];
+			int64_t updatedReal = wr[k] - roundShift(wr[k] * leak, stepFracBits,
+				c.rounding) + roundShift(gr * xr + gi * xi, updateShift,
+				c.rounding);
+			int64_t updatedImag = wi[k] - roundShift(wi[k] * leak, stepFracBits,
+				c.rounding) + roundShift(gi * xr - gr * xi, updateShift,
+				c.rounding);
+			wr[k] = overflowValue(updatedReal, weightWidth, c.overflow);
+			wi[k] = overflowValue(updatedImag, weightWidth, c.overflow);
+
+			int64_t vr = windowReal[-(ptrdiff_t)k];
+			int64_t vi = windowImag[-(ptrdiff_t)k];
+			sumReal += wr[k] * vr - wi[k] * vi;
+			sumImag += wr[k] * vi + wi[k] * vr;
+		}
+
+		int64_t power = 0;
+		if (c.algorithm == ADAPT_NLMS)
+		{
+			for (size_t k = 0; k < numTaps; k++)
+			{
+				int64_t vr = windowReal[-(ptrdiff_t)k];
+				int64_t vi = windowImag[-(ptrdiff_t)k];
+				power += vr * vr + vi * vi;
+			}
+		}
+
+		complex<int64_t> out(
+			overflowValue(roundShift(sumReal, outputShift, c.rounding),
+				c.accFormat.width(), c.overflow),
+			overflowValue(roundShift(sumImag, outputShift, c.rounding),
+				c.accFormat.width(), c.overflow));
+		m_error = complex<int64_t>(
+			errorValue(desired[i].real(), out.real(), c),
+			errorValue(desired[i].imag(), out.imag(), c));
+		m_gainsReal[m_gainPos] = scaledError(m_error.real(), power, m_mu,
+			m_epsilon, c);
+		m_gainsImag[m_gainPos] = scaledError(m_error.imag(), power, m_mu,
+			m_epsilon, c);
+		m_gainPos = (m_gainPos + 1) % m_gainsReal.size();
+		m_pos = (m_pos + 1) % length;
+
+		if (y)
+		{
+			y[i] = out;
+		}
+		if (error)
+		{
+			error[i] = m_error;
+		}
+	}
+}
+
+vector<complex<int64_t> > ComplexAdaptiveFilter::weights(void) const
+{
+	vector<complex<int64_t> > result(m_weightsReal.size());
+	for (size_t k = 0; k < result.size(); k++)
+	{
+		result[k] = complex<int64_t>(m_weightsReal[k], m_weightsImag[k]);
+	}
+	return result;
+}
+
+void ComplexAdaptiveFilter::reset(void)
+{
+	m_weightsReal = m_initialReal;
+	m_weightsImag = m_initialImag;
+	m_historyReal.assign(2 * m_historyLength, 0);
+	m_historyImag.assign(2 * m_historyLength, 0);
+	m_pos = 0;
+	m_gainsReal.assign(m_config.updateDelay + 1, 0);
+	m_gainsImag.assign(m_config.updateDelay + 1, 0);
+	m_gainPos = 0;
+	m_error = 0;
+}
@@ -0,0 +1,242 @@
+#include "AutomaticGainControl.h"
+#include "CoefficientCache.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+/* Fractional bits of the detector metric of one output sample */
+static unsigned int metricFracBits(const AgcConfig &c)
+{
+	return (c.detector == AGC_DETECT_POWER) ? 2 * c.outputFormat.fracBits()
+		: c.outputFormat.fracBits() + 1;
+}
+
+static void checkConfig(const AgcConfig &c, unsigned int intervalBits)
+{
+	if (c.updateInterval == 0 || (c.updateInterval & (c.updateInterval - 1)))
+	{
+		throw range_error("Update interval must be a power of two");
+	}
+	if (c.lutBits == 0 || c.lutBits > 16)
+	{
+		throw range_error("Table index must have 1 to 16 bits");
+	}
+	if (!(c.targetLevel > 0) || !(c.minGain > 0) || c.loopGain < 0
+		|| c.initialGain < c.minGain || c.initialGain > c.maxGain)
+	{
+		throw range_error("Need positive levels and gains within the limits");
+	}
+
+	unsigned int metricWidth = (c.detector == AGC_DETECT_POWER)
+		? 2 * c.outputFormat.width() : c.outputFormat.width() + 2;
+	if (c.inputFormat.width() + c.gainFormat.width() > 63
+		|| metricWidth + intervalBits > 63
+		|| c.loopGainFormat.width() + c.logFormat.width() + 1 > 63
+		|| metricFracBits(c) + intervalBits > c.detectorFormat.fracBits() + 63
+		|| c.gainFormat.fracBits() + 3 > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+}
+
+AutomaticGainControl::AutomaticGainControl(const AgcConfig &config)
+	: m_config(config),
+	m_intervalBits(0)
+{
+	while ((1U << m_intervalBits) < config.updateInterval)
+	{
+		m_intervalBits++;
+	}
+	checkConfig(config, m_intervalBits);
+
+	const FixedPointFormat &logFormat = config.logFormat;
+	m_target = quantizeValue(log2(config.targetLevel), logFormat);
+	m_minLog = quantizeValue(log2(config.minGain), logFormat);
+	m_maxLog = quantizeValue(log2(config.maxGain), logFormat);
+	m_initialLog = quantizeValue(log2(config.initialGain), logFormat);
+	/* The largest gain must fit the gain word */
+	quantizeValue(config.maxGain, config.gainFormat);
+	/* Halving the power error keeps the integrator in amplitude units */
+	m_loopGain = quantizeValue((config.detector == AGC_DETECT_POWER)
+		? config.loopGain / 2 : config.loopGain, config.loopGainFormat);
+
+	size_t entries = ((size_t)1 << config.lutBits) + 1;
+	vector<double> logs(entries);
+	vector<double> exps(entries);
+	for (size_t i = 0; i < entries; i++)
+	{
+		double fraction = (double)i / (entries - 1);
+		logs[i] = log2(1 + fraction);
+		exps[i] = exp2(fraction);
+	}
+	m_logTable = *CoefficientCache::quantize(logs, logFormat);
+	m_expTable = *CoefficientCache::quantize(exps,
+		FixedPointFormat(config.gainFormat.fracBits() + 3,
+			config.gainFormat.fracBits()));
+	reset();
+}
+
+/* log2 of a raw detector value: the leading one gives the integer part and
+ * the next lutBits bits, rounded, index the table */
+int64_t AutomaticGainControl::log2Value(int64_t v) const
+{
+	const AgcConfig &c = m_config;
+	v = max(v, (int64_t)1);
+	unsigned int msb = 63 - __builtin_clzll((uint64_t)v);
+	int64_t mantissa = v - ((int64_t)1 << msb);
+	int64_t index = alignValue(mantissa, msb, c.lutBits, ROUND_HALF_UP);
+	int64_t integer = (int64_t)msb - (int64_t)c.detectorFormat.fracBits();
+	return saturateValue(integer * ((int64_t)1 << c.logFormat.fracBits())
+		+ m_logTable[index], c.logFormat.width());
+}
+
+/* 2^logValue as a raw gain word: the table value for the rounded first
+ * lutBits fractional bits, shifted by the integer part */
+int64_t AutomaticGainControl::exp2Value(int64_t logValue) const
+{
+	const AgcConfig &c = m_config;
+	unsigned int logFracBits = c.logFormat.fracBits();
+	int64_t integer = logValue >> logFracBits;
+	int64_t fraction = logValue - integer * ((int64_t)1 << logFracBits);
+	int64_t mantissa = m_expTable[alignValue(fraction, logFracBits,
+		c.lutBits, ROUND_HALF_UP)];
+
+	if (integer >= 0)
+	{
+		if (integer + c.gainFormat.fracBits() + 2 > 62)
+		{
+			return c.gainFormat.maxVal();
+		}
+		return saturateValue(mantissa << integer, c.gainFormat.width());
+	}
+	if (-integer > 63)
+	{
+		return 0;
+	}
+	return saturateValue(roundShift(mantissa, -integer, c.rounding),
+		c.gainFormat.width());
+}
+
+void AutomaticGainControl::update(void)
+{
+	const AgcConfig &c = m_config;
+	int64_t mean = resizeValue(m_detectorSum,
+		metricFracBits(c) + m_intervalBits, c.detectorFormat, c.rounding,
+		OVERFLOW_SATURATE);
+	int64_t error = m_target - log2Value(mean);
+	int64_t step = roundShift(m_loopGain * error, c.loopGainFormat.fracBits(),
+		c.rounding);
+	m_log = min(max(m_log + step, m_minLog), m_maxLog);
+	m_gain = exp2Value(m_log);
+	m_detectorSum = 0;
+	m_count = 0;
+}
+
+void AutomaticGainControl::process(const complex<int64_t> *in,
+	complex<int64_t> *out, size_t n)
+{
+	const AgcConfig &c = m_config;
+	unsigned int productFracBits = c.inputFormat.fracBits()
+		+ c.gainFormat.fracBits();
+	bool power = (c.detector == AGC_DETECT_POWER);
+
+	size_t i = 0;
+	while (i < n)
+	{
+		/* The rest of the current interval, at one gain */
+		size_t run = min(n - i, (size_t)c.updateInterval - m_count);
+		const complex<int64_t> *x = in + i;
+		complex<int64_t> *y = out + i;
+		int64_t g = m_gain;
+		for (size_t j = 0; j < run; j++)
+		{
+			y[j] = complex<int64_t>(
+				resizeValue(g * x[j].real(), productFracBits, c.outputFormat,
+					c.rounding, c.overflow),
+				resizeValue(g * x[j].imag(), productFracBits, c.outputFormat,
+					c.rounding, c.overflow));
+		}
+
+		int64_t sum = 0;
+		if (power)
+		{
+			for (size_t j = 0; j < run; j++)
+			{
+				sum += y[j].real() * y[j].real() + y[j].imag() * y[j].imag();
+			}
+		}
+		else
+		{
+			for (size_t j = 0; j < run; j++)
+			{
+				int64_t a = abs(y[j].real());
+				int64_t b = abs(y[j].imag());
+				sum += 2 * max(a, b) + min(a, b);
+			}
+		}
+
+		m_detectorSum += sum;
+		m_count += run;
+		i += run;
+		if (m_count == c.updateInterval)
+		{
+			update();
+		}
+	}
+}
+
+CFxp AutomaticGainControl::process(const CFxp &x)
+{
+	if (x.format() != m_config.inputFormat)
+	{
+		throw runtime_error("Input format does not match AGC");
+	}
+	complex<int64_t> y(x.real(), x.imag());
+	process(&y, &y, 1);
+	return CFxp(y, m_config.outputFormat.width(),
+		m_config.outputFormat.fracBits());
+}
+
+void AutomaticGainControl::process(const vector<CFxp> &in, vector<CFxp> &out)
+{
+	vector<complex<int64_t> > raw(in.size());
+	for (size_t i = 0; i < in.size(); i++)
+	{
+		if (in[i].format() != m_config.inputFormat)
+		{
+			throw runtime_error("Input format does not match AGC");
+		}
+		raw[i] = complex<int64_t>(in[i].real(), in[i].imag());
+	}
+	process(raw.data(), raw.data(), raw.size());
+
+	out.clear();
+	out.reserve(raw.size());
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		out.emplace_back(raw[i], m_config.outputFormat.width(),
+			m_config.outputFormat.fracBits());
+	}
+}
+
+Fxp AutomaticGainControl::gain(void) const
+{
+	return Fxp(m_gain, m_config.gainFormat.width(),
+		m_config.gainFormat.fracBits());
+}
+
+Fxp AutomaticGainControl::logGain(void) const
+{
+	return Fxp(m_log, m_config.logFormat.width(),
+		m_config.logFormat.fracBits());
+}
+
+void AutomaticGainControl::reset(void)
+{
+	m_log = m_initialLog;
+	m_gain = exp2Value(m_log);
+	m_detectorSum = 0;
+	m_count = 0;
+}
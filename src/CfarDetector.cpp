@@ -0,0 +1,285 @@
+#include "CfarDetector.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+static unsigned int bitsFor(size_t n)
+{
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < n)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+/* Training windows of cell r, cut off at the ends of the row: cells
+ * [lagBegin, lagEnd) below r and [leadBegin, leadEnd) above it */
+static void windowBounds(size_t r, size_t numRange, size_t guard,
+	size_t training, size_t &lagBegin, size_t &lagEnd, size_t &leadBegin,
+	size_t &leadEnd)
+{
+	size_t reach = guard + training;
+	lagEnd = (r > guard) ? r - guard : 0;
+	lagBegin = (r > reach) ? r - reach : 0;
+	leadBegin = min(r + guard + 1, numRange);
+	leadEnd = min(r + reach + 1, numRange);
+}
+
+/* sum / n rounded half up, for sums of non-negative cells */
+static int64_t roundedMean(int64_t sum, int64_t n)
+{
+	return (sum >= 0) ? (sum + n / 2) / n : -((-sum + n / 2) / n);
+}
+
+CfarDetector::CfarDetector(const CfarConfig &config, unsigned int numThreads)
+	: m_config(config),
+	m_numThreads(numThreads),
+	m_threshold(0)
+{
+	if (config.trainingCells == 0)
+	{
+		throw range_error("Need at least one training cell");
+	}
+	if (config.method == CFAR_OS
+		&& (config.rank == 0 || config.rank > 2 * config.trainingCells))
+	{
+		throw range_error("Rank must be 1 to the number of training cells");
+	}
+	if (config.threshold < 0)
+	{
+		throw range_error("Threshold must not be negative");
+	}
+
+	/* cell * n * 2^f and threshold * sum of 2 trainingCells cells, and the
+	 * cross products comparing GO and SO window means */
+	unsigned int cellWidth = config.cellFormat.width();
+	unsigned int countBits = bitsFor(2 * config.trainingCells + 1);
+	if (cellWidth + countBits + config.thresholdFormat.fracBits() > 63
+		|| config.thresholdFormat.width() + cellWidth + countBits > 63
+		|| cellWidth + 2 * bitsFor(config.trainingCells + 1) > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+	m_threshold = quantizeValue(config.threshold, config.thresholdFormat);
+}
+
+double CfarDetector::caThreshold(double pfa, unsigned int numTraining)
+{
+	if (!(pfa > 0 && pfa < 1) || numTraining == 0)
+	{
+		throw range_error("Need 0 < pfa < 1 and at least one training cell");
+	}
+	return numTraining * (pow(pfa, -1.0 / numTraining) - 1);
+}
+
+void CfarDetector::windowSums(size_t numRange, Workspace &work) const
+{
+	size_t guard = m_config.guardCells;
+	size_t training = m_config.trainingCells;
+	size_t reach = guard + training;
+	const uint64_t *p = work.prefix.data();
+	int64_t *lag = work.lagSum.data();
+	int64_t *lead = work.leadSum.data();
+	uint32_t *lagCount = work.lagCount.data();
+	uint32_t *leadCount = work.leadCount.data();
+
+	/* Full windows: fixed offsets into the prefix sums */
+	size_t interiorEnd = (numRange > reach) ? numRange - reach : 0;
+	for (size_t r = reach; r < interiorEnd; r++)
+	{
+		lag[r] = (int64_t)(p[r - guard] - p[r - reach]);
+		lead[r] = (int64_t)(p[r + reach + 1] - p[r + guard + 1]);
+		lagCount[r] = training;
+		leadCount[r] = training;
+	}
+
+	/* Windows cut off at either end of the row */
+	size_t edges[2][2] = { { 0, min(reach, numRange) },
+		{ max(reach, interiorEnd), numRange } };
+	for (int e = 0; e < 2; e++)
+	{
+		for (size_t r = edges[e][0]; r < edges[e][1]; r++)
+		{
+			size_t lagBegin, lagEnd, leadBegin, leadEnd;
+			windowBounds(r, numRange, guard, training, lagBegin, lagEnd,
+				leadBegin, leadEnd);
+			lag[r] = (int64_t)(p[lagEnd] - p[lagBegin]);
+			lead[r] = (int64_t)(p[leadEnd] - p[leadBegin]);
+			lagCount[r] = lagEnd - lagBegin;
+			leadCount[r] = leadEnd - leadBegin;
+		}
+	}
+}
+
+void CfarDetector::detectRow(const int64_t *row, size_t numRange,
+	uint32_t doppler, Workspace &work, vector<CfarDetection> &out) const
+{
+	const CfarConfig &c = m_config;
+	int64_t scale = (int64_t)1 << c.thresholdFormat.fracBits();
+	int64_t threshold = m_threshold;
+
+	/* Noise sum and the number of cells behind it, per cell */
+	work.lagSum.resize(numRange);
+	work.lagCount.resize(numRange);
+	int64_t *noise = work.lagSum.data();
+	uint32_t *count = work.lagCount.data();
+
+	if (c.method == CFAR_OS)
+	{
+		size_t guard = c.guardCells;
+		size_t training = c.trainingCells;
+		for (size_t r = 0; r < numRange; r++)
+		{
+			size_t lagBegin, lagEnd, leadBegin, leadEnd;
+			windowBounds(r, numRange, guard, training, lagBegin, lagEnd,
+				leadBegin, leadEnd);
+			work.training.assign(row + lagBegin, row + lagEnd);
+			work.training.insert(work.training.end(), row + leadBegin,
+				row + leadEnd);
+			size_t n = work.training.size();
+			count[r] = (n > 0) ? 1 : 0;
+			if (n == 0)
+			{
+				continue;
+			}
+			/* rank scaled to the cells left, rounded up */
+			size_t k = max((c.rank * n + 2 * training - 1) / (2 * training),
+				(size_t)1);
+			nth_element(work.training.begin(), work.training.begin() + k - 1,
+				work.training.end());
+			noise[r] = work.training[k - 1];
+		}
+	}
+	else
+	{
+		work.prefix.resize(numRange + 1);
+		work.leadSum.resize(numRange);
+		work.leadCount.resize(numRange);
+		uint64_t *p = work.prefix.data();
+		p[0] = 0;
+		for (size_t r = 0; r < numRange; r++)
+		{
+			p[r + 1] = p[r] + (uint64_t)row[r];
+		}
+		windowSums(numRange, work);
+
+		const int64_t *lead = work.leadSum.data();
+		const uint32_t *leadCount = work.leadCount.data();
+		for (size_t r = 0; r < numRange; r++)
+		{
+			int64_t lagSum = noise[r];
+			int64_t lagN = count[r];
+			int64_t leadN = leadCount[r];
+			bool useLag;
+			switch (c.method)
+			{
+			case CFAR_GO:
+				/* lagSum / lagN >= lead / leadN, unless a side is empty */
+				useLag = (leadN == 0)
+					|| (lagN != 0 && lagSum * leadN >= lead[r] * lagN);
+				break;
+			case CFAR_SO:
+				useLag = (leadN == 0)
+					|| (lagN != 0 && lagSum * leadN <= lead[r] * lagN);
+				break;
+			default:
+				noise[r] = lagSum + lead[r];
+				count[r] = lagN + leadN;
+				continue;
+			}
+			noise[r] = useLag ? lagSum : lead[r];
+			count[r] = useLag ? lagN : leadN;
+		}
+	}
+
+	for (size_t r = 0; r < numRange; r++)
+	{
+		int64_t n = count[r];
+		if (n != 0 && row[r] * n * scale > threshold * noise[r])
+		{
+			CfarDetection d;
+			d.doppler = doppler;
+			d.range = r;
+			d.cell = row[r];
+			d.noise = roundedMean(noise[r], n);
+			out.push_back(d);
+		}
+	}
+}
+
+vector<CfarDetection> CfarDetector::run(size_t numDoppler, size_t numRange,
+	const function<const int64_t *(Workspace &, size_t, size_t)> &loadTile)
+	const
+{
+	if (numDoppler > UINT32_MAX || numRange > UINT32_MAX)
+	{
+		throw range_error("Map exceeds 2^32 cells per dimension");
+	}
+
+	unsigned int numThreads = m_numThreads ? m_numThreads
+		: defaultThreadCount();
+	vector<vector<CfarDetection> > found(numThreads);
+	parallelFor(0, numDoppler, [&](size_t begin, size_t end, unsigned int t)
+	{
+		Workspace work;
+		for (size_t first = begin; first < end; first += TILE_ROWS)
+		{
+			size_t rows = min((size_t)TILE_ROWS, end - first);
+			const int64_t *tile = loadTile(work, first, rows);
+			for (size_t i = 0; i < rows; i++)
+			{
+				detectRow(tile + i * numRange, numRange, first + i, work,
+					found[t]);
+			}
+		}
+	}, numThreads);
+
+	vector<CfarDetection> detections;
+	for (size_t t = 0; t < found.size(); t++)
+	{
+		detections.insert(detections.end(), found[t].begin(), found[t].end());
+	}
+	return detections;
+}
+
+vector<CfarDetection> CfarDetector::detect(const int64_t *cells,
+	size_t numDoppler, size_t numRange) const
+{
+	return run(numDoppler, numRange,
+		[&](Workspace &, size_t first, size_t) -> const int64_t *
+	{
+		return cells + first * numRange;
+	});
+}
+
+vector<CfarDetection> CfarDetector::detect(const complex<int64_t> *cells,
+	size_t numDoppler, size_t numRange, FixedPointFormat inputFormat) const
+{
+	if (2 * inputFormat.width() + 1 > 63)
+	{
+		throw range_error("Squares exceed 63 bits");
+	}
+	const CfarConfig &c = m_config;
+	unsigned int fracBits = 2 * inputFormat.fracBits();
+
+	return run(numDoppler, numRange,
+		[&](Workspace &work, size_t first, size_t rows) -> const int64_t *
+	{
+		size_t n = rows * numRange;
+		const complex<int64_t> *x = cells + first * numRange;
+		work.tile.resize(n);
+		int64_t *y = work.tile.data();
+		for (size_t i = 0; i < n; i++)
+		{
+			int64_t re = x[i].real();
+			int64_t im = x[i].imag();
+			y[i] = resizeValue(re * re + im * im, fracBits, c.cellFormat,
+				c.rounding, c.overflow);
+		}
+		return y;
+	});
+}
@@ -0,0 +1,47 @@
+#include "CoefficientCache.h"
+#include "FixedPoint.h"
+#include <map>
+#include <mutex>
+#include <utility>
+
+using namespace std;
+
+typedef pair<pair<unsigned int, unsigned int>, vector<double> > CacheKey;
+
+static mutex s_mutex;
+static map<CacheKey, CoefficientTable> s_tables;
+
+CoefficientTable CoefficientCache::quantize(const vector<double> &values,
+	FixedPointFormat format)
+{
+	CacheKey key(make_pair(format.width(), format.fracBits()), values);
+
+	lock_guard<mutex> lock(s_mutex);
+	map<CacheKey, CoefficientTable>::iterator it = s_tables.find(key);
+	if (it != s_tables.end())
+	{
+		return it->second;
+	}
+
+	vector<int64_t> *table = new vector<int64_t>(values.size());
+	CoefficientTable result(table);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		(*table)[i] = Fxp::quantize(values[i], format.width(),
+			format.fracBits()).val();
+	}
+	s_tables[key] = result;
+	return result;
+}
+
+size_t CoefficientCache::size(void)
+{
+	lock_guard<mutex> lock(s_mutex);
+	return s_tables.size();
+}
+
+void CoefficientCache::clear(void)
+{
+	lock_guard<mutex> lock(s_mutex);
+	s_tables.clear();
+}
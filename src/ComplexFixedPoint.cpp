@@ -1,4 +1,5 @@
 #include "ComplexFixedPoint.h"
+#include "Quantization.h"
 #include <algorithm>
 
 using namespace std;
@@ -30,10 +31,10 @@ CFxp::ComplexFixedPoint(complex<int64_t> c, unsigned int width,
 CFxp CFxp::quantize(complex<double> c, unsigned int width, 
 	unsigned int fractionalBits)
 {
-	double multiplier = pow(2.0, fractionalBits);
+	FixedPointFormat format(width, fractionalBits);
 	return CFxp(
-		(int64_t)floor(c.real() * multiplier + 0.5),
-		(int64_t)floor(c.imag() * multiplier + 0.5),
+		quantizeValue(c.real(), format),
+		quantizeValue(c.imag(), format),
 		width, fractionalBits
 	);
 }
@@ -68,6 +69,11 @@ CFxp operator + (const CFxp &lhs, const CFxp &rhs)
 	int fracBitsDifference = rhs.m_fracBits - lhs.m_fracBits;
 	int sumFracBits = max(rhs.m_fracBits, lhs.m_fracBits);
 	int sumWidth = max(lhs.m_width, rhs.m_width) + 1 + abs(fracBitsDifference);
+	if (sumWidth > CFxp::MAX_WIDTH)
+	{
+		throw range_error("Width outside allowed range");
+	}
+
 	if (fracBitsDifference > 0)
 	{
 		sum = (complex<int64_t>)lhs * (int64_t)(1LL << fracBitsDifference) 
@@ -84,20 +90,32 @@ CFxp operator + (const CFxp &lhs, const CFxp &rhs)
 
 CFxp operator * (const CFxp &lhs, const FixedPoint &rhs)
 {
+	if (lhs.width() + rhs.width() > CFxp::MAX_WIDTH)
+	{
+		throw range_error("Width outside allowed range");
+	}
 	return CFxp((complex<int64_t>)lhs * rhs.val(), 
 		lhs.width() + rhs.width(), lhs.fracBits() + rhs.fracBits());
 }
 
 CFxp operator * (const FixedPoint &lhs, const CFxp &rhs)
 {
+	if (lhs.width() + rhs.width() > CFxp::MAX_WIDTH)
+	{
+		throw range_error("Width outside allowed range");
+	}
 	return CFxp((complex<int64_t>)rhs * lhs.val(), 
 		lhs.width() + rhs.width(), lhs.fracBits() + rhs.fracBits());
 }
 
 CFxp operator * (const CFxp &lhs, const CFxp &rhs)
 {
-	complex<int64_t> product = (complex<int64_t>)lhs * (complex<int64_t>)rhs;
 	int productWidth = lhs.m_width + rhs.m_width + 1;
+	if (productWidth > CFxp::MAX_WIDTH)
+	{
+		throw range_error("Width outside allowed range");
+	}
+	complex<int64_t> product = (complex<int64_t>)lhs * (complex<int64_t>)rhs;
 	int productFracBits = lhs.m_fracBits + rhs.m_fracBits;
 	return CFxp(product, productWidth, productFracBits);
 }
@@ -128,7 +146,7 @@ CFxp &CFxp::truncateTo(unsigned int newWidth)
 
 CFxp &CFxp::saturateTo(unsigned int newWidth)
 {
-	if ((newWidth <= 0) || (newWidth > m_width))
+	if ((newWidth <= 0) || (newWidth > m_width) || (newWidth < m_fracBits))
 	{
 		throw range_error("Saturation width out of range");
 	}
@@ -161,18 +179,27 @@ CFxp &CFxp::saturateBy(unsigned int numMsbsToRemove)
 	return saturateTo(m_width - numMsbsToRemove);
 }
 
-CFxp &CFxp::roundBy(unsigned int numLsbsToRemove)
+CFxp &CFxp::roundBy(unsigned int numLsbsToRemove, RoundingMode mode)
 {
 	if (numLsbsToRemove >= m_width)
 	{
 		throw range_error("Round width out of range");
 	}
 
-	int roundUp = (real() >> (numLsbsToRemove - 1)) & 0x1;
-	real((real() >> numLsbsToRemove) + roundUp);
+	if (numLsbsToRemove == 0)
+	{
+		return *this;
+	}
 
-	roundUp = (imag() >> (numLsbsToRemove - 1)) & 0x1;
-	imag((imag() >> numLsbsToRemove) + roundUp);
+	/* Rounding the largest values up can carry into the sign bit */
+	int64_t roundedReal = roundShift(real(), numLsbsToRemove, mode);
+	int64_t roundedImag = roundShift(imag(), numLsbsToRemove, mode);
+	if (max(roundedReal, roundedImag) > (m_maxVal >> numLsbsToRemove))
+	{
+		throw range_error("Rounding overflows width");
+	}
+	real(roundedReal);
+	imag(roundedImag);
 
 	setWidth(m_width - numLsbsToRemove);
 	setFractionalBits(max((int)m_fracBits - (int)numLsbsToRemove, 0));
@@ -180,14 +207,14 @@ CFxp &CFxp::roundBy(unsigned int numLsbsToRemove)
 	return *this;
 }
 
-CFxp &CFxp::roundTo(unsigned int newWidth)
+CFxp &CFxp::roundTo(unsigned int newWidth, RoundingMode mode)
 {
-	return roundBy(m_width - newWidth);
+	return roundBy(m_width - newWidth, mode);
 }
 
 CFxp &CFxp::signExtendBy(unsigned int numMsbsToAdd)
 {
-	if (numMsbsToAdd + m_width > MAX_WIDTH)
+	if (numMsbsToAdd > MAX_WIDTH - m_width)
 	{
 		throw range_error("Sign extend width out of range");
 	}
@@ -201,6 +228,26 @@ CFxp &CFxp::signExtendTo(unsigned int newWidth)
 	return signExtendBy(newWidth - m_width);
 }
 
+CFxp &CFxp::resize(FixedPointFormat newFormat, RoundingMode rounding,
+	OverflowMode overflow)
+{
+	real(resizeValue(real(), m_fracBits, newFormat, rounding, overflow));
+	imag(resizeValue(imag(), m_fracBits, newFormat, rounding, overflow));
+	setWidth(newFormat.width());
+	setFractionalBits(newFormat.fracBits());
+	return *this;
+}
+
+CFxp &CFxp::assign(const CFxp &rhs, RoundingMode rounding,
+	OverflowMode overflow)
+{
+	FixedPointFormat to = format();
+	real(resizeValue(rhs.real(), rhs.m_fracBits, to, rounding, overflow));
+	imag(resizeValue(rhs.imag(), rhs.m_fracBits, to, rounding, overflow));
+	updateMinMaxHeldVals();
+	return *this;
+}
+
 complex<float> CFxp::toFloat(void) const
 {
 	complex<float> result((float)real(), (float)imag());
@@ -215,13 +262,13 @@ complex<double> CFxp::toDouble(void) const
 
 void CFxp::setWidth(unsigned int width)
 {
-	if (width > MAX_WIDTH)
+	if ((width == 0) || (width > MAX_WIDTH))
 	{
 		throw std::range_error("Width outside allowed range");
 	}
 	m_width = width;
-	m_minVal = -(1LL << (width - 1));
-	m_maxVal = (1LL << (width - 1)) - 1;
+	m_minVal = (width == 64) ? INT64_MIN : -(1LL << (width - 1));
+	m_maxVal = (width == 64) ? INT64_MAX : (1LL << (width - 1)) - 1;
 }
 
 void CFxp::setFractionalBits(unsigned int fractionalBits)
@@ -0,0 +1,146 @@
+#include "Dsp48.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+static const size_t BLOCK_SIZE = 256;
+
+Dsp48Slice::Dsp48Slice(const Dsp48Config &config)
+	: m_config(config)
+{
+	if (config.aWidth == 0 || config.bWidth == 0 || config.dWidth == 0
+		|| config.preAddWidth == 0 || config.pWidth == 0
+		|| config.aWidth > 48 || config.dWidth > 48
+		|| config.preAddWidth + config.bWidth > config.pWidth
+		|| config.pWidth > 62)
+	{
+		throw range_error("DSP slice port widths out of range");
+	}
+	reset();
+}
+
+int64_t Dsp48Slice::multiplierInput(int64_t a, int64_t d) const
+{
+	if (!m_config.usePreAdder)
+	{
+		return a;
+	}
+	int64_t sum = m_config.preSubtract ? d - a : d + a;
+	return overflowValue(sum, m_config.preAddWidth, m_config.preAddOverflow);
+}
+
+int64_t Dsp48Slice::multiply(int64_t ad, int64_t b) const
+{
+	return wrapValue(ad, m_config.preAddWidth) * b;
+}
+
+int64_t Dsp48Slice::postAdd(int64_t z, int64_t m) const
+{
+	return overflowValue(z + m, m_config.pWidth, m_config.postAddOverflow);
+}
+
+int64_t Dsp48Slice::clock(int64_t a, int64_t b, int64_t c, int64_t d,
+	int64_t pcin, ZSelect z)
+{
+	int64_t zValue = 0;
+	if (z == Z_C)
+	{
+		zValue = m_c;
+	}
+	else if (z == Z_PCIN)
+	{
+		zValue = wrapValue(pcin, m_config.pWidth);
+	}
+	else if (z == Z_P)
+	{
+		zValue = m_p;
+	}
+
+	m_p = postAdd(zValue, m_m);
+	m_m = multiply(m_ad, m_b2);
+	m_ad = multiplierInput(m_a, m_d);
+	m_a2 = m_a;
+	m_b2 = m_b;
+	m_a = wrapValue(a, m_config.aWidth);
+	m_b = wrapValue(b, m_config.bWidth);
+	m_c = wrapValue(c, m_config.pWidth);
+	m_d = wrapValue(d, m_config.dWidth);
+	return m_p;
+}
+
+void Dsp48Slice::reset(void)
+{
+	m_a = m_b = m_c = m_d = 0;
+	m_a2 = m_ad = m_b2 = m_m = m_p = 0;
+}
+
+Dsp48Chain::Dsp48Chain(const vector<int64_t> &coefficients,
+	const Dsp48Config &config)
+	: m_slice(config),
+	m_coefs(coefficients),
+	m_historyLength(0)
+{
+	if (coefficients.empty())
+	{
+		throw runtime_error("DSP chain needs at least one slice");
+	}
+	for (size_t k = 0; k < coefficients.size(); k++)
+	{
+		if (coefficients[k] != wrapValue(coefficients[k], config.bWidth))
+		{
+			throw range_error("Coefficient does not fit the B port");
+		}
+	}
+	m_historyLength = latency() + numSlices() - 1;
+	reset();
+}
+
+int64_t Dsp48Chain::clock(int64_t x)
+{
+	int64_t y;
+	process(&x, &y, 1);
+	return y;
+}
+
+void Dsp48Chain::process(const int64_t *x, int64_t *y, size_t n)
+{
+	const Dsp48Config &config = m_slice.config();
+	size_t history = m_historyLength;
+	size_t numSlices = m_coefs.size();
+	size_t lag = latency();
+
+	/* Multiplier operands depend on the input alone, so form them once */
+	m_work.resize(history + n);
+	for (size_t i = 0; i < n; i++)
+	{
+		int64_t a = wrapValue(x[i], config.aWidth);
+		m_work[history + i] = wrapValue(m_slice.multiplierInput(a, 0),
+			config.preAddWidth);
+	}
+
+	int64_t acc[BLOCK_SIZE];
+	for (size_t j0 = 0; j0 < n; j0 += BLOCK_SIZE)
+	{
+		size_t m = min(BLOCK_SIZE, n - j0);
+		fill(acc, acc + m, 0);
+		for (size_t k = 0; k < numSlices; k++)
+		{
+			const int64_t *w = &m_work[history + j0 - lag - k];
+			int64_t h = m_coefs[k];
+			for (size_t j = 0; j < m; j++)
+			{
+				acc[j] = m_slice.postAdd(acc[j], w[j] * h);
+			}
+		}
+		copy(acc, acc + m, y + j0);
+	}
+
+	copy(m_work.end() - history, m_work.end(), m_work.begin());
+	m_work.resize(history);
+}
+
+void Dsp48Chain::reset(void)
+{
+	m_work.assign(m_historyLength, 0);
+}
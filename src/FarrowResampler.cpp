@@ -0,0 +1,267 @@
+#include "FarrowResampler.h"
+#include "CoefficientCache.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+static const size_t BLOCK_SIZE = 256;
+
+FarrowResampler::FarrowResampler(double ratio, unsigned int order,
+	FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+	FixedPointFormat accFormat, FixedPointFormat outputFormat,
+	unsigned int muBits, unsigned int phaseBits, RoundingMode rounding,
+	OverflowMode overflow)
+	: m_inputFormat(inputFormat),
+	m_coefFormat(coefFormat),
+	m_accFormat(accFormat),
+	m_outputFormat(outputFormat),
+	m_muBits(muBits),
+	m_phaseBits(phaseBits),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	init(ratio, lagrange(order));
+}
+
+FarrowResampler::FarrowResampler(double ratio,
+	const vector<vector<double> > &coefficients, FixedPointFormat inputFormat,
+	FixedPointFormat coefFormat, FixedPointFormat accFormat,
+	FixedPointFormat outputFormat, unsigned int muBits, unsigned int phaseBits,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_inputFormat(inputFormat),
+	m_coefFormat(coefFormat),
+	m_accFormat(accFormat),
+	m_outputFormat(outputFormat),
+	m_muBits(muBits),
+	m_phaseBits(phaseBits),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	init(ratio, coefficients);
+}
+
+vector<vector<double> > FarrowResampler::lagrange(unsigned int order)
+{
+	if (order == 0 || order > 7)
+	{
+		throw range_error("Lagrange order out of range");
+	}
+
+	unsigned int numTaps = order + 1;
+	int center = order / 2;
+	vector<vector<double> > coefs(numTaps, vector<double>(numTaps, 0.0));
+	for (unsigned int k = 0; k < numTaps; k++)
+	{
+		/* Expand prod_{j != k} (mu - t_j) / (t_k - t_j) in powers of mu */
+		vector<double> poly(1, 1.0);
+		for (unsigned int j = 0; j < numTaps; j++)
+		{
+			if (j == k)
+			{
+				continue;
+			}
+			double tj = (int)j - center;
+			double scale = 1.0 / ((double)k - (double)j);
+			vector<double> next(poly.size() + 1, 0.0);
+			for (size_t m = 0; m < poly.size(); m++)
+			{
+				next[m + 1] += poly[m] * scale;
+				next[m] -= poly[m] * tj * scale;
+			}
+			poly = next;
+		}
+		for (unsigned int m = 0; m < numTaps; m++)
+		{
+			coefs[m][k] = poly[m];
+		}
+	}
+	return coefs;
+}
+
+void FarrowResampler::init(double ratio, const vector<vector<double> > &coefs)
+{
+	if (coefs.empty() || coefs[0].empty())
+	{
+		throw runtime_error("Farrow structure needs at least one branch");
+	}
+	if (m_phaseBits > 48 || m_muBits == 0 || m_muBits > m_phaseBits)
+	{
+		throw range_error("Phase accumulator width out of range");
+	}
+
+	m_numTaps = coefs[0].size();
+	m_delay = m_numTaps - 1 - (m_numTaps - 1) / 2;
+
+	/* Exact branch sums and Horner products must fit 63 bits */
+	unsigned int tapBits = 0;
+	while ((1U << tapBits) < m_numTaps)
+	{
+		tapBits++;
+	}
+	if (m_inputFormat.width() + m_coefFormat.width() + tapBits > 63
+		|| m_accFormat.width() + m_muBits + 1 > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+	if (m_outputFormat.fracBits() > m_accFormat.fracBits()
+		|| m_accFormat.fracBits() > m_inputFormat.fracBits()
+			+ m_coefFormat.fracBits())
+	{
+		throw range_error("Fractional bits must not grow through the datapath");
+	}
+
+	m_coefs.clear();
+	for (size_t m = 0; m < coefs.size(); m++)
+	{
+		if (coefs[m].size() != m_numTaps)
+		{
+			throw runtime_error("All Farrow branches must have the same length");
+		}
+		CoefficientTable table = CoefficientCache::quantize(coefs[m],
+			m_coefFormat);
+		m_coefs.push_back(*table);
+	}
+
+	double step = floor(ratio * pow(2.0, m_phaseBits) + 0.5);
+	if (!(step >= 1.0) || step >= pow(2.0, 62))
+	{
+		throw range_error("Resampling ratio out of range");
+	}
+	m_step = (uint64_t)step;
+	reset();
+}
+
+size_t FarrowResampler::process(const int64_t *in, size_t n,
+	vector<int64_t> &out)
+{
+	size_t numOutputs = schedule(n);
+	size_t first = out.size();
+	out.resize(first + numOutputs);
+	filter(m_history, in, n, numOutputs, out.data() + first);
+	return numOutputs;
+}
+
+size_t FarrowResampler::process(const complex<int64_t> *in, size_t n,
+	vector<complex<int64_t> > &out)
+{
+	size_t numOutputs = schedule(n);
+	size_t first = out.size();
+	out.resize(first + numOutputs);
+
+	/* The parts are filtered one at a time from a split copy of the input */
+	complex<int64_t> *y = out.data() + first;
+	m_partIn.resize(n);
+	m_partOut.resize(numOutputs);
+	for (size_t i = 0; i < n; i++)
+	{
+		m_partIn[i] = in[i].real();
+	}
+	filter(m_history, m_partIn.data(), n, numOutputs, m_partOut.data());
+	for (size_t j = 0; j < numOutputs; j++)
+	{
+		y[j].real(m_partOut[j]);
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		m_partIn[i] = in[i].imag();
+	}
+	filter(m_historyImag, m_partIn.data(), n, numOutputs, m_partOut.data());
+	for (size_t j = 0; j < numOutputs; j++)
+	{
+		y[j].imag(m_partOut[j]);
+	}
+	return numOutputs;
+}
+
+void FarrowResampler::reset(void)
+{
+	m_phase = 0;
+	m_history.assign(m_numTaps - 1, 0);
+	m_historyImag.assign(m_numTaps - 1, 0);
+}
+
+size_t FarrowResampler::schedule(size_t n)
+{
+	const uint64_t one = 1ULL << m_phaseBits;
+	unsigned int muShift = m_phaseBits - m_muBits;
+
+	m_bases.clear();
+	m_mus.clear();
+	for (size_t i = 0; i < n; i++)
+	{
+		/* After input i arrives the window starts at work index i */
+		while (m_phase < one)
+		{
+			m_bases.push_back(i);
+			m_mus.push_back((int64_t)(m_phase >> muShift));
+			m_phase += m_step;
+		}
+		m_phase -= one;
+	}
+	return m_bases.size();
+}
+
+void FarrowResampler::filter(vector<int64_t> &history, const int64_t *in,
+	size_t n, size_t numOutputs, int64_t *out)
+{
+	size_t numTaps = m_numTaps;
+	size_t numBranches = m_coefs.size();
+	unsigned int branchFracBits = m_inputFormat.fracBits()
+		+ m_coefFormat.fracBits();
+	unsigned int accWidth = m_accFormat.width();
+
+	m_work.resize(numTaps - 1 + n);
+	copy(history.begin(), history.end(), m_work.begin());
+	copy(in, in + n, m_work.begin() + (numTaps - 1));
+
+	int64_t sum[BLOCK_SIZE];
+	int64_t acc[BLOCK_SIZE];
+	for (size_t j0 = 0; j0 < numOutputs; j0 += BLOCK_SIZE)
+	{
+		size_t m = min(BLOCK_SIZE, numOutputs - j0);
+		const size_t *base = &m_bases[j0];
+		const int64_t *mu = &m_mus[j0];
+
+		for (size_t b = numBranches; b-- > 0;)
+		{
+			const int64_t *c = &m_coefs[b][0];
+			fill(sum, sum + m, 0);
+			for (size_t k = 0; k < numTaps; k++)
+			{
+				for (size_t j = 0; j < m; j++)
+				{
+					sum[j] += c[k] * m_work[base[j] + k];
+				}
+			}
+
+			for (size_t j = 0; j < m; j++)
+			{
+				int64_t branch = overflowValue(roundShift(sum[j],
+					branchFracBits - m_accFormat.fracBits(), m_rounding),
+					accWidth, m_overflow);
+				if (b == numBranches - 1)
+				{
+					acc[j] = branch;
+				}
+				else
+				{
+					int64_t product = roundShift(acc[j] * mu[j], m_muBits,
+						m_rounding);
+					acc[j] = overflowValue(product + branch, accWidth, m_overflow);
+				}
+			}
+		}
+
+		for (size_t j = 0; j < m; j++)
+		{
+			out[j0 + j] = overflowValue(roundShift(acc[j],
+				m_accFormat.fracBits() - m_outputFormat.fracBits(), m_rounding),
+				m_outputFormat.width(), m_overflow);
+		}
+	}
+
+	copy(m_work.end() - (numTaps - 1), m_work.end(), history.begin());
+}
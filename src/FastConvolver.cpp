@@ -0,0 +1,252 @@
+#include "FastConvolver.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+/* Transform values kept per batch, real and imaginary */
+static const size_t BATCH_VALUES = 16384;
+
+FastConvolver::FastConvolver(const vector<complex<double> > &taps,
+	FastConvolutionMode mode, size_t fftSize, FixedPointFormat inputFormat,
+	FixedPointFormat dataFormat, FixedPointFormat coefFormat,
+	FixedPointFormat twiddleFormat, FixedPointFormat outputFormat,
+	unsigned int forwardSchedule, unsigned int inverseSchedule,
+	FastConvolutionMethod method, RoundingMode rounding,
+	OverflowMode overflow)
+	: m_realTaps(false),
+	m_inputFormat(inputFormat),
+	m_dataFormat(dataFormat),
+	m_coefFormat(coefFormat),
+	m_outputFormat(outputFormat),
+	m_method(method),
+	m_rounding(rounding),
+	m_overflow(overflow),
+	m_forward(fftSize, dataFormat, twiddleFormat, forwardSchedule, false,
+		rounding, overflow),
+	m_inverse(fftSize, dataFormat, twiddleFormat, inverseSchedule, true,
+		rounding, overflow)
+{
+	init(taps, mode);
+}
+
+FastConvolver::FastConvolver(const vector<double> &taps,
+	FastConvolutionMode mode, size_t fftSize, FixedPointFormat inputFormat,
+	FixedPointFormat dataFormat, FixedPointFormat coefFormat,
+	FixedPointFormat twiddleFormat, FixedPointFormat outputFormat,
+	unsigned int forwardSchedule, unsigned int inverseSchedule,
+	FastConvolutionMethod method, RoundingMode rounding,
+	OverflowMode overflow)
+	: m_realTaps(true),
+	m_inputFormat(inputFormat),
+	m_dataFormat(dataFormat),
+	m_coefFormat(coefFormat),
+	m_outputFormat(outputFormat),
+	m_method(method),
+	m_rounding(rounding),
+	m_overflow(overflow),
+	m_forward(fftSize, dataFormat, twiddleFormat, forwardSchedule, false,
+		rounding, overflow),
+	m_inverse(fftSize, dataFormat, twiddleFormat, inverseSchedule, true,
+		rounding, overflow)
+{
+	init(vector<complex<double> >(taps.begin(), taps.end()), mode);
+}
+
+void FastConvolver::init(const vector<complex<double> > &taps,
+	FastConvolutionMode mode)
+{
+	size_t fftSize = m_forward.size();
+	m_numTaps = taps.size();
+	if (m_numTaps == 0 || m_numTaps > fftSize)
+	{
+		throw range_error("Number of taps must be between 1 and the FFT size");
+	}
+	m_blockSize = fftSize - m_numTaps + 1;
+	if (m_dataFormat.width() + m_coefFormat.width() + 1 > 63)
+	{
+		throw range_error("Spectrum products exceed 63 bits");
+	}
+
+	/* The inverse transform has no 1/size, so the result carries a gain of
+	 * size / 2^(scaled stages): fold it into the binary point */
+	int resultFracBits = (int)m_dataFormat.fracBits()
+		+ (int)m_forward.numStages() - (int)m_forward.scaleShift()
+		- (int)m_inverse.scaleShift();
+	if (resultFracBits < 0 || resultFracBits > 63)
+	{
+		throw range_error("FFT scale schedules remove more than the FFT gain");
+	}
+	m_resultFracBits = resultFracBits;
+
+	/* Correlation is convolution with the reversed conjugate taps */
+	vector<complex<double> > g(taps);
+	if (mode == FAST_CORRELATION)
+	{
+		for (size_t k = 0; k < m_numTaps; k++)
+		{
+			g[k] = conj(taps[m_numTaps - 1 - k]);
+		}
+	}
+
+	vector<double> cosTable(fftSize);
+	vector<double> sinTable(fftSize);
+	for (size_t i = 0; i < fftSize; i++)
+	{
+		cosTable[i] = cos(2 * M_PI * i / fftSize);
+		sinTable[i] = -sin(2 * M_PI * i / fftSize);
+	}
+	m_spectrumReal.resize(fftSize);
+	m_spectrumImag.resize(fftSize);
+	for (size_t k = 0; k < fftSize; k++)
+	{
+		complex<double> sum = 0;
+		for (size_t n = 0; n < m_numTaps; n++)
+		{
+			size_t i = (k * n) % fftSize;
+			sum += g[n] * complex<double>(cosTable[i], sinTable[i]);
+		}
+		m_spectrumReal[k] = quantizeValue(sum.real(), m_coefFormat);
+		m_spectrumImag[k] = quantizeValue(sum.imag(), m_coefFormat);
+	}
+	reset();
+}
+
+size_t FastConvolver::history(void) const
+{
+	return (m_method == OVERLAP_SAVE) ? m_numTaps - 1 : 0;
+}
+
+size_t FastConvolver::process(const complex<int64_t> *in, size_t n,
+	vector<complex<int64_t> > &out)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		m_inputReal.push_back(in[i].real());
+		m_inputImag.push_back(in[i].imag());
+	}
+
+	size_t fftSize = m_forward.size();
+	size_t blockSize = m_blockSize;
+	size_t tailLength = m_numTaps - 1;
+	size_t numBlocks = (m_inputReal.size() - history()) / blockSize;
+	size_t maxBatch = max((size_t)1, BATCH_VALUES / fftSize);
+	unsigned int dataWidth = m_dataFormat.width();
+	unsigned int coefFracBits = m_coefFormat.fracBits();
+	size_t first = out.size();
+	out.resize(first + numBlocks * blockSize);
+
+	for (size_t b0 = 0; b0 < numBlocks; b0 += maxBatch)
+	{
+		size_t count = min(maxBatch, numBlocks - b0);
+		m_workReal.assign(fftSize * count, 0);
+		m_workImag.assign(fftSize * count, 0);
+
+		/* Overlap-save takes history plus new samples, overlap-add the new
+		 * samples followed by zeros */
+		size_t length = (m_method == OVERLAP_SAVE) ? fftSize : blockSize;
+		for (size_t b = 0; b < count; b++)
+		{
+			size_t start = (b0 + b) * blockSize;
+			for (size_t i = 0; i < length; i++)
+			{
+				m_workReal[i * count + b] = resizeValue(m_inputReal[start + i],
+					m_inputFormat.fracBits(), m_dataFormat, m_rounding,
+					m_overflow);
+				m_workImag[i * count + b] = resizeValue(m_inputImag[start + i],
+					m_inputFormat.fracBits(), m_dataFormat, m_rounding,
+					m_overflow);
+			}
+		}
+
+		m_forward.transform(&m_workReal[0], &m_workImag[0], count);
+		for (size_t k = 0; k < fftSize; k++)
+		{
+			int64_t hr = m_spectrumReal[k];
+			int64_t hi = m_spectrumImag[k];
+			int64_t *xr = &m_workReal[k * count];
+			int64_t *xi = &m_workImag[k * count];
+			for (size_t b = 0; b < count; b++)
+			{
+				int64_t re = roundShift(xr[b] * hr - xi[b] * hi, coefFracBits,
+					m_rounding);
+				int64_t im = roundShift(xr[b] * hi + xi[b] * hr, coefFracBits,
+					m_rounding);
+				xr[b] = overflowValue(re, dataWidth, m_overflow);
+				xi[b] = overflowValue(im, dataWidth, m_overflow);
+			}
+		}
+		m_inverse.transform(&m_workReal[0], &m_workImag[0], count);
+
+		for (size_t b = 0; b < count; b++)
+		{
+			complex<int64_t> *y = &out[first + (b0 + b) * blockSize];
+			size_t offset = (m_method == OVERLAP_SAVE) ? tailLength : 0;
+			if (m_method == OVERLAP_ADD)
+			{
+				/* Add the previous tail, then keep this block's tail */
+				for (size_t i = 0; i < fftSize; i++)
+				{
+					int64_t tailReal = (i < tailLength) ? m_tailReal[i] : 0;
+					int64_t tailImag = (i < tailLength) ? m_tailImag[i] : 0;
+					m_workReal[i * count + b] = overflowValue(
+						m_workReal[i * count + b] + tailReal, dataWidth, m_overflow);
+					m_workImag[i * count + b] = overflowValue(
+						m_workImag[i * count + b] + tailImag, dataWidth, m_overflow);
+				}
+				for (size_t i = 0; i < tailLength; i++)
+				{
+					m_tailReal[i] = m_workReal[(blockSize + i) * count + b];
+					m_tailImag[i] = m_workImag[(blockSize + i) * count + b];
+				}
+			}
+
+			for (size_t i = 0; i < blockSize; i++)
+			{
+				int64_t vr = m_workReal[(offset + i) * count + b];
+				int64_t vi = m_workImag[(offset + i) * count + b];
+				y[i] = complex<int64_t>(
+					resizeValue(vr, m_resultFracBits, m_outputFormat,
+						m_rounding, m_overflow),
+					resizeValue(vi, m_resultFracBits, m_outputFormat,
+						m_rounding, m_overflow));
+			}
+		}
+	}
+
+	m_inputReal.erase(m_inputReal.begin(),
+		m_inputReal.begin() + numBlocks * blockSize);
+	m_inputImag.erase(m_inputImag.begin(),
+		m_inputImag.begin() + numBlocks * blockSize);
+	return numBlocks * blockSize;
+}
+
+size_t FastConvolver::process(const int64_t *in, size_t n,
+	vector<int64_t> &out)
+{
+	if (!m_realTaps)
+	{
+		throw runtime_error("Real data needs real taps");
+	}
+	vector<complex<int64_t> > x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		x[i] = complex<int64_t>(in[i], 0);
+	}
+	m_result.clear();
+	size_t numOutputs = process(x.data(), n, m_result);
+	for (size_t i = 0; i < numOutputs; i++)
+	{
+		out.push_back(m_result[i].real());
+	}
+	return numOutputs;
+}
+
+void FastConvolver::reset(void)
+{
+	m_inputReal.assign(history(), 0);
+	m_inputImag.assign(history(), 0);
+	m_tailReal.assign(m_numTaps - 1, 0);
+	m_tailImag.assign(m_numTaps - 1, 0);
+}
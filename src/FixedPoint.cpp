@@ -1,4 +1,5 @@
 #include "FixedPoint.h"
+#include "Quantization.h"
 #include <math.h>
 #include <algorithm>
 
@@ -17,9 +18,8 @@ Fxp::FixedPoint(int64_t v, unsigned int width, unsigned int fractionalBits)
 
 Fxp Fxp::quantize(double v, unsigned int width, unsigned int fractionalBits)
 {
-	double multiplier = pow(2.0, fractionalBits);
 	return Fxp(
-		(int64_t)floor(v * multiplier + 0.5),
+		quantizeValue(v, FixedPointFormat(width, fractionalBits)),
 		width, fractionalBits
 	);
 }
@@ -53,6 +53,11 @@ Fxp operator + (const Fxp &lhs, const Fxp &rhs)
 	int fracBitsDifference = rhs.m_fracBits - lhs.m_fracBits;
 	int sumFracBits = max(rhs.m_fracBits, lhs.m_fracBits);
 	int sumWidth = max(lhs.m_width, rhs.m_width) + 1 + abs(fracBitsDifference);
+	if (sumWidth > Fxp::MAX_WIDTH)
+	{
+		throw range_error("Width outside allowed range");
+	}
+
 	if (fracBitsDifference > 0)
 	{
 		sum = lhs.m_val * (1LL << fracBitsDifference) + rhs.m_val;
@@ -67,6 +72,10 @@ Fxp operator + (const Fxp &lhs, const Fxp &rhs)
 
 Fxp operator * (const Fxp &lhs, const Fxp &rhs)
 {
+	if (lhs.m_width + rhs.m_width > Fxp::MAX_WIDTH)
+	{
+		throw range_error("Width outside allowed range");
+	}
 	return Fxp(lhs.m_val * rhs.m_val, lhs.m_width + rhs.m_width, 
 		lhs.m_fracBits + rhs.m_fracBits);
 }
@@ -96,7 +105,7 @@ Fxp &Fxp::truncateTo(unsigned int newWidth)
 
 Fxp &Fxp::saturateTo(unsigned int newWidth)
 {
-	if ((newWidth <= 0) || (newWidth > m_width))
+	if ((newWidth <= 0) || (newWidth > m_width) || (newWidth < m_fracBits))
 	{
 		throw range_error("Saturation width out of range");
 	}
@@ -120,15 +129,25 @@ Fxp &Fxp::saturateBy(unsigned int numMsbsToRemove)
 	return saturateTo(m_width - numMsbsToRemove);
 }
 
-Fxp &Fxp::roundBy(unsigned int numLsbsToRemove)
+Fxp &Fxp::roundBy(unsigned int numLsbsToRemove, RoundingMode mode)
 {
 	if (numLsbsToRemove >= m_width)
 	{
 		throw range_error("Round width out of range");
 	}
 
-	int roundUp = (m_val >> (numLsbsToRemove - 1)) & 0x1;
-	m_val = (m_val >> numLsbsToRemove) + roundUp;
+	if (numLsbsToRemove == 0)
+	{
+		return *this;
+	}
+
+	/* Rounding the largest values up can carry into the sign bit */
+	int64_t rounded = roundShift(m_val, numLsbsToRemove, mode);
+	if (rounded > (m_maxVal >> numLsbsToRemove))
+	{
+		throw range_error("Rounding overflows width");
+	}
+	m_val = rounded;
 
 	setWidth(m_width - numLsbsToRemove);
 	setFractionalBits(max((int)m_fracBits - (int)numLsbsToRemove, 0));
@@ -136,14 +155,14 @@ Fxp &Fxp::roundBy(unsigned int numLsbsToRemove)
 	return *this;
 }
 
-Fxp &Fxp::roundTo(unsigned int newWidth)
+Fxp &Fxp::roundTo(unsigned int newWidth, RoundingMode mode)
 {
-	return roundBy(m_width - newWidth);
+	return roundBy(m_width - newWidth, mode);
 }
 
 Fxp &Fxp::signExtendBy(unsigned int numMsbsToAdd)
 {
-	if (numMsbsToAdd + m_width > MAX_WIDTH)
+	if (numMsbsToAdd > MAX_WIDTH - m_width)
 	{
 		throw range_error("Sign extend width out of range");
 	}
@@ -157,6 +176,23 @@ Fxp &Fxp::signExtendTo(unsigned int newWidth)
 	return signExtendBy(newWidth - m_width);
 }
 
+Fxp &Fxp::resize(FixedPointFormat newFormat, RoundingMode rounding,
+	OverflowMode overflow)
+{
+	m_val = resizeValue(m_val, m_fracBits, newFormat, rounding, overflow);
+	setWidth(newFormat.width());
+	setFractionalBits(newFormat.fracBits());
+	return *this;
+}
+
+Fxp &Fxp::assign(const Fxp &rhs, RoundingMode rounding, OverflowMode overflow)
+{
+	m_val = resizeValue(rhs.m_val, rhs.m_fracBits, format(), rounding,
+		overflow);
+	updateMinMaxHeldVals();
+	return *this;
+}
+
 float Fxp::toFloat(void) const
 {
 	return (float)m_val / (float)pow(2.0, m_fracBits);
@@ -169,13 +205,13 @@ double Fxp::toDouble(void) const
 
 void Fxp::setWidth(unsigned int width)
 {
-	if (width > MAX_WIDTH)
+	if ((width == 0) || (width > MAX_WIDTH))
 	{
 		throw std::range_error("Width outside allowed range");
 	}
 	m_width = width;
-	m_minVal = -(1LL << (width - 1));
-	m_maxVal = (1LL << (width - 1)) - 1;
+	m_minVal = (width == 64) ? INT64_MIN : -(1LL << (width - 1));
+	m_maxVal = (width == 64) ? INT64_MAX : (1LL << (width - 1)) - 1;
 }
 
 void Fxp::setFractionalBits(unsigned int fractionalBits)
@@ -0,0 +1,69 @@
+#include "FixedPointExpression.h"
+
+using namespace std;
+
+FixedPointArray::FixedPointArray(size_t size, FixedPointFormat format)
+	: m_values(size, 0),
+	m_format(format)
+{
+}
+
+FixedPointArray::FixedPointArray(const vector<int64_t> &values,
+	FixedPointFormat format)
+	: m_values(values),
+	m_format(format)
+{
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if (values[i] < format.minVal() || values[i] > format.maxVal())
+		{
+			throw range_error("Values exceed size");
+		}
+	}
+}
+
+FixedPointArray FixedPointArray::quantize(const vector<double> &values,
+	FixedPointFormat format)
+{
+	FixedPointArray result(values.size(), format);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		result.m_values[i] = quantizeValue(values[i], format);
+	}
+	return result;
+}
+
+Fxp FixedPointArray::operator [] (size_t i) const
+{
+	return Fxp(m_values[i], m_format.width(), m_format.fracBits());
+}
+
+void FixedPointArray::set(size_t i, const Fxp &v)
+{
+	if (v.format() != m_format)
+	{
+		throw runtime_error("Size of lhs and rhs of assignment must match");
+	}
+	m_values[i] = v.val();
+}
+
+vector<double> FixedPointArray::toDouble(void) const
+{
+	double scale = 1.0 / powerOfTwo(m_format.fracBits());
+	vector<double> result(m_values.size());
+	for (size_t i = 0; i < m_values.size(); i++)
+	{
+		result[i] = m_values[i] * scale;
+	}
+	return result;
+}
+
+FixedPointArray &FixedPointArray::operator = (const FixedPointArray &rhs)
+{
+	if (rhs.m_format != m_format)
+	{
+		throw runtime_error("Size of lhs and rhs of assignment must match");
+	}
+	m_values = rhs.m_values;
+	return *this;
+}
@@ -0,0 +1,145 @@
+#include "FixedPointFft.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+/* Rounds to the nearest step of the format, clamping instead of throwing so
+ * that +1 saturates */
+static int64_t quantizeTwiddle(double v, FixedPointFormat format)
+{
+	double scaled = floor(v * pow(2.0, format.fracBits()) + 0.5);
+	scaled = max(scaled, (double)format.minVal());
+	scaled = min(scaled, (double)format.maxVal());
+	return (int64_t)scaled;
+}
+
+FixedPointFft::FixedPointFft(size_t size, FixedPointFormat dataFormat,
+	FixedPointFormat twiddleFormat, unsigned int scaleSchedule, bool inverse,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_size(size),
+	m_numStages(0),
+	m_dataFormat(dataFormat),
+	m_twiddleFormat(twiddleFormat),
+	m_scaleSchedule(scaleSchedule),
+	m_scaleShift(0),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	if (size < 2 || (size & (size - 1)) != 0)
+	{
+		throw range_error("FFT size must be a power of two");
+	}
+	while (((size_t)1 << m_numStages) < size)
+	{
+		m_numStages++;
+	}
+	if (dataFormat.width() + twiddleFormat.width() + 1 > 63)
+	{
+		throw range_error("Twiddle products exceed 63 bits");
+	}
+	for (unsigned int s = 0; s < m_numStages; s++)
+	{
+		m_scaleShift += (scaleSchedule >> s) & 0x1;
+	}
+
+	double sign = inverse ? 1.0 : -1.0;
+	m_twiddleReal.resize(size / 2);
+	m_twiddleImag.resize(size / 2);
+	for (size_t i = 0; i < size / 2; i++)
+	{
+		double angle = sign * 2 * M_PI * i / size;
+		m_twiddleReal[i] = quantizeTwiddle(cos(angle), twiddleFormat);
+		m_twiddleImag[i] = quantizeTwiddle(sin(angle), twiddleFormat);
+	}
+
+	m_bitReverse.resize(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		size_t r = 0;
+		for (unsigned int b = 0; b < m_numStages; b++)
+		{
+			r |= ((i >> b) & 0x1) << (m_numStages - 1 - b);
+		}
+		m_bitReverse[i] = r;
+	}
+}
+
+void FixedPointFft::transform(int64_t *real, int64_t *imag, size_t count) const
+{
+	for (size_t i = 0; i < m_size; i++)
+	{
+		size_t j = m_bitReverse[i];
+		if (i < j)
+		{
+			swap_ranges(real + i * count, real + (i + 1) * count, real + j * count);
+			swap_ranges(imag + i * count, imag + (i + 1) * count, imag + j * count);
+		}
+	}
+
+	unsigned int twiddleFracBits = m_twiddleFormat.fracBits();
+	unsigned int width = m_dataFormat.width();
+	for (unsigned int s = 0; s < m_numStages; s++)
+	{
+		size_t half = (size_t)1 << s;
+		size_t step = m_size / (2 * half);
+		unsigned int shift = (m_scaleSchedule >> s) & 0x1;
+
+		for (size_t g = 0; g < m_size; g += 2 * half)
+		{
+			for (size_t k = 0; k < half; k++)
+			{
+				int64_t wr = m_twiddleReal[k * step];
+				int64_t wi = m_twiddleImag[k * step];
+				int64_t *ar = real + (g + k) * count;
+				int64_t *ai = imag + (g + k) * count;
+				int64_t *br = real + (g + k + half) * count;
+				int64_t *bi = imag + (g + k + half) * count;
+
+				for (size_t t = 0; t < count; t++)
+				{
+					int64_t tr = br[t];
+					int64_t ti = bi[t];
+					if (k != 0)
+					{
+						tr = roundShift(br[t] * wr - bi[t] * wi, twiddleFracBits,
+							m_rounding);
+						ti = roundShift(br[t] * wi + bi[t] * wr, twiddleFracBits,
+							m_rounding);
+					}
+					int64_t ur = ar[t];
+					int64_t ui = ai[t];
+					ar[t] = overflowValue(roundShift(ur + tr, shift, m_rounding),
+						width, m_overflow);
+					ai[t] = overflowValue(roundShift(ui + ti, shift, m_rounding),
+						width, m_overflow);
+					br[t] = overflowValue(roundShift(ur - tr, shift, m_rounding),
+						width, m_overflow);
+					bi[t] = overflowValue(roundShift(ui - ti, shift, m_rounding),
+						width, m_overflow);
+				}
+			}
+		}
+	}
+}
+
+void FixedPointFft::transform(vector<complex<int64_t> > &x) const
+{
+	if (x.size() != m_size)
+	{
+		throw runtime_error("Input length does not match FFT size");
+	}
+	vector<int64_t> real(m_size);
+	vector<int64_t> imag(m_size);
+	for (size_t i = 0; i < m_size; i++)
+	{
+		real[i] = x[i].real();
+		imag[i] = x[i].imag();
+	}
+	transform(&real[0], &imag[0], 1);
+	for (size_t i = 0; i < m_size; i++)
+	{
+		x[i] = complex<int64_t>(real[i], imag[i]);
+	}
+}
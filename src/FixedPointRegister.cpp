@@ -0,0 +1,58 @@
+#include "FixedPointRegister.h"
+
+using namespace std;
+
+FxpReg::FixedPointRegister(FixedPointFormat format, RoundingMode rounding,
+	OverflowMode overflow)
+	: FixedPoint(0, format.width(), format.fracBits()),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+}
+
+FxpReg::FixedPointRegister(const FxpReg &other)
+	: FixedPoint(other.val(), other.width(), other.fracBits()),
+	m_rounding(other.m_rounding),
+	m_overflow(other.m_overflow)
+{
+}
+
+FxpReg &FxpReg::operator = (const Fxp &rhs)
+{
+	assign(rhs, m_rounding, m_overflow);
+	return *this;
+}
+
+FxpReg &FxpReg::operator = (const FxpReg &rhs)
+{
+	assign(rhs, m_rounding, m_overflow);
+	return *this;
+}
+
+CFxpReg::ComplexFixedPointRegister(FixedPointFormat format,
+	RoundingMode rounding, OverflowMode overflow)
+	: ComplexFixedPoint(0, 0, format.width(), format.fracBits()),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+}
+
+CFxpReg::ComplexFixedPointRegister(const CFxpReg &other)
+	: ComplexFixedPoint(other.real(), other.imag(), other.width(),
+		other.fracBits()),
+	m_rounding(other.m_rounding),
+	m_overflow(other.m_overflow)
+{
+}
+
+CFxpReg &CFxpReg::operator = (const CFxp &rhs)
+{
+	assign(rhs, m_rounding, m_overflow);
+	return *this;
+}
+
+CFxpReg &CFxpReg::operator = (const CFxpReg &rhs)
+{
+	assign(rhs, m_rounding, m_overflow);
+	return *this;
+}
@@ -0,0 +1,235 @@
+#include "MonteCarloAnalyzer.h"
+#include "Parallel.h"
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+/* In-place radix-2 transform; the spectrum only needs magnitudes, so no
+ * fixed-point model is involved */
+static void transform(vector<complex<double> > &x)
+{
+	size_t n = x.size();
+	for (size_t i = 1, j = 0; i < n; i++)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+		{
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j)
+		{
+			swap(x[i], x[j]);
+		}
+	}
+	for (size_t len = 2; len <= n; len <<= 1)
+	{
+		double angle = -2 * M_PI / len;
+		for (size_t k = 0; k < len / 2; k++)
+		{
+			complex<double> w = polar(1.0, angle * k);
+			for (size_t i = k; i < n; i += len)
+			{
+				complex<double> t = w * x[i + len / 2];
+				x[i + len / 2] = x[i] - t;
+				x[i] += t;
+			}
+		}
+	}
+}
+
+static double toDb(double signalPower, double noisePower)
+{
+	if (noisePower == 0)
+	{
+		return numeric_limits<double>::infinity();
+	}
+	return 10 * log10(signalPower / noisePower);
+}
+
+string MonteCarloReport::summary(void) const
+{
+	ostringstream out;
+	out << numTrials << " trials, " << numSamples << " samples\n";
+	out << fixed << setprecision(2);
+	out << "SQNR " << sqnrDb << " dB, ENOB " << enob << " bits, worst trial "
+		<< worstTrial << " at " << worstTrialSqnrDb << " dB\n";
+	out << scientific << setprecision(3);
+	out << "error max " << maxError << ", mean " << meanError << ", rms "
+		<< rmsError << "\n";
+	if (!errorSpectrum.empty())
+	{
+		size_t peak = 0;
+		for (size_t k = 1; k < errorSpectrum.size(); k++)
+		{
+			if (errorSpectrum[k] > errorSpectrum[peak])
+			{
+				peak = k;
+			}
+		}
+		out << "error spectrum " << errorSpectrum.size() << " bins, peak bin "
+			<< peak << " at " << fixed << setprecision(2)
+			<< 10 * log10(errorSpectrum[peak]) << " dB\n";
+	}
+	return out.str();
+}
+
+MonteCarloAnalyzer::MonteCarloAnalyzer(const Stimulus &stimulus,
+	const Model &fixedModel, const Model &referenceModel, size_t spectrumSize,
+	unsigned int numThreads)
+	: m_stimulus(stimulus),
+	m_fixedModel(fixedModel),
+	m_referenceModel(referenceModel),
+	m_spectrumSize(spectrumSize),
+	m_numThreads(numThreads),
+	m_window(spectrumSize),
+	m_windowPower(0)
+{
+	if (spectrumSize & (spectrumSize - 1))
+	{
+		throw range_error("Spectrum size must be a power of two");
+	}
+	for (size_t i = 0; i < spectrumSize; i++)
+	{
+		m_window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / spectrumSize);
+		m_windowPower += m_window[i] * m_window[i];
+	}
+}
+
+void MonteCarloAnalyzer::runTrial(size_t trial, uint64_t seed,
+	Accumulator &acc) const
+{
+	Xoshiro256 rng(seed, trial);
+	vector<double> stimulus = m_stimulus(rng);
+	vector<double> out = m_fixedModel(stimulus);
+	vector<double> reference = m_referenceModel(stimulus);
+	if (out.size() != reference.size())
+	{
+		throw runtime_error("Model output length does not match reference");
+	}
+
+	/* Separate passes keep each loop a plain reduction */
+	size_t n = out.size();
+	vector<double> error(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		error[i] = out[i] - reference[i];
+	}
+	double signalSum = 0, noiseSum = 0, errorSum = 0, maxError = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		signalSum += reference[i] * reference[i];
+		noiseSum += error[i] * error[i];
+		errorSum += error[i];
+		maxError = max(maxError, fabs(error[i]));
+	}
+
+	acc.signalSum += signalSum;
+	acc.noiseSum += noiseSum;
+	acc.errorSum += errorSum;
+	acc.maxError = max(acc.maxError, maxError);
+	acc.numSamples += n;
+	double sqnrDb = toDb(signalSum, noiseSum);
+	if (sqnrDb < acc.worstSqnrDb)
+	{
+		acc.worstSqnrDb = sqnrDb;
+		acc.worstTrial = trial;
+	}
+
+	/* Non-overlapping windowed segments; a short tail is dropped */
+	vector<complex<double> > segment(m_spectrumSize);
+	for (size_t start = 0; m_spectrumSize > 0 && start + m_spectrumSize <= n;
+		start += m_spectrumSize)
+	{
+		for (size_t i = 0; i < m_spectrumSize; i++)
+		{
+			segment[i] = error[start + i] * m_window[i];
+		}
+		transform(segment);
+		for (size_t k = 0; k < m_spectrumSize; k++)
+		{
+			acc.spectrum[k] += norm(segment[k]);
+		}
+		acc.numSegments++;
+	}
+}
+
+MonteCarloReport MonteCarloAnalyzer::run(size_t numTrials, uint64_t seed) const
+{
+	size_t numGroups = (numTrials + GROUP_SIZE - 1) / GROUP_SIZE;
+	Accumulator empty;
+	empty.signalSum = 0;
+	empty.noiseSum = 0;
+	empty.errorSum = 0;
+	empty.maxError = 0;
+	empty.numSamples = 0;
+	empty.worstTrial = 0;
+	empty.worstSqnrDb = numeric_limits<double>::infinity();
+	empty.numSegments = 0;
+	empty.spectrum.assign(m_spectrumSize, 0.0);
+	vector<Accumulator> groups(numGroups, empty);
+
+	parallelFor(0, numGroups, [&](size_t begin, size_t end, unsigned int)
+	{
+		for (size_t g = begin; g < end; g++)
+		{
+			size_t last = min(numTrials, (g + 1) * GROUP_SIZE);
+			for (size_t t = g * GROUP_SIZE; t < last; t++)
+			{
+				runTrial(t, seed, groups[g]);
+			}
+		}
+	}, m_numThreads);
+
+	Accumulator total(empty);
+	for (size_t g = 0; g < numGroups; g++)
+	{
+		const Accumulator &acc = groups[g];
+		total.signalSum += acc.signalSum;
+		total.noiseSum += acc.noiseSum;
+		total.errorSum += acc.errorSum;
+		total.maxError = max(total.maxError, acc.maxError);
+		total.numSamples += acc.numSamples;
+		if (acc.worstSqnrDb < total.worstSqnrDb)
+		{
+			total.worstSqnrDb = acc.worstSqnrDb;
+			total.worstTrial = acc.worstTrial;
+		}
+		total.numSegments += acc.numSegments;
+		for (size_t k = 0; k < m_spectrumSize; k++)
+		{
+			total.spectrum[k] += acc.spectrum[k];
+		}
+	}
+
+	MonteCarloReport report;
+	report.numTrials = numTrials;
+	report.numSamples = total.numSamples;
+	double count = (total.numSamples > 0) ? (double)total.numSamples : 1.0;
+	report.signalPower = total.signalSum / count;
+	report.noisePower = total.noiseSum / count;
+	report.sqnrDb = toDb(total.signalSum, total.noiseSum);
+	report.enob = (report.sqnrDb - 1.76) / 6.02;
+	report.maxError = total.maxError;
+	report.meanError = total.errorSum / count;
+	report.rmsError = sqrt(report.noisePower);
+	report.worstTrial = total.worstTrial;
+	report.worstTrialSqnrDb = total.worstSqnrDb;
+	if (total.numSegments > 0)
+	{
+		/* Parseval: the bins of one segment sum to size * sum(w^2 e^2) */
+		double scale = 1.0 / (total.numSegments * m_spectrumSize
+			* m_windowPower);
+		report.errorSpectrum.resize(m_spectrumSize);
+		for (size_t k = 0; k < m_spectrumSize; k++)
+		{
+			report.errorSpectrum[k] = total.spectrum[k] * scale;
+		}
+	}
+	return report;
+}
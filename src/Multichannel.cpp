@@ -0,0 +1,572 @@
+#include "Multichannel.h"
+#include "CoefficientCache.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+static unsigned int bitsFor(size_t n)
+{
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < n)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+MultichannelBuffer::MultichannelBuffer(unsigned int numChannels,
+	size_t numFrames, FixedPointFormat format)
+	: m_numChannels(numChannels),
+	m_numFrames(numFrames),
+	m_format(format),
+	m_data(numChannels * numFrames, 0)
+{
+	if (numChannels == 0)
+	{
+		throw range_error("Need at least one channel");
+	}
+}
+
+void MultichannelBuffer::resize(size_t numFrames)
+{
+	m_numFrames = numFrames;
+	m_data.resize(m_numChannels * numFrames, 0);
+}
+
+Fxp MultichannelBuffer::get(size_t frame, unsigned int channel) const
+{
+	if (frame >= m_numFrames || channel >= m_numChannels)
+	{
+		throw range_error("Sample index out of range");
+	}
+	return Fxp(m_data[frame * m_numChannels + channel], m_format.width(),
+		m_format.fracBits());
+}
+
+void MultichannelBuffer::set(size_t frame, unsigned int channel, const Fxp &v)
+{
+	if (frame >= m_numFrames || channel >= m_numChannels)
+	{
+		throw range_error("Sample index out of range");
+	}
+	if (v.width() != m_format.width() || v.fracBits() != m_format.fracBits())
+	{
+		throw runtime_error("Sample format does not match buffer");
+	}
+	m_data[frame * m_numChannels + channel] = v.val();
+}
+
+void MultichannelBuffer::readChannel(unsigned int channel, int64_t *out) const
+{
+	for (size_t f = 0; f < m_numFrames; f++)
+	{
+		out[f] = m_data[f * m_numChannels + channel];
+	}
+}
+
+void MultichannelBuffer::writeChannel(unsigned int channel, const int64_t *in)
+{
+	for (size_t f = 0; f < m_numFrames; f++)
+	{
+		m_data[f * m_numChannels + channel] = in[f];
+	}
+}
+
+ComplexMultichannelBuffer::ComplexMultichannelBuffer(unsigned int numChannels,
+	size_t numFrames, FixedPointFormat format)
+	: m_real(numChannels, numFrames, format),
+	m_imag(numChannels, numFrames, format)
+{
+}
+
+void ComplexMultichannelBuffer::resize(size_t numFrames)
+{
+	m_real.resize(numFrames);
+	m_imag.resize(numFrames);
+}
+
+CFxp ComplexMultichannelBuffer::get(size_t frame, unsigned int channel) const
+{
+	Fxp r = m_real.get(frame, channel);
+	return CFxp(r.val(), m_imag.get(frame, channel).val(), r.width(),
+		r.fracBits());
+}
+
+void ComplexMultichannelBuffer::set(size_t frame, unsigned int channel,
+	const CFxp &v)
+{
+	m_real.set(frame, channel, Fxp(v.real(), v.width(), v.fracBits()));
+	m_imag.set(frame, channel, Fxp(v.imag(), v.width(), v.fracBits()));
+}
+
+MultichannelEngine::MultichannelEngine(unsigned int numThreads,
+	unsigned int groupSize)
+	: m_numThreads(numThreads),
+	m_groupSize(groupSize)
+{
+	if (groupSize == 0)
+	{
+		throw range_error("Channel group size must be positive");
+	}
+}
+
+void MultichannelEngine::forEachGroup(unsigned int numChannels,
+	const function<void(unsigned int, unsigned int)> &fn) const
+{
+	size_t numGroups = (numChannels + m_groupSize - 1) / m_groupSize;
+	parallelFor(0, numGroups, [&](size_t begin, size_t end, unsigned int)
+	{
+		fn(begin * m_groupSize, min((size_t)numChannels, end * m_groupSize));
+	}, m_numThreads);
+}
+
+static void checkShape(const MultichannelBuffer &a, const MultichannelBuffer &b)
+{
+	if (a.numChannels() != b.numChannels())
+	{
+		throw runtime_error("Channel counts do not match");
+	}
+}
+
+void MultichannelEngine::requantize(const MultichannelBuffer &in,
+	MultichannelBuffer &out, RoundingMode rounding, OverflowMode overflow) const
+{
+	checkShape(in, out);
+	out.resize(in.numFrames());
+	unsigned int fromFracBits = in.format().fracBits();
+	unsigned int toFracBits = out.format().fracBits();
+	unsigned int width = out.format().width();
+	if (toFracBits > fromFracBits
+		&& in.format().width() + toFracBits - fromFracBits > 64)
+	{
+		throw range_error("Requantized values exceed 64 bits");
+	}
+
+	size_t channels = in.numChannels();
+	forEachGroup(channels, [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = overflowValue(alignValue(x[c], fromFracBits, toFracBits,
+					rounding), width, overflow);
+			}
+		}
+	});
+}
+
+void MultichannelEngine::multiply(const MultichannelBuffer &a,
+	const MultichannelBuffer &b, MultichannelBuffer &out,
+	RoundingMode rounding, OverflowMode overflow) const
+{
+	checkShape(a, b);
+	checkShape(a, out);
+	if (a.numFrames() != b.numFrames())
+	{
+		throw runtime_error("Frame counts do not match");
+	}
+	if (a.format().width() + b.format().width() > 63)
+	{
+		throw range_error("Products exceed 63 bits");
+	}
+	out.resize(a.numFrames());
+	unsigned int productFracBits = a.format().fracBits() + b.format().fracBits();
+	/* Saturation is decided before the product is shifted up */
+	FixedPointFormat toFormat = out.format();
+
+	forEachGroup(a.numChannels(), [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < a.numFrames(); f++)
+		{
+			const int64_t *x = a.frame(f);
+			const int64_t *g = b.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = resizeValue(x[c] * g[c], productFracBits, toFormat,
+					rounding, overflow);
+			}
+		}
+	});
+}
+
+void MultichannelEngine::multiply(const MultichannelBuffer &in,
+	const vector<int64_t> &gains, FixedPointFormat gainFormat,
+	MultichannelBuffer &out, RoundingMode rounding, OverflowMode overflow) const
+{
+	checkShape(in, out);
+	if (gains.size() != in.numChannels())
+	{
+		throw runtime_error("Need one gain per channel");
+	}
+	if (in.format().width() + gainFormat.width() > 63)
+	{
+		throw range_error("Products exceed 63 bits");
+	}
+	out.resize(in.numFrames());
+	unsigned int productFracBits = in.format().fracBits()
+		+ gainFormat.fracBits();
+	FixedPointFormat toFormat = out.format();
+	const int64_t *g = gains.data();
+
+	forEachGroup(in.numChannels(), [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = resizeValue(x[c] * g[c], productFracBits, toFormat,
+					rounding, overflow);
+			}
+		}
+	});
+}
+
+void MultichannelEngine::accumulate(const MultichannelBuffer &in,
+	MultichannelBuffer &acc, RoundingMode rounding, OverflowMode overflow) const
+{
+	checkShape(in, acc);
+	if (in.numFrames() != acc.numFrames())
+	{
+		throw runtime_error("Frame counts do not match");
+	}
+	unsigned int fromFracBits = in.format().fracBits();
+	unsigned int toFracBits = acc.format().fracBits();
+	unsigned int width = acc.format().width();
+	if (width > 62 || (toFracBits > fromFracBits
+		&& in.format().width() + toFracBits - fromFracBits > 62))
+	{
+		throw range_error("Accumulator exceeds 62 bits");
+	}
+
+	forEachGroup(in.numChannels(), [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *y = acc.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = overflowValue(y[c] + alignValue(x[c], fromFracBits,
+					toFracBits, rounding), width, overflow);
+			}
+		}
+	});
+}
+
+void MultichannelEngine::requantize(const ComplexMultichannelBuffer &in,
+	ComplexMultichannelBuffer &out, RoundingMode rounding,
+	OverflowMode overflow) const
+{
+	requantize(in.real(), out.real(), rounding, overflow);
+	requantize(in.imag(), out.imag(), rounding, overflow);
+}
+
+void MultichannelEngine::multiply(const ComplexMultichannelBuffer &a,
+	const ComplexMultichannelBuffer &b, ComplexMultichannelBuffer &out,
+	RoundingMode rounding, OverflowMode overflow) const
+{
+	checkShape(a.real(), b.real());
+	checkShape(a.real(), out.real());
+	if (a.numFrames() != b.numFrames())
+	{
+		throw runtime_error("Frame counts do not match");
+	}
+	if (a.format().width() + b.format().width() + 1 > 63)
+	{
+		throw range_error("Products exceed 63 bits");
+	}
+	out.resize(a.numFrames());
+	unsigned int productFracBits = a.format().fracBits() + b.format().fracBits();
+	FixedPointFormat toFormat = out.format();
+
+	forEachGroup(a.numChannels(), [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < a.numFrames(); f++)
+		{
+			const int64_t *ar = a.real().frame(f);
+			const int64_t *ai = a.imag().frame(f);
+			const int64_t *br = b.real().frame(f);
+			const int64_t *bi = b.imag().frame(f);
+			int64_t *yr = out.real().frame(f);
+			int64_t *yi = out.imag().frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				int64_t re = ar[c] * br[c] - ai[c] * bi[c];
+				int64_t im = ar[c] * bi[c] + ai[c] * br[c];
+				yr[c] = resizeValue(re, productFracBits, toFormat, rounding,
+					overflow);
+				yi[c] = resizeValue(im, productFracBits, toFormat, rounding,
+					overflow);
+			}
+		}
+	});
+}
+
+void MultichannelEngine::multiply(const ComplexMultichannelBuffer &in,
+	const vector<complex<int64_t> > &gains, FixedPointFormat gainFormat,
+	ComplexMultichannelBuffer &out, RoundingMode rounding,
+	OverflowMode overflow) const
+{
+	checkShape(in.real(), out.real());
+	if (gains.size() != in.numChannels())
+	{
+		throw runtime_error("Need one gain per channel");
+	}
+	if (in.format().width() + gainFormat.width() + 1 > 63)
+	{
+		throw range_error("Products exceed 63 bits");
+	}
+	out.resize(in.numFrames());
+	unsigned int productFracBits = in.format().fracBits()
+		+ gainFormat.fracBits();
+	FixedPointFormat toFormat = out.format();
+
+	/* Split the gains so the inner loop reads two plain arrays */
+	vector<int64_t> gainReal(gains.size());
+	vector<int64_t> gainImag(gains.size());
+	for (size_t c = 0; c < gains.size(); c++)
+	{
+		gainReal[c] = gains[c].real();
+		gainImag[c] = gains[c].imag();
+	}
+	const int64_t *gr = gainReal.data();
+	const int64_t *gi = gainImag.data();
+
+	forEachGroup(in.numChannels(), [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *xr = in.real().frame(f);
+			const int64_t *xi = in.imag().frame(f);
+			int64_t *yr = out.real().frame(f);
+			int64_t *yi = out.imag().frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				int64_t re = xr[c] * gr[c] - xi[c] * gi[c];
+				int64_t im = xr[c] * gi[c] + xi[c] * gr[c];
+				yr[c] = resizeValue(re, productFracBits, toFormat, rounding,
+					overflow);
+				yi[c] = resizeValue(im, productFracBits, toFormat, rounding,
+					overflow);
+			}
+		}
+	});
+}
+
+void MultichannelEngine::accumulate(const ComplexMultichannelBuffer &in,
+	ComplexMultichannelBuffer &acc, RoundingMode rounding,
+	OverflowMode overflow) const
+{
+	accumulate(in.real(), acc.real(), rounding, overflow);
+	accumulate(in.imag(), acc.imag(), rounding, overflow);
+}
+
+MultichannelFir::MultichannelFir(const vector<double> &coefficients,
+	FixedPointFormat coefFormat, unsigned int numChannels,
+	FixedPointFormat inputFormat, FixedPointFormat outputFormat,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_coefFormat(coefFormat),
+	m_numChannels(numChannels),
+	m_inputFormat(inputFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	if (coefficients.empty())
+	{
+		throw runtime_error("FIR needs at least one coefficient");
+	}
+	if (numChannels == 0)
+	{
+		throw range_error("Need at least one channel");
+	}
+	if (inputFormat.width() + coefFormat.width()
+		+ bitsFor(coefficients.size()) > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+	if (outputFormat.fracBits() > inputFormat.fracBits() + coefFormat.fracBits())
+	{
+		throw range_error("Fractional bits must not grow through the filter");
+	}
+	m_coefs = *CoefficientCache::quantize(coefficients, coefFormat);
+	reset();
+}
+
+void MultichannelFir::process(const MultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	if (in.numChannels() != m_numChannels || out.numChannels() != m_numChannels)
+	{
+		throw runtime_error("Channel counts do not match");
+	}
+	if (in.format() != m_inputFormat || out.format() != m_outputFormat)
+	{
+		throw runtime_error("Buffer format does not match filter");
+	}
+	out.resize(in.numFrames());
+
+	size_t numTaps = m_coefs.size();
+	size_t numFrames = in.numFrames();
+	size_t channels = m_numChannels;
+	size_t historyRows = numTaps - 1;
+	unsigned int shift = m_inputFormat.fracBits() + m_coefFormat.fracBits()
+		- m_outputFormat.fracBits();
+	unsigned int width = m_outputFormat.width();
+
+	engine.forEachGroup(m_numChannels, [&](unsigned int c0, unsigned int c1)
+	{
+		vector<int64_t> acc(c1 - c0);
+		int64_t *sum = acc.data() - c0;
+		for (size_t f = 0; f < numFrames; f++)
+		{
+			fill(acc.begin(), acc.end(), 0);
+			for (size_t k = 0; k < numTaps; k++)
+			{
+				/* frame f - k, from the history when it predates the block */
+				const int64_t *x = (f >= k) ? in.frame(f - k)
+					: &m_history[(historyRows + f - k) * channels];
+				int64_t h = m_coefs[k];
+				for (size_t c = c0; c < c1; c++)
+				{
+					sum[c] += h * x[c];
+				}
+			}
+
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = overflowValue(roundShift(sum[c], shift, m_rounding), width,
+					m_overflow);
+			}
+		}
+
+		/* Row r becomes frame numFrames - historyRows + r */
+		for (size_t r = 0; r < historyRows; r++)
+		{
+			const int64_t *x = (r + numFrames < historyRows)
+				? &m_history[(r + numFrames) * channels]
+				: in.frame(r + numFrames - historyRows);
+			int64_t *h = &m_history[r * channels];
+			for (size_t c = c0; c < c1; c++)
+			{
+				h[c] = x[c];
+			}
+		}
+	});
+}
+
+void MultichannelFir::reset(void)
+{
+	m_history.assign((m_coefs.size() - 1) * m_numChannels, 0);
+}
+
+MultichannelBiquad::MultichannelBiquad(const vector<double> &b,
+	const vector<double> &a, FixedPointFormat coefFormat,
+	unsigned int numChannels, FixedPointFormat inputFormat,
+	FixedPointFormat outputFormat, RoundingMode rounding,
+	OverflowMode overflow)
+	: m_coefFormat(coefFormat),
+	m_numChannels(numChannels),
+	m_inputFormat(inputFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	if (b.size() != 3 || a.size() != 3 || a[0] != 1.0)
+	{
+		throw runtime_error("Biquad needs b = {b0, b1, b2} and a = {1, a1, a2}");
+	}
+	if (numChannels == 0)
+	{
+		throw range_error("Need at least one channel");
+	}
+
+	/* x and y terms are aligned to the larger number of fractional bits */
+	unsigned int fracBits = max(inputFormat.fracBits(), outputFormat.fracBits());
+	unsigned int termWidth = max(
+		inputFormat.width() + fracBits - inputFormat.fracBits(),
+		outputFormat.width() + fracBits - outputFormat.fracBits());
+	if (termWidth + coefFormat.width() + 3 > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+
+	for (int k = 0; k < 3; k++)
+	{
+		m_b[k] = quantizeValue(b[k], coefFormat);
+	}
+	m_a[0] = quantizeValue(a[1], coefFormat);
+	m_a[1] = quantizeValue(a[2], coefFormat);
+	reset();
+}
+
+void MultichannelBiquad::process(const MultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	if (in.numChannels() != m_numChannels || out.numChannels() != m_numChannels)
+	{
+		throw runtime_error("Channel counts do not match");
+	}
+	if (in.format() != m_inputFormat || out.format() != m_outputFormat)
+	{
+		throw runtime_error("Buffer format does not match filter");
+	}
+	out.resize(in.numFrames());
+
+	unsigned int fracBits = max(m_inputFormat.fracBits(),
+		m_outputFormat.fracBits());
+	unsigned int inFracBits = m_inputFormat.fracBits();
+	unsigned int outFracBits = m_outputFormat.fracBits();
+	unsigned int outShift = fracBits + m_coefFormat.fracBits()
+		- m_outputFormat.fracBits();
+	unsigned int width = m_outputFormat.width();
+	int64_t b0 = m_b[0];
+	int64_t b1 = m_b[1];
+	int64_t b2 = m_b[2];
+	int64_t a1 = m_a[0];
+	int64_t a2 = m_a[1];
+
+	/* The recursion runs along time, so the inner loop runs across channels */
+	engine.forEachGroup(m_numChannels, [&](unsigned int c0, unsigned int c1)
+	{
+		int64_t *x1 = m_x1.data();
+		int64_t *x2 = m_x2.data();
+		int64_t *y1 = m_y1.data();
+		int64_t *y2 = m_y2.data();
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				int64_t xs = alignValue(x[c], inFracBits, fracBits, m_rounding);
+				int64_t sum = b0 * xs + b1 * x1[c] + b2 * x2[c]
+					- a1 * y1[c] - a2 * y2[c];
+				int64_t v = overflowValue(roundShift(sum, outShift, m_rounding),
+					width, m_overflow);
+				x2[c] = x1[c];
+				x1[c] = xs;
+				y2[c] = y1[c];
+				y1[c] = alignValue(v, outFracBits, fracBits, m_rounding);
+				y[c] = v;
+			}
+		}
+	});
+}
+
+void MultichannelBiquad::reset(void)
+{
+	m_x1.assign(m_numChannels, 0);
+	m_x2.assign(m_numChannels, 0);
+	m_y1.assign(m_numChannels, 0);
+	m_y2.assign(m_numChannels, 0);
+}
@@ -0,0 +1,122 @@
+#include "NoiseShaper.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+NoiseShaper::NoiseShaper(FixedPointFormat inputFormat,
+	FixedPointFormat outputFormat, const vector<double> &errorFilter,
+	unsigned int filterFracBits, bool dither, uint64_t seed,
+	unsigned int numChannels, RoundingMode rounding)
+	: m_inputFormat(inputFormat),
+	m_outputFormat(outputFormat),
+	m_shift(0),
+	m_filter(errorFilter.size()),
+	m_filterFracBits(filterFracBits),
+	m_dither(dither),
+	m_seed(seed),
+	m_numChannels(numChannels),
+	m_rounding(rounding),
+	m_errorPos(0),
+	m_feedback(numChannels)
+{
+	if (outputFormat.fracBits() >= inputFormat.fracBits())
+	{
+		throw range_error("Output must have fewer fractional bits than input");
+	}
+	m_shift = inputFormat.fracBits() - outputFormat.fracBits();
+	if (inputFormat.width() > 48 || (dither && m_shift > 32))
+	{
+		throw range_error("Requantization width out of range");
+	}
+	if (numChannels == 0)
+	{
+		throw range_error("Need at least one channel");
+	}
+	if (filterFracBits > 24)
+	{
+		throw range_error("Filter fractional bits out of range");
+	}
+
+	for (size_t k = 0; k < errorFilter.size(); k++)
+	{
+		m_filter[k] = Fxp::quantize(errorFilter[k], filterFracBits + 8,
+			filterFracBits).val();
+	}
+	reset();
+}
+
+Fxp NoiseShaper::process(const Fxp &x)
+{
+	if (m_numChannels != 1)
+	{
+		throw runtime_error("Scalar processing needs a single channel");
+	}
+	if (x.width() != m_inputFormat.width()
+		|| x.fracBits() != m_inputFormat.fracBits())
+	{
+		throw runtime_error("Input format does not match noise shaper");
+	}
+	int64_t in = x.val();
+	int64_t out;
+	process(&in, &out, 1);
+	return Fxp(out, m_outputFormat.width(), m_outputFormat.fracBits());
+}
+
+void NoiseShaper::process(const int64_t *in, int64_t *out, size_t numFrames)
+{
+	size_t order = m_filter.size();
+	size_t channels = m_numChannels;
+	unsigned int outWidth = m_outputFormat.width();
+	uint64_t ditherMask = (1ULL << m_shift) - 1;
+	int64_t *feedback = &m_feedback[0];
+
+	for (size_t f = 0; f < numFrames; f++)
+	{
+		const int64_t *x = in + f * channels;
+		int64_t *y = out + f * channels;
+
+		fill(m_feedback.begin(), m_feedback.end(), 0);
+		for (size_t k = 0; k < order; k++)
+		{
+			const int64_t *e = &m_errors[((m_errorPos + k) % order) * channels];
+			int64_t h = m_filter[k];
+			for (size_t c = 0; c < channels; c++)
+			{
+				feedback[c] += h * e[c];
+			}
+		}
+
+		size_t newPos = order ? (m_errorPos + order - 1) % order : 0;
+		int64_t *eNew = order ? &m_errors[newPos * channels] : NULL;
+		for (size_t c = 0; c < channels; c++)
+		{
+			int64_t v = x[c] - roundShift(feedback[c], m_filterFracBits,
+				ROUND_HALF_UP);
+			int64_t d = 0;
+			if (m_dither)
+			{
+				uint64_t r = m_rngs[c].next();
+				d = (int64_t)(r & ditherMask) - (int64_t)((r >> 32) & ditherMask);
+			}
+			int64_t q = roundShift(v + d, m_shift, m_rounding);
+			y[c] = saturateValue(q, outWidth);
+			if (order)
+			{
+				eNew[c] = q * (1LL << m_shift) - v;
+			}
+		}
+		m_errorPos = newPos;
+	}
+}
+
+void NoiseShaper::reset(void)
+{
+	m_errors.assign(m_filter.size() * m_numChannels, 0);
+	m_errorPos = 0;
+	m_rngs.clear();
+	for (unsigned int c = 0; c < m_numChannels; c++)
+	{
+		m_rngs.push_back(Xoshiro256(m_seed, c));
+	}
+}
@@ -0,0 +1,287 @@
+#include "Polynomial.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+/* Samples are processed in blocks small enough to keep the gathered indices,
+ * local offsets and accumulators in L1 */
+static const size_t BLOCK_SIZE = 256;
+
+struct HornerParams
+{
+	unsigned int order;
+	unsigned int varFracBits;
+	FixedPointFormat accFormat;
+	FixedPointFormat outputFormat;
+	RoundingMode rounding;
+	OverflowMode overflow;
+};
+
+static void checkFormats(FixedPointFormat varFormat, FixedPointFormat accFormat,
+	FixedPointFormat outputFormat)
+{
+	if (accFormat.width() + varFormat.width() > 63)
+	{
+		throw range_error("Accumulator and input widths exceed 63 bits");
+	}
+	if (outputFormat.fracBits() > accFormat.fracBits() && accFormat.width()
+		+ outputFormat.fracBits() - accFormat.fracBits() > 64)
+	{
+		throw range_error("Output alignment exceeds 64 bits");
+	}
+}
+
+/* Quantizes coefficients through the cache and moves them to the
+ * accumulator's binary point */
+static vector<int64_t> alignedCoefficients(const vector<double> &values,
+	FixedPointFormat coefFormat, FixedPointFormat accFormat,
+	RoundingMode rounding)
+{
+	if (coefFormat.fracBits() < accFormat.fracBits()
+		&& coefFormat.width() + accFormat.fracBits() - coefFormat.fracBits() > 64)
+	{
+		throw range_error("Coefficient alignment exceeds 64 bits");
+	}
+
+	CoefficientTable table = CoefficientCache::quantize(values, coefFormat);
+	vector<int64_t> coefs(table->size());
+	for (size_t i = 0; i < coefs.size(); i++)
+	{
+		coefs[i] = alignValue((*table)[i], coefFormat.fracBits(),
+			accFormat.fracBits(), rounding);
+		if (coefs[i] < accFormat.minVal() || coefs[i] > accFormat.maxVal())
+		{
+			throw range_error("Coefficient does not fit accumulator format");
+		}
+	}
+	return coefs;
+}
+
+/* Horner evaluation of one block. Sample j uses the coefficients starting at
+ * coefs[offset[j]] (highest order last) and the variable t[j]. */
+static void hornerBlock(const int64_t *coefs, const size_t *offset,
+	const int64_t *t, int64_t *y, size_t m, const HornerParams &p)
+{
+	int64_t acc[BLOCK_SIZE];
+	unsigned int accWidth = p.accFormat.width();
+
+	for (size_t j = 0; j < m; j++)
+	{
+		acc[j] = coefs[offset[j] + p.order];
+	}
+
+	for (unsigned int k = p.order; k-- > 0;)
+	{
+		for (size_t j = 0; j < m; j++)
+		{
+			int64_t product = roundShift(acc[j] * t[j], p.varFracBits, p.rounding);
+			acc[j] = overflowValue(product + coefs[offset[j] + k], accWidth,
+				p.overflow);
+		}
+	}
+
+	for (size_t j = 0; j < m; j++)
+	{
+		y[j] = overflowValue(alignValue(acc[j], p.accFormat.fracBits(),
+			p.outputFormat.fracBits(), p.rounding), p.outputFormat.width(),
+			p.overflow);
+	}
+}
+
+FixedPointPolynomial::FixedPointPolynomial(const vector<double> &coefficients,
+	FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+	FixedPointFormat accFormat, FixedPointFormat outputFormat,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_inputFormat(inputFormat),
+	m_accFormat(accFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	if (coefficients.empty())
+	{
+		throw runtime_error("Polynomial needs at least one coefficient");
+	}
+	checkFormats(inputFormat, accFormat, outputFormat);
+	m_coefs = alignedCoefficients(coefficients, coefFormat, accFormat,
+		rounding);
+}
+
+Fxp FixedPointPolynomial::evaluate(const Fxp &x) const
+{
+	if (x.width() != m_inputFormat.width()
+		|| x.fracBits() != m_inputFormat.fracBits())
+	{
+		throw runtime_error("Input format does not match polynomial");
+	}
+	int64_t v = x.val();
+	int64_t y;
+	evaluate(&v, &y, 1);
+	return Fxp(y, m_outputFormat.width(), m_outputFormat.fracBits());
+}
+
+void FixedPointPolynomial::evaluate(const int64_t *x, int64_t *y,
+	size_t n) const
+{
+	HornerParams p = { order(), m_inputFormat.fracBits(), m_accFormat,
+		m_outputFormat, m_rounding, m_overflow };
+	size_t offset[BLOCK_SIZE] = { 0 };
+
+	for (size_t i = 0; i < n; i += BLOCK_SIZE)
+	{
+		hornerBlock(&m_coefs[0], offset, x + i, y + i,
+			min(BLOCK_SIZE, n - i), p);
+	}
+}
+
+PiecewisePolynomial::PiecewisePolynomial(
+	const vector<vector<double> > &segments, unsigned int segmentBits,
+	FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+	FixedPointFormat accFormat, FixedPointFormat outputFormat,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_order(0),
+	m_segmentBits(segmentBits),
+	m_inputFormat(inputFormat),
+	m_accFormat(accFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	if (segmentBits >= inputFormat.width() || segmentBits > 24)
+	{
+		throw range_error("Segment bits out of range");
+	}
+	if (segments.size() != (1ULL << segmentBits) || segments[0].empty())
+	{
+		throw runtime_error("Need one polynomial per segment");
+	}
+
+	m_order = segments[0].size() - 1;
+	vector<double> flat;
+	flat.reserve(segments.size() * (m_order + 1));
+	for (size_t s = 0; s < segments.size(); s++)
+	{
+		if (segments[s].size() != m_order + 1)
+		{
+			throw runtime_error("All segments must have the same order");
+		}
+		flat.insert(flat.end(), segments[s].begin(), segments[s].end());
+	}
+
+	/* t is non-negative with one more bit than its fractional bits */
+	unsigned int localBits = inputFormat.width() - segmentBits;
+	checkFormats(FixedPointFormat(localBits + 1, localBits), accFormat,
+		outputFormat);
+	m_coefs = alignedCoefficients(flat, coefFormat, accFormat, rounding);
+}
+
+vector<vector<double> > PiecewisePolynomial::fit(
+	const function<double(double)> &f, FixedPointFormat inputFormat,
+	unsigned int segmentBits, unsigned int order)
+{
+	if (segmentBits >= inputFormat.width() || segmentBits > 24)
+	{
+		throw range_error("Segment bits out of range");
+	}
+
+	size_t numSegments = 1ULL << segmentBits;
+	size_t n = order + 1;
+	double scale = pow(2.0, -(double)inputFormat.fracBits());
+	double xMin = inputFormat.minVal() * scale;
+	double segmentSize = pow(2.0, inputFormat.width() - segmentBits) * scale;
+	vector<vector<double> > segments(numSegments);
+
+	for (size_t s = 0; s < numSegments; s++)
+	{
+		/* Vandermonde system at Chebyshev nodes mapped to [0, 1) */
+		vector<vector<double> > a(n, vector<double>(n + 1));
+		for (size_t i = 0; i < n; i++)
+		{
+			double t = 0.5 - 0.5 * cos(M_PI * (i + 0.5) / n);
+			double power = 1.0;
+			for (size_t k = 0; k < n; k++)
+			{
+				a[i][k] = power;
+				power *= t;
+			}
+			a[i][n] = f(xMin + (s + t) * segmentSize);
+		}
+
+		/* Gaussian elimination with partial pivoting */
+		for (size_t col = 0; col < n; col++)
+		{
+			size_t pivot = col;
+			for (size_t row = col + 1; row < n; row++)
+			{
+				if (fabs(a[row][col]) > fabs(a[pivot][col]))
+				{
+					pivot = row;
+				}
+			}
+			swap(a[col], a[pivot]);
+			for (size_t row = col + 1; row < n; row++)
+			{
+				double factor = a[row][col] / a[col][col];
+				for (size_t k = col; k <= n; k++)
+				{
+					a[row][k] -= factor * a[col][k];
+				}
+			}
+		}
+
+		segments[s].resize(n);
+		for (size_t row = n; row-- > 0;)
+		{
+			double sum = a[row][n];
+			for (size_t k = row + 1; k < n; k++)
+			{
+				sum -= a[row][k] * segments[s][k];
+			}
+			segments[s][row] = sum / a[row][row];
+		}
+	}
+	return segments;
+}
+
+Fxp PiecewisePolynomial::evaluate(const Fxp &x) const
+{
+	if (x.width() != m_inputFormat.width()
+		|| x.fracBits() != m_inputFormat.fracBits())
+	{
+		throw runtime_error("Input format does not match polynomial");
+	}
+	int64_t v = x.val();
+	int64_t y;
+	evaluate(&v, &y, 1);
+	return Fxp(y, m_outputFormat.width(), m_outputFormat.fracBits());
+}
+
+void PiecewisePolynomial::evaluate(const int64_t *x, int64_t *y,
+	size_t n) const
+{
+	unsigned int width = m_inputFormat.width();
+	unsigned int localBits = width - m_segmentBits;
+	uint64_t signBit = 1ULL << (width - 1);
+	uint64_t mask = (width == 64) ? ~0ULL : (1ULL << width) - 1;
+	uint64_t localMask = (1ULL << localBits) - 1;
+	size_t stride = m_order + 1;
+
+	HornerParams p = { m_order, localBits, m_accFormat, m_outputFormat,
+		m_rounding, m_overflow };
+	size_t offset[BLOCK_SIZE];
+	int64_t t[BLOCK_SIZE];
+
+	for (size_t i = 0; i < n; i += BLOCK_SIZE)
+	{
+		size_t m = min(BLOCK_SIZE, n - i);
+		for (size_t j = 0; j < m; j++)
+		{
+			uint64_t u = ((uint64_t)x[i + j] + signBit) & mask;
+			offset[j] = (u >> localBits) * stride;
+			t[j] = u & localMask;
+		}
+		hornerBlock(&m_coefs[0], offset, t, y + i, m, p);
+	}
+}
@@ -0,0 +1,165 @@
+#include "PolyphaseChannelizer.h"
+#include "CoefficientCache.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+/* Branch outputs kept per block, real and imaginary */
+static const size_t BLOCK_VALUES = 8192;
+
+static unsigned int bitsFor(size_t n)
+{
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < n)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+PolyphaseChannelizer::PolyphaseChannelizer(unsigned int numChannels,
+	const vector<double> &prototype, bool oversampled,
+	FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+	FixedPointFormat branchFormat, FixedPointFormat twiddleFormat,
+	FixedPointFormat outputFormat, unsigned int fftScaleSchedule,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_numChannels(numChannels),
+	m_decimation(oversampled ? numChannels / 2 : numChannels),
+	m_tapsPerBranch((prototype.size() + numChannels - 1) / numChannels),
+	m_inputFormat(inputFormat),
+	m_coefFormat(coefFormat),
+	m_branchFormat(branchFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow),
+	m_fft(numChannels, branchFormat, twiddleFormat, fftScaleSchedule, true,
+		rounding, overflow)
+{
+	if (prototype.empty())
+	{
+		throw runtime_error("Prototype filter needs at least one coefficient");
+	}
+	if (inputFormat.width() + coefFormat.width() + bitsFor(m_tapsPerBranch)
+		> 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+	if (branchFormat.fracBits() > inputFormat.fracBits() + coefFormat.fracBits())
+	{
+		throw range_error("Fractional bits must not grow through the datapath");
+	}
+
+	CoefficientTable h = CoefficientCache::quantize(prototype, coefFormat);
+	m_branches.assign(numChannels, vector<int64_t>(m_tapsPerBranch, 0));
+	for (size_t n = 0; n < h->size(); n++)
+	{
+		m_branches[n % numChannels][n / numChannels] = (*h)[n];
+	}
+	reset();
+}
+
+size_t PolyphaseChannelizer::process(const complex<int64_t> *in, size_t n,
+	ComplexMultichannelBuffer &out)
+{
+	if (out.numChannels() != m_numChannels || out.format() != m_outputFormat)
+	{
+		throw runtime_error("Output buffer does not match channelizer");
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		m_inputReal.push_back(in[i].real());
+		m_inputImag.push_back(in[i].imag());
+	}
+
+	size_t numChannels = m_numChannels;
+	size_t decimation = m_decimation;
+	size_t historyLength = m_tapsPerBranch * numChannels - 1;
+	size_t numFrames = (m_inputReal.size() - historyLength) / decimation;
+	size_t firstFrame = out.numFrames();
+	out.resize(firstFrame + numFrames);
+
+	size_t blockFrames = max((size_t)1, BLOCK_VALUES / numChannels);
+	unsigned int branchShift = m_inputFormat.fracBits()
+		+ m_coefFormat.fracBits() - m_branchFormat.fracBits();
+	unsigned int branchWidth = m_branchFormat.width();
+	bool oversampled = decimation != numChannels;
+
+	for (size_t b0 = 0; b0 < numFrames; b0 += blockFrames)
+	{
+		size_t count = min(blockFrames, numFrames - b0);
+		m_workReal.assign(numChannels * count, 0);
+		m_workImag.assign(numChannels * count, 0);
+
+		/* Commutator and branch filters, running across the block's frames:
+		 * frame t of branch p reads x[(t + 1) D - 1 - lM - p] */
+		for (size_t p = 0; p < numChannels; p++)
+		{
+			int64_t *vr = &m_workReal[p * count];
+			int64_t *vi = &m_workImag[p * count];
+			for (size_t l = 0; l < m_tapsPerBranch; l++)
+			{
+				int64_t h = m_branches[p][l];
+				size_t first = historyLength + (b0 + 1) * decimation - 1
+					- l * numChannels - p;
+				const int64_t *xr = &m_inputReal[first];
+				const int64_t *xi = &m_inputImag[first];
+				for (size_t t = 0; t < count; t++)
+				{
+					vr[t] += h * xr[t * decimation];
+					vi[t] += h * xi[t * decimation];
+				}
+			}
+			for (size_t t = 0; t < count; t++)
+			{
+				vr[t] = overflowValue(roundShift(vr[t], branchShift, m_rounding),
+					branchWidth, m_overflow);
+				vi[t] = overflowValue(roundShift(vi[t], branchShift, m_rounding),
+					branchWidth, m_overflow);
+			}
+		}
+
+		m_fft.transform(&m_workReal[0], &m_workImag[0], count);
+
+		/* Transpose into frame-major output, rotating odd channels of odd
+		 * frames in the oversampled bank */
+		for (size_t t = 0; t < count; t++)
+		{
+			bool oddFrame = oversampled && ((m_frameCount + b0 + t) & 0x1);
+			int64_t *yr = out.real().frame(firstFrame + b0 + t);
+			int64_t *yi = out.imag().frame(firstFrame + b0 + t);
+			for (size_t k = 0; k < numChannels; k++)
+			{
+				int64_t vr = m_workReal[k * count + t];
+				int64_t vi = m_workImag[k * count + t];
+				if (oddFrame && (k & 0x1))
+				{
+					vr = -vr;
+					vi = -vi;
+				}
+				yr[k] = overflowValue(alignValue(vr, m_branchFormat.fracBits(),
+					m_outputFormat.fracBits(), m_rounding), m_outputFormat.width(),
+					m_overflow);
+				yi[k] = overflowValue(alignValue(vi, m_branchFormat.fracBits(),
+					m_outputFormat.fracBits(), m_rounding), m_outputFormat.width(),
+					m_overflow);
+			}
+		}
+	}
+
+	m_inputReal.erase(m_inputReal.begin(),
+		m_inputReal.begin() + numFrames * decimation);
+	m_inputImag.erase(m_inputImag.begin(),
+		m_inputImag.begin() + numFrames * decimation);
+	m_frameCount += numFrames;
+	return numFrames;
+}
+
+void PolyphaseChannelizer::reset(void)
+{
+	size_t historyLength = m_tapsPerBranch * m_numChannels - 1;
+	m_inputReal.assign(historyLength, 0);
+	m_inputImag.assign(historyLength, 0);
+	m_frameCount = 0;
+}
@@ -0,0 +1,433 @@
+#include "SlidingWindow.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+static unsigned int bitsFor(size_t n)
+{
+	unsigned int bits = 0;
+	while (((size_t)1 << bits) < n)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+static void checkWindow(size_t windowLength, unsigned int numChannels)
+{
+	if (windowLength == 0)
+	{
+		throw range_error("Window length must be at least 1");
+	}
+	if (numChannels == 0)
+	{
+		throw range_error("Need at least one channel");
+	}
+}
+
+static void checkBuffer(const MultichannelBuffer &buffer,
+	unsigned int numChannels, FixedPointFormat format)
+{
+	if (buffer.numChannels() != numChannels)
+	{
+		throw runtime_error("Channel counts do not match");
+	}
+	if (buffer.format() != format)
+	{
+		throw runtime_error("Buffer format does not match filter");
+	}
+}
+
+MovingSum::MovingSum(size_t windowLength, unsigned int numChannels,
+	FixedPointFormat inputFormat, FixedPointFormat outputFormat,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_windowLength(windowLength),
+	m_numChannels(numChannels),
+	m_inputFormat(inputFormat),
+	m_accFormat(inputFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow),
+	m_position(0)
+{
+	checkWindow(windowLength, numChannels);
+	if (inputFormat.width() + bitsFor(windowLength) > 63)
+	{
+		throw range_error("Accumulator exceeds 63 bits");
+	}
+	m_accFormat = accumulatorFormat(inputFormat, windowLength);
+	reset();
+}
+
+FixedPointFormat MovingSum::accumulatorFormat(FixedPointFormat inputFormat,
+	size_t windowLength)
+{
+	return FixedPointFormat(inputFormat.width() + bitsFor(windowLength),
+		inputFormat.fracBits());
+}
+
+void MovingSum::process(const MultichannelBuffer &in, MultichannelBuffer &out,
+	const MultichannelEngine &engine)
+{
+	checkBuffer(in, m_numChannels, m_inputFormat);
+	checkBuffer(out, m_numChannels, m_outputFormat);
+	out.resize(in.numFrames());
+
+	size_t numFrames = in.numFrames();
+	size_t channels = m_numChannels;
+	size_t position = m_position;
+	unsigned int fracBits = m_accFormat.fracBits();
+
+	engine.forEachGroup(m_numChannels, [&](unsigned int c0, unsigned int c1)
+	{
+		int64_t *sum = m_sum.data();
+		size_t p = position;
+		for (size_t f = 0; f < numFrames; f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *oldest = &m_history[p * channels];
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				sum[c] += x[c] - oldest[c];
+				oldest[c] = x[c];
+				y[c] = resizeValue(sum[c], fracBits, m_outputFormat, m_rounding,
+					m_overflow);
+			}
+			if (++p == m_windowLength)
+			{
+				p = 0;
+			}
+		}
+	});
+	m_position = (position + numFrames) % m_windowLength;
+}
+
+void MovingSum::reset(void)
+{
+	m_history.assign(m_windowLength * m_numChannels, 0);
+	m_position = 0;
+	m_sum.assign(m_numChannels, 0);
+}
+
+MovingPower::MovingPower(size_t windowLength, unsigned int numChannels,
+	FixedPointFormat inputFormat, bool isComplex, FixedPointFormat outputFormat,
+	RoundingMode rounding, OverflowMode overflow)
+	: m_inputFormat(inputFormat),
+	m_complex(isComplex),
+	m_sum(windowLength, numChannels, squareFormat(inputFormat, isComplex),
+		outputFormat, rounding, overflow),
+	m_squares(numChannels, 0, squareFormat(inputFormat, isComplex))
+{
+}
+
+FixedPointFormat MovingPower::squareFormat(FixedPointFormat inputFormat,
+	bool isComplex)
+{
+	return FixedPointFormat(2 * inputFormat.width() + (isComplex ? 1 : 0),
+		2 * inputFormat.fracBits());
+}
+
+void MovingPower::process(const MultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	if (m_complex)
+	{
+		throw runtime_error("Power was set up for complex input");
+	}
+	checkBuffer(in, m_sum.numChannels(), m_inputFormat);
+	m_squares.resize(in.numFrames());
+
+	engine.forEachGroup(m_sum.numChannels(),
+		[&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *y = m_squares.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = x[c] * x[c];
+			}
+		}
+	});
+	m_sum.process(m_squares, out, engine);
+}
+
+void MovingPower::process(const ComplexMultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	if (!m_complex)
+	{
+		throw runtime_error("Power was set up for real input");
+	}
+	checkBuffer(in.real(), m_sum.numChannels(), m_inputFormat);
+	m_squares.resize(in.numFrames());
+
+	engine.forEachGroup(m_sum.numChannels(),
+		[&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *re = in.real().frame(f);
+			const int64_t *im = in.imag().frame(f);
+			int64_t *y = m_squares.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				y[c] = re[c] * re[c] + im[c] * im[c];
+			}
+		}
+	});
+	m_sum.process(m_squares, out, engine);
+}
+
+void MovingPower::reset(void)
+{
+	m_sum.reset();
+}
+
+/* The power sum is kept exact: MovingPower outputs its own accumulator */
+static FixedPointFormat powerFormat(FixedPointFormat inputFormat,
+	bool isComplex, size_t windowLength)
+{
+	return MovingSum::accumulatorFormat(
+		MovingPower::squareFormat(inputFormat, isComplex), windowLength);
+}
+
+MovingRms::MovingRms(size_t windowLength, unsigned int numChannels,
+	FixedPointFormat inputFormat, bool isComplex, FixedPointFormat outputFormat)
+	: m_windowLength(windowLength),
+	m_power(windowLength, numChannels, inputFormat, isComplex,
+		powerFormat(inputFormat, isComplex, windowLength), ROUND_FLOOR,
+		OVERFLOW_WRAP),
+	m_outputFormat(outputFormat),
+	m_shift(2 * (int)outputFormat.fracBits() - 2 * (int)inputFormat.fracBits()),
+	m_sums(numChannels, 0, powerFormat(inputFormat, isComplex, windowLength))
+{
+	if (outputFormat.fracBits() > inputFormat.fracBits() + 32)
+	{
+		throw range_error("RMS may have at most 32 more fractional bits");
+	}
+}
+
+void MovingRms::process(const MultichannelBuffer &in, MultichannelBuffer &out,
+	const MultichannelEngine &engine)
+{
+	checkBuffer(out, m_sums.numChannels(), m_outputFormat);
+	m_power.process(in, m_sums, engine);
+	root(out, engine);
+}
+
+void MovingRms::process(const ComplexMultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	checkBuffer(out, m_sums.numChannels(), m_outputFormat);
+	m_power.process(in, m_sums, engine);
+	root(out, engine);
+}
+
+void MovingRms::reset(void)
+{
+	m_power.reset();
+}
+
+/* floor(sqrt(v)) from a floating-point estimate, one Newton step and a final
+ * correction */
+static uint64_t integerSqrt(unsigned __int128 v)
+{
+	if (v == 0)
+	{
+		return 0;
+	}
+	unsigned __int128 r = (unsigned __int128)sqrtl((long double)v);
+	if (r == 0)
+	{
+		r = 1;
+	}
+	r = (r + v / r) / 2;
+	while (r * r > v)
+	{
+		r--;
+	}
+	while ((r + 1) * (r + 1) <= v)
+	{
+		r++;
+	}
+	return (uint64_t)r;
+}
+
+void MovingRms::root(MultichannelBuffer &out,
+	const MultichannelEngine &engine) const
+{
+	out.resize(m_sums.numFrames());
+	uint64_t maxVal = (uint64_t)m_outputFormat.maxVal();
+	unsigned __int128 length = m_windowLength;
+
+	engine.forEachGroup(m_sums.numChannels(),
+		[&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < m_sums.numFrames(); f++)
+		{
+			const int64_t *p = m_sums.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				/* sums of squares are never negative */
+				unsigned __int128 v = (uint64_t)p[c];
+				if (m_shift >= 0)
+				{
+					v <<= m_shift;
+				}
+				else
+				{
+					v = (m_shift > -64) ? v >> -m_shift : 0;
+				}
+				y[c] = (int64_t)min(integerSqrt(v / length), maxVal);
+			}
+		}
+	});
+}
+
+SlidingPeak::SlidingPeak(size_t windowLength, unsigned int numChannels,
+	FixedPointFormat format, PeakMode mode)
+	: m_windowLength(windowLength),
+	m_numChannels(numChannels),
+	m_format(format),
+	m_mode(mode),
+	m_count(0)
+{
+	checkWindow(windowLength, numChannels);
+	reset();
+}
+
+/* Keys order candidates so the wanted peak is always the largest key. ~v
+ * reverses the order without overflowing at the minimum value. */
+static int64_t peakKey(int64_t v, PeakMode mode, int64_t maxVal)
+{
+	switch (mode)
+	{
+	case PEAK_MIN: return ~v;
+	case PEAK_ABS: return (v >= 0) ? v : ((v < -maxVal) ? maxVal : -v);
+	default: return v;
+	}
+}
+
+void SlidingPeak::process(const MultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	checkBuffer(in, m_numChannels, m_format);
+	checkBuffer(out, m_numChannels, m_format);
+	out.resize(in.numFrames());
+
+	size_t numFrames = in.numFrames();
+	size_t channels = m_numChannels;
+	size_t length = m_windowLength;
+	int64_t maxVal = m_format.maxVal();
+
+	engine.forEachGroup(m_numChannels, [&](unsigned int c0, unsigned int c1)
+	{
+		for (size_t f = 0; f < numFrames; f++)
+		{
+			uint64_t n = m_count + f;
+			const int64_t *x = in.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				size_t head = m_head[c];
+				size_t size = m_size[c];
+				if (size > 0 && m_index[head * channels + c] + length <= n)
+				{
+					head = (head + 1 == length) ? 0 : head + 1;
+					size--;
+				}
+
+				/* Ties keep the newer sample, which expires later */
+				int64_t key = peakKey(x[c], m_mode, maxVal);
+				while (size > 0
+					&& m_key[((head + size - 1) % length) * channels + c] <= key)
+				{
+					size--;
+				}
+				size_t slot = ((head + size) % length) * channels + c;
+				m_index[slot] = n;
+				m_key[slot] = key;
+				size++;
+
+				int64_t peak = m_key[head * channels + c];
+				y[c] = (m_mode == PEAK_MIN) ? ~peak : peak;
+				m_head[c] = head;
+				m_size[c] = size;
+			}
+		}
+	});
+	m_count += numFrames;
+}
+
+void SlidingPeak::reset(void)
+{
+	/* The zeros filling the window collapse into one candidate, the newest */
+	m_count = m_windowLength;
+	m_index.assign(m_windowLength * m_numChannels, 0);
+	m_key.assign(m_windowLength * m_numChannels, 0);
+	m_head.assign(m_numChannels, 0);
+	m_size.assign(m_numChannels, 1);
+	for (size_t c = 0; c < m_numChannels; c++)
+	{
+		m_index[c] = m_windowLength - 1;
+		m_key[c] = peakKey(0, m_mode, m_format.maxVal());
+	}
+}
+
+ExponentialAverage::ExponentialAverage(unsigned int shift,
+	unsigned int numChannels, FixedPointFormat inputFormat,
+	FixedPointFormat outputFormat, RoundingMode rounding, OverflowMode overflow)
+	: m_shift(shift),
+	m_numChannels(numChannels),
+	m_inputFormat(inputFormat),
+	m_accFormat(inputFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow)
+{
+	checkWindow(1, numChannels);
+	if (inputFormat.width() + shift + 1 > 62)
+	{
+		throw range_error("Accumulator exceeds 62 bits");
+	}
+	m_accFormat = FixedPointFormat(inputFormat.width() + shift + 1,
+		inputFormat.fracBits() + shift);
+	reset();
+}
+
+void ExponentialAverage::process(const MultichannelBuffer &in,
+	MultichannelBuffer &out, const MultichannelEngine &engine)
+{
+	checkBuffer(in, m_numChannels, m_inputFormat);
+	checkBuffer(out, m_numChannels, m_outputFormat);
+	out.resize(in.numFrames());
+
+	unsigned int fracBits = m_accFormat.fracBits();
+
+	engine.forEachGroup(m_numChannels, [&](unsigned int c0, unsigned int c1)
+	{
+		int64_t *acc = m_acc.data();
+		for (size_t f = 0; f < in.numFrames(); f++)
+		{
+			const int64_t *x = in.frame(f);
+			int64_t *y = out.frame(f);
+			for (size_t c = c0; c < c1; c++)
+			{
+				acc[c] += x[c] - roundShift(acc[c], m_shift, m_rounding);
+				y[c] = resizeValue(acc[c], fracBits, m_outputFormat, m_rounding,
+					m_overflow);
+			}
+		}
+	});
+}
+
+void ExponentialAverage::reset(void)
+{
+	m_acc.assign(m_numChannels, 0);
+}
@@ -0,0 +1,341 @@
+#include "TestVectorIO.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const size_t MAX_LINE_LENGTH = 256;
+static const size_t MIN_CHUNK_SIZE = 1 << 16;
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static void checkWidth(unsigned int width)
+{
+	if ((width == 0) || (width > (unsigned int)Fxp::MAX_WIDTH))
+	{
+		throw range_error("Width outside allowed range");
+	}
+}
+
+static uint64_t widthMask(unsigned int width)
+{
+	return (width >= 64) ? ~0ULL : ((1ULL << width) - 1);
+}
+
+TestVectorWriter::TestVectorWriter(const string &path, TestVectorFormat format,
+	unsigned int width)
+	: m_file(NULL),
+	m_format(format),
+	m_width(width),
+	m_buffer(BUFFER_SIZE),
+	m_used(0)
+{
+	checkWidth(width);
+	m_file = fopen(path.c_str(), "wb");
+	if (m_file == NULL)
+	{
+		throw runtime_error("Unable to open test vector file " + path);
+	}
+}
+
+TestVectorWriter::~TestVectorWriter()
+{
+	try
+	{
+		flush();
+	}
+	catch (...)
+	{
+	}
+	fclose(m_file);
+}
+
+void TestVectorWriter::write(int64_t v)
+{
+	reserve(MAX_LINE_LENGTH);
+	append(v);
+	endLine();
+}
+
+void TestVectorWriter::write(const Fxp &v)
+{
+	write(v.val());
+}
+
+void TestVectorWriter::write(const CFxp &v)
+{
+	reserve(MAX_LINE_LENGTH);
+	append(v.real());
+	m_buffer[m_used++] = ' ';
+	append(v.imag());
+	endLine();
+}
+
+void TestVectorWriter::write(const int64_t *v, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		write(v[i]);
+	}
+}
+
+void TestVectorWriter::flush(void)
+{
+	if (m_used > 0 && fwrite(&m_buffer[0], 1, m_used, m_file) != m_used)
+	{
+		throw runtime_error("Error writing test vector file");
+	}
+	m_used = 0;
+	fflush(m_file);
+}
+
+void TestVectorWriter::append(int64_t v)
+{
+	int64_t minVal = (m_width >= 64) ? INT64_MIN : -(1LL << (m_width - 1));
+	int64_t maxVal = (m_width >= 64) ? INT64_MAX : (1LL << (m_width - 1)) - 1;
+	if ((v < minVal) || (v > maxVal))
+	{
+		throw range_error("Values exceed size");
+	}
+
+	char *out = &m_buffer[m_used];
+	uint64_t bits = (uint64_t)v & widthMask(m_width);
+	if (m_format == TV_HEX)
+	{
+		unsigned int numDigits = (m_width + 3) / 4;
+		for (unsigned int i = 0; i < numDigits; i++)
+		{
+			out[numDigits - 1 - i] = HEX_DIGITS[(bits >> (4 * i)) & 0xF];
+		}
+		m_used += numDigits;
+	}
+	else if (m_format == TV_BINARY)
+	{
+		for (unsigned int i = 0; i < m_width; i++)
+		{
+			out[m_width - 1 - i] = '0' + ((bits >> i) & 0x1);
+		}
+		m_used += m_width;
+	}
+	else
+	{
+		to_chars_result result = to_chars(out, out + MAX_LINE_LENGTH / 2, v);
+		m_used += result.ptr - out;
+	}
+}
+
+void TestVectorWriter::endLine(void)
+{
+	m_buffer[m_used++] = '\n';
+}
+
+void TestVectorWriter::reserve(size_t n)
+{
+	if (m_used + n > m_buffer.size())
+	{
+		flush();
+	}
+}
+
+TestVectorReader::TestVectorReader(const string &path, TestVectorFormat format,
+	unsigned int width)
+	: m_format(format),
+	m_width(width),
+	m_data(NULL),
+	m_size(0)
+{
+	checkWidth(width);
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw runtime_error("Unable to open test vector file " + path);
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		throw runtime_error("Unable to stat test vector file " + path);
+	}
+
+	m_size = info.st_size;
+	if (m_size > 0)
+	{
+		void *data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			close(fd);
+			throw runtime_error("Unable to map test vector file " + path);
+		}
+		madvise(data, m_size, MADV_SEQUENTIAL);
+		m_data = (const char *)data;
+	}
+	close(fd);
+}
+
+TestVectorReader::~TestVectorReader()
+{
+	if (m_data != NULL)
+	{
+		munmap((void *)m_data, m_size);
+	}
+}
+
+vector<int64_t> TestVectorReader::readRaw(unsigned int numThreads) const
+{
+	if (numThreads == 0)
+	{
+		numThreads = defaultThreadCount();
+	}
+	size_t numChunks = min((size_t)numThreads, m_size / MIN_CHUNK_SIZE + 1);
+
+	/* Chunk boundaries are moved forward to the start of the next line */
+	vector<const char *> bounds(numChunks + 1);
+	bounds[0] = m_data;
+	bounds[numChunks] = m_data + m_size;
+	for (size_t c = 1; c < numChunks; c++)
+	{
+		const char *p = m_data + m_size * c / numChunks;
+		p = max(p, bounds[c - 1]);
+		const char *end = m_data + m_size;
+		while (p < end && p[-1] != '\n')
+		{
+			p++;
+		}
+		bounds[c] = p;
+	}
+
+	vector<vector<int64_t> > parts(numChunks);
+	parallelFor(0, numChunks, [&](size_t begin, size_t end, unsigned int)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			parseChunk(bounds[c], bounds[c + 1], parts[c]);
+		}
+	}, numChunks);
+
+	size_t total = 0;
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		total += parts[c].size();
+	}
+
+	vector<int64_t> values;
+	values.reserve(total);
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		values.insert(values.end(), parts[c].begin(), parts[c].end());
+	}
+	return values;
+}
+
+vector<Fxp> TestVectorReader::readFixedPoint(unsigned int fractionalBits,
+	unsigned int numThreads) const
+{
+	vector<int64_t> raw = readRaw(numThreads);
+	vector<Fxp> values;
+	values.reserve(raw.size());
+	for (size_t i = 0; i < raw.size(); i++)
+	{
+		values.push_back(Fxp(raw[i], m_width, fractionalBits));
+	}
+	return values;
+}
+
+vector<CFxp> TestVectorReader::readComplexFixedPoint(
+	unsigned int fractionalBits, unsigned int numThreads) const
+{
+	vector<int64_t> raw = readRaw(numThreads);
+	if (raw.size() % 2 != 0)
+	{
+		throw runtime_error("Complex test vector has odd number of values");
+	}
+
+	vector<CFxp> values;
+	values.reserve(raw.size() / 2);
+	for (size_t i = 0; i < raw.size(); i += 2)
+	{
+		values.push_back(CFxp(raw[i], raw[i + 1], m_width, fractionalBits));
+	}
+	return values;
+}
+
+void TestVectorReader::parseChunk(const char *begin, const char *end,
+	vector<int64_t> &out) const
+{
+	out.reserve((end - begin) / (m_format == TV_BINARY ? m_width + 1 : 4));
+
+	int64_t minVal = (m_width >= 64) ? INT64_MIN : -(1LL << (m_width - 1));
+	int64_t maxVal = (m_width >= 64) ? INT64_MAX : (1LL << (m_width - 1)) - 1;
+	int base = (m_format == TV_HEX) ? 16 : 2;
+
+	const char *p = begin;
+	while (p < end)
+	{
+		char c = *p;
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+		{
+			p++;
+			continue;
+		}
+
+		if (c == '/' && p + 1 < end && p[1] == '/')
+		{
+			while (p < end && *p != '\n')
+			{
+				p++;
+			}
+			continue;
+		}
+
+		const char *tokenEnd = p;
+		while (tokenEnd < end && *tokenEnd != ' ' && *tokenEnd != '\t'
+			&& *tokenEnd != '\r' && *tokenEnd != '\n')
+		{
+			tokenEnd++;
+		}
+
+		int64_t v;
+		from_chars_result result;
+		if (m_format == TV_DECIMAL)
+		{
+			result = from_chars(p, tokenEnd, v);
+		}
+		else
+		{
+			uint64_t bits;
+			result = from_chars(p, tokenEnd, bits, base);
+			if (result.ec == errc() && (bits & ~widthMask(m_width)) != 0)
+			{
+				throw range_error("Values exceed size");
+			}
+			if (m_width < 64 && ((bits >> (m_width - 1)) & 0x1))
+			{
+				bits |= ~widthMask(m_width);
+			}
+			v = (int64_t)bits;
+		}
+
+		if (result.ec == errc::result_out_of_range)
+		{
+			throw range_error("Values exceed size");
+		}
+		if (result.ec != errc() || result.ptr != tokenEnd)
+		{
+			throw runtime_error("Malformed value in test vector file: "
+				+ string(p, tokenEnd));
+		}
+		if ((v < minVal) || (v > maxVal))
+		{
+			throw range_error("Values exceed size");
+		}
+
+		out.push_back(v);
+		p = tokenEnd;
+	}
+}
@@ -0,0 +1,333 @@
+#include "ToneDetector.h"
+#include "CoefficientCache.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+GoertzelBank::GoertzelBank(const vector<double> &frequencies,
+	size_t blockLength, FixedPointFormat inputFormat,
+	FixedPointFormat coefFormat, FixedPointFormat stateFormat,
+	FixedPointFormat outputFormat, RoundingMode rounding,
+	OverflowMode overflow)
+	: m_numBins(frequencies.size()),
+	m_blockLength(blockLength),
+	m_inputFormat(inputFormat),
+	m_coefFormat(coefFormat),
+	m_stateFormat(stateFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow),
+	m_count(0)
+{
+	if (frequencies.empty())
+	{
+		throw runtime_error("Need at least one bin");
+	}
+	if (blockLength == 0)
+	{
+		throw range_error("Block length must be at least 1");
+	}
+	if (stateFormat.width() + coefFormat.width() + 2 > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+	if (stateFormat.fracBits() < inputFormat.fracBits())
+	{
+		throw range_error("State must hold the input's fractional bits");
+	}
+
+	vector<double> feedback(m_numBins);
+	vector<double> cosines(m_numBins);
+	vector<double> sines(m_numBins);
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		double w = 2 * M_PI * frequencies[k];
+		feedback[k] = 2 * cos(w);
+		cosines[k] = cos(w);
+		sines[k] = sin(w);
+	}
+	m_feedback = *CoefficientCache::quantize(feedback, coefFormat);
+	m_cos = *CoefficientCache::quantize(cosines, coefFormat);
+	m_sin = *CoefficientCache::quantize(sines, coefFormat);
+	reset();
+}
+
+void GoertzelBank::step(int64_t x, int64_t *s1, int64_t *s2)
+{
+	int64_t v = alignValue(x, m_inputFormat.fracBits(),
+		m_stateFormat.fracBits(), m_rounding);
+	unsigned int coefFracBits = m_coefFormat.fracBits();
+	unsigned int width = m_stateFormat.width();
+	const int64_t *c = m_feedback.data();
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		int64_t s = overflowValue(v + roundShift(c[k] * s1[k], coefFracBits,
+			m_rounding) - s2[k], width, m_overflow);
+		s2[k] = s1[k];
+		s1[k] = s;
+	}
+}
+
+void GoertzelBank::finish(complex<int64_t> *out)
+{
+	unsigned int coefFracBits = m_coefFormat.fracBits();
+	unsigned int fracBits = m_stateFormat.fracBits() + coefFracBits;
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		int64_t re = m_cos[k] * m_s1Real[k] - m_sin[k] * m_s1Imag[k]
+			- (m_s2Real[k] << coefFracBits);
+		int64_t im = m_cos[k] * m_s1Imag[k] + m_sin[k] * m_s1Real[k]
+			- (m_s2Imag[k] << coefFracBits);
+		out[k] = complex<int64_t>(
+			resizeValue(re, fracBits, m_outputFormat, m_rounding, m_overflow),
+			resizeValue(im, fracBits, m_outputFormat, m_rounding, m_overflow));
+	}
+	reset();
+}
+
+size_t GoertzelBank::process(const int64_t *in, size_t n,
+	vector<complex<int64_t> > &out)
+{
+	size_t numBlocks = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		/* Real input leaves the imaginary planes at zero */
+		step(in[i], m_s1Real.data(), m_s2Real.data());
+		if (++m_count == m_blockLength)
+		{
+			out.resize(out.size() + m_numBins);
+			finish(&out[out.size() - m_numBins]);
+			numBlocks++;
+		}
+	}
+	return numBlocks;
+}
+
+size_t GoertzelBank::process(const complex<int64_t> *in, size_t n,
+	vector<complex<int64_t> > &out)
+{
+	size_t numBlocks = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		step(in[i].real(), m_s1Real.data(), m_s2Real.data());
+		step(in[i].imag(), m_s1Imag.data(), m_s2Imag.data());
+		if (++m_count == m_blockLength)
+		{
+			out.resize(out.size() + m_numBins);
+			finish(&out[out.size() - m_numBins]);
+			numBlocks++;
+		}
+	}
+	return numBlocks;
+}
+
+/* Wraps raw bins as ComplexFixedPoint values in format */
+static void toComplexFixedPoint(const vector<complex<int64_t> > &raw,
+	FixedPointFormat format, vector<CFxp> &bins)
+{
+	bins.clear();
+	bins.reserve(raw.size());
+	for (size_t k = 0; k < raw.size(); k++)
+	{
+		bins.emplace_back(raw[k], format.width(), format.fracBits());
+	}
+}
+
+bool GoertzelBank::process(const Fxp &x, vector<CFxp> &bins)
+{
+	if (x.format() != m_inputFormat)
+	{
+		throw runtime_error("Sample format does not match bank");
+	}
+	int64_t v = x.val();
+	vector<complex<int64_t> > raw;
+	if (process(&v, 1, raw) == 0)
+	{
+		return false;
+	}
+	toComplexFixedPoint(raw, m_outputFormat, bins);
+	return true;
+}
+
+bool GoertzelBank::process(const CFxp &x, vector<CFxp> &bins)
+{
+	if (x.format() != m_inputFormat)
+	{
+		throw runtime_error("Sample format does not match bank");
+	}
+	complex<int64_t> v(x.real(), x.imag());
+	vector<complex<int64_t> > raw;
+	if (process(&v, 1, raw) == 0)
+	{
+		return false;
+	}
+	toComplexFixedPoint(raw, m_outputFormat, bins);
+	return true;
+}
+
+void GoertzelBank::reset(void)
+{
+	m_s1Real.assign(m_numBins, 0);
+	m_s2Real.assign(m_numBins, 0);
+	m_s1Imag.assign(m_numBins, 0);
+	m_s2Imag.assign(m_numBins, 0);
+	m_count = 0;
+}
+
+SlidingDftBank::SlidingDftBank(const vector<size_t> &bins, size_t length,
+	FixedPointFormat inputFormat, FixedPointFormat coefFormat,
+	FixedPointFormat stateFormat, FixedPointFormat outputFormat,
+	double damping, RoundingMode rounding, OverflowMode overflow)
+	: m_numBins(bins.size()),
+	m_length(length),
+	m_inputFormat(inputFormat),
+	m_coefFormat(coefFormat),
+	m_stateFormat(stateFormat),
+	m_outputFormat(outputFormat),
+	m_rounding(rounding),
+	m_overflow(overflow),
+	m_comb(0),
+	m_position(0)
+{
+	if (bins.empty())
+	{
+		throw runtime_error("Need at least one bin");
+	}
+	if (length == 0)
+	{
+		throw range_error("Length must be at least 1");
+	}
+	if (!(damping > 0.0 && damping <= 1.0))
+	{
+		throw range_error("Damping must be in (0, 1]");
+	}
+	if (stateFormat.width() + coefFormat.width() + 2 > 63
+		|| inputFormat.width() + coefFormat.width() + 1 > 63)
+	{
+		throw range_error("Intermediate width exceeds 63 bits");
+	}
+	if (stateFormat.fracBits() < inputFormat.fracBits())
+	{
+		throw range_error("State must hold the input's fractional bits");
+	}
+
+	vector<double> real(m_numBins);
+	vector<double> imag(m_numBins);
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		double w = 2 * M_PI * (double)(bins[k] % length) / length;
+		real[k] = damping * cos(w);
+		imag[k] = damping * sin(w);
+	}
+	m_twiddleReal = *CoefficientCache::quantize(real, coefFormat);
+	m_twiddleImag = *CoefficientCache::quantize(imag, coefFormat);
+	m_comb = (*CoefficientCache::quantize(
+		vector<double>(1, pow(damping, (double)length)), coefFormat))[0];
+
+	/* |twiddle| < 1 exactly, in integers */
+	unsigned __int128 one = (unsigned __int128)1 << (2 * coefFormat.fracBits());
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		__int128 re = m_twiddleReal[k];
+		__int128 im = m_twiddleImag[k];
+		if ((unsigned __int128)(re * re + im * im) >= one)
+		{
+			throw range_error("Damped twiddles must lie inside the unit circle");
+		}
+	}
+	reset();
+}
+
+void SlidingDftBank::step(complex<int64_t> x, complex<int64_t> *out)
+{
+	/* Comb: x[n] - r^length x[n - length], rounded to the state LSB */
+	complex<int64_t> &oldest = m_history[m_position];
+	unsigned int coefFracBits = m_coefFormat.fracBits();
+	unsigned int combFracBits = m_inputFormat.fracBits() + coefFracBits;
+	unsigned int stateFracBits = m_stateFormat.fracBits();
+	int64_t dr = alignValue((x.real() << coefFracBits) - m_comb * oldest.real(),
+		combFracBits, stateFracBits, m_rounding);
+	int64_t di = alignValue((x.imag() << coefFracBits) - m_comb * oldest.imag(),
+		combFracBits, stateFracBits, m_rounding);
+	oldest = x;
+	if (++m_position == m_length)
+	{
+		m_position = 0;
+	}
+
+	unsigned int width = m_stateFormat.width();
+	const int64_t *wr = m_twiddleReal.data();
+	const int64_t *wi = m_twiddleImag.data();
+	int64_t *sr = m_stateReal.data();
+	int64_t *si = m_stateImag.data();
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		int64_t ur = sr[k] + dr;
+		int64_t ui = si[k] + di;
+		sr[k] = overflowValue(roundShift(wr[k] * ur - wi[k] * ui, coefFracBits,
+			m_rounding), width, m_overflow);
+		si[k] = overflowValue(roundShift(wr[k] * ui + wi[k] * ur, coefFracBits,
+			m_rounding), width, m_overflow);
+	}
+	for (size_t k = 0; k < m_numBins; k++)
+	{
+		out[k] = complex<int64_t>(
+			resizeValue(sr[k], stateFracBits, m_outputFormat, m_rounding,
+				m_overflow),
+			resizeValue(si[k], stateFracBits, m_outputFormat, m_rounding,
+				m_overflow));
+	}
+}
+
+void SlidingDftBank::process(const int64_t *in, size_t n,
+	vector<complex<int64_t> > &out)
+{
+	size_t first = out.size();
+	out.resize(first + n * m_numBins);
+	for (size_t i = 0; i < n; i++)
+	{
+		step(complex<int64_t>(in[i], 0), &out[first + i * m_numBins]);
+	}
+}
+
+void SlidingDftBank::process(const complex<int64_t> *in, size_t n,
+	vector<complex<int64_t> > &out)
+{
+	size_t first = out.size();
+	out.resize(first + n * m_numBins);
+	for (size_t i = 0; i < n; i++)
+	{
+		step(in[i], &out[first + i * m_numBins]);
+	}
+}
+
+void SlidingDftBank::process(const Fxp &x, vector<CFxp> &bins)
+{
+	if (x.format() != m_inputFormat)
+	{
+		throw runtime_error("Sample format does not match bank");
+	}
+	vector<complex<int64_t> > raw(m_numBins);
+	step(complex<int64_t>(x.val(), 0), raw.data());
+	toComplexFixedPoint(raw, m_outputFormat, bins);
+}
+
+void SlidingDftBank::process(const CFxp &x, vector<CFxp> &bins)
+{
+	if (x.format() != m_inputFormat)
+	{
+		throw runtime_error("Sample format does not match bank");
+	}
+	vector<complex<int64_t> > raw(m_numBins);
+	step(complex<int64_t>(x.real(), x.imag()), raw.data());
+	toComplexFixedPoint(raw, m_outputFormat, bins);
+}
+
+void SlidingDftBank::reset(void)
+{
+	m_stateReal.assign(m_numBins, 0);
+	m_stateImag.assign(m_numBins, 0);
+	m_history.assign(m_length, complex<int64_t>(0, 0));
+	m_position = 0;
+}
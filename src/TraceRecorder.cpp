@@ -0,0 +1,514 @@
+#include "TraceRecorder.h"
+#include "Parallel.h"
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+static const char MAGIC[8] = { 'F', 'X', 'P', 'T', 'R', 'C', '0', '1' };
+static const char SIGNAL_RECORD = 'S';
+static const char DATA_RECORD = 'D';
+
+template <typename T>
+static void append(vector<char> &out, T v)
+{
+	size_t used = out.size();
+	out.resize(used + sizeof(T));
+	memcpy(&out[used], &v, sizeof(T));
+}
+
+TraceSignal::TraceSignal(TraceRecorder &recorder, uint32_t id,
+	const string &name, FixedPointFormat format, bool isComplex,
+	const TraceFilter &filter)
+	: m_recorder(recorder),
+	m_id(id),
+	m_name(name),
+	m_format(format),
+	m_complex(isComplex),
+	m_filter(filter),
+	m_count(0),
+	m_next(filter.firstSample),
+	m_blockFirst(0),
+	m_blockSamples(0)
+{
+	if (filter.decimation == 0)
+	{
+		throw range_error("Trace decimation must be at least 1");
+	}
+	m_block.reserve(BLOCK_SAMPLES * (isComplex ? 2 : 1));
+}
+
+/* Counts one sample and tells whether the filter keeps it */
+bool TraceSignal::keep(void)
+{
+	if (m_recorder.m_file == NULL)
+	{
+		throw runtime_error("Trace signal " + m_name + " recorded after close");
+	}
+	uint64_t n = m_count++;
+	if (n != m_next || n >= m_filter.endSample)
+	{
+		return false;
+	}
+	m_next += m_filter.decimation;
+	if (m_blockSamples == 0)
+	{
+		m_blockFirst = n;
+	}
+	return true;
+}
+
+void TraceSignal::record(int64_t v)
+{
+	if (m_complex)
+	{
+		throw runtime_error("Real value traced on complex signal " + m_name);
+	}
+	if (keep())
+	{
+		m_block.push_back(v);
+		if (++m_blockSamples == BLOCK_SAMPLES)
+		{
+			submit();
+		}
+	}
+}
+
+void TraceSignal::record(int64_t re, int64_t im)
+{
+	if (!m_complex)
+	{
+		throw runtime_error("Complex value traced on real signal " + m_name);
+	}
+	if (keep())
+	{
+		m_block.push_back(re);
+		m_block.push_back(im);
+		if (++m_blockSamples == BLOCK_SAMPLES)
+		{
+			submit();
+		}
+	}
+}
+
+void TraceSignal::record(const int64_t *v, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		record(v[i]);
+	}
+}
+
+void TraceSignal::record(const Fxp &v)
+{
+	if (v.format() != m_format)
+	{
+		throw runtime_error("Traced value format does not match signal "
+			+ m_name);
+	}
+	record(v.val());
+}
+
+void TraceSignal::record(const CFxp &v)
+{
+	if (v.format() != m_format)
+	{
+		throw runtime_error("Traced value format does not match signal "
+			+ m_name);
+	}
+	record(v.real(), v.imag());
+}
+
+void TraceSignal::submit(void)
+{
+	if (m_recorder.m_file == NULL)
+	{
+		throw runtime_error("Trace signal " + m_name
+			+ " submitted after close");
+	}
+	if (m_blockSamples == 0)
+	{
+		return;
+	}
+	vector<char> record;
+	record.reserve(25 + m_block.size() * sizeof(int64_t));
+	append(record, DATA_RECORD);
+	append(record, m_id);
+	append(record, m_blockFirst);
+	append(record, m_filter.decimation);
+	append(record, (uint32_t)m_blockSamples);
+	size_t used = record.size();
+	record.resize(used + m_block.size() * sizeof(int64_t));
+	memcpy(&record[used], m_block.data(), m_block.size() * sizeof(int64_t));
+	m_recorder.enqueue(record);
+
+	m_block.clear();
+	m_blockSamples = 0;
+}
+
+TraceRecorder::TraceRecorder(const string &path)
+	: m_file(NULL),
+	m_writing(false),
+	m_stop(false),
+	m_failed(false)
+{
+	m_file = fopen(path.c_str(), "wb");
+	if (m_file == NULL)
+	{
+		throw runtime_error("Unable to open trace file " + path);
+	}
+	if (fwrite(MAGIC, 1, sizeof(MAGIC), m_file) != sizeof(MAGIC))
+	{
+		fclose(m_file);
+		throw runtime_error("Unable to write trace file " + path);
+	}
+	m_writer = thread(&TraceRecorder::writerLoop, this);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+	}
+}
+
+TraceSignal &TraceRecorder::addSignal(const string &name,
+	FixedPointFormat format, bool isComplex, const TraceFilter &filter)
+{
+	if (m_file == NULL)
+	{
+		throw runtime_error("Trace signal " + name + " added after close");
+	}
+	if (name.size() > 0xFFFF)
+	{
+		throw runtime_error("Trace signal name too long");
+	}
+
+	TraceSignal *signal;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_signals.size(); i++)
+		{
+			if (m_signals[i]->name() == name)
+			{
+				throw runtime_error("Duplicate trace signal " + name);
+			}
+		}
+		signal = new TraceSignal(*this, (uint32_t)m_signals.size(), name,
+			format, isComplex, filter);
+		m_signals.push_back(unique_ptr<TraceSignal>(signal));
+	}
+
+	vector<char> record;
+	append(record, SIGNAL_RECORD);
+	append(record, signal->m_id);
+	append(record, (uint8_t)format.width());
+	append(record, (uint8_t)format.fracBits());
+	append(record, (uint8_t)isComplex);
+	append(record, (uint16_t)name.size());
+	record.insert(record.end(), name.begin(), name.end());
+	enqueue(record);
+	return *signal;
+}
+
+void TraceRecorder::enqueue(vector<char> &record)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_queue.push_back(vector<char>());
+	m_queue.back().swap(record);
+	m_ready.notify_one();
+}
+
+void TraceRecorder::writerLoop(void)
+{
+	unique_lock<mutex> lock(m_mutex);
+	while (true)
+	{
+		m_ready.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+		if (m_queue.empty())
+		{
+			return;
+		}
+		vector<char> record;
+		record.swap(m_queue.front());
+		m_queue.pop_front();
+		m_writing = true;
+
+		lock.unlock();
+		bool ok = fwrite(record.data(), 1, record.size(), m_file)
+			== record.size();
+		lock.lock();
+
+		m_writing = false;
+		m_failed = m_failed || !ok;
+		if (m_queue.empty())
+		{
+			m_drained.notify_all();
+		}
+	}
+}
+
+void TraceRecorder::flush(void)
+{
+	if (m_file == NULL)
+	{
+		return;
+	}
+	for (size_t i = 0; i < m_signals.size(); i++)
+	{
+		m_signals[i]->submit();
+	}
+	unique_lock<mutex> lock(m_mutex);
+	m_drained.wait(lock, [this]() { return m_queue.empty() && !m_writing; });
+	if (fflush(m_file) != 0)
+	{
+		m_failed = true;
+	}
+}
+
+void TraceRecorder::close(void)
+{
+	if (m_file == NULL)
+	{
+		return;
+	}
+	flush();
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+		m_ready.notify_one();
+	}
+	m_writer.join();
+	bool failed = (fclose(m_file) != 0) || m_failed;
+	m_file = NULL;
+	if (failed)
+	{
+		throw runtime_error("Unable to write trace file");
+	}
+}
+
+/* Bounds-checked reads from the file image */
+class TraceParser
+{
+public:
+
+	TraceParser(const vector<char> &data) : m_data(data), m_pos(0) {}
+
+	bool done(void) const { return m_pos == m_data.size(); }
+
+	template <typename T>
+	T read(void)
+	{
+		T v;
+		take(&v, sizeof(T));
+		return v;
+	}
+
+	void take(void *dest, size_t n)
+	{
+		if (n > m_data.size() - m_pos)
+		{
+			throw runtime_error("Truncated trace file");
+		}
+		memcpy(dest, &m_data[m_pos], n);
+		m_pos += n;
+	}
+
+private:
+
+	const vector<char> &m_data;
+	size_t m_pos;
+};
+
+TraceReader::TraceReader(const string &path)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		throw runtime_error("Unable to open trace file " + path);
+	}
+	vector<char> data;
+	char buffer[1 << 16];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+
+	TraceParser parser(data);
+	char magic[sizeof(MAGIC)];
+	if (data.size() < sizeof(MAGIC))
+	{
+		throw runtime_error("Not a trace file " + path);
+	}
+	parser.take(magic, sizeof(magic));
+	if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		throw runtime_error("Not a trace file " + path);
+	}
+
+	map<uint32_t, size_t> index;
+	while (!parser.done())
+	{
+		char type = parser.read<char>();
+		uint32_t id = parser.read<uint32_t>();
+		if (type == SIGNAL_RECORD)
+		{
+			unsigned int width = parser.read<uint8_t>();
+			unsigned int fracBits = parser.read<uint8_t>();
+			bool isComplex = parser.read<uint8_t>() != 0;
+			string name(parser.read<uint16_t>(), '\0');
+			parser.take(&name[0], name.size());
+			index[id] = m_signals.size();
+			m_signals.push_back(TraceSignalData(name,
+				FixedPointFormat(width, fracBits), isComplex));
+		}
+		else if (type == DATA_RECORD)
+		{
+			map<uint32_t, size_t>::const_iterator it = index.find(id);
+			if (it == index.end())
+			{
+				throw runtime_error("Trace data for undefined signal");
+			}
+			TraceSignalData &signal = m_signals[it->second];
+			uint64_t first = parser.read<uint64_t>();
+			uint64_t stride = parser.read<uint64_t>();
+			uint32_t count = parser.read<uint32_t>();
+			size_t numValues = (size_t)count * (signal.isComplex ? 2 : 1);
+			size_t used = signal.values.size();
+			signal.values.resize(used + numValues);
+			parser.take(&signal.values[used], numValues * sizeof(int64_t));
+			for (uint32_t k = 0; k < count; k++)
+			{
+				signal.samples.push_back(first + k * stride);
+			}
+		}
+		else
+		{
+			throw runtime_error("Corrupt trace file " + path);
+		}
+	}
+}
+
+const TraceSignalData *TraceReader::find(const string &name) const
+{
+	for (size_t i = 0; i < m_signals.size(); i++)
+	{
+		if (m_signals[i].name == name)
+		{
+			return &m_signals[i];
+		}
+	}
+	return NULL;
+}
+
+static string describeValue(const TraceSignalData &s, size_t k)
+{
+	ostringstream out;
+	double scale = 1.0 / powerOfTwo(s.format.fracBits());
+	if (s.isComplex)
+	{
+		int64_t re = s.values[2 * k];
+		int64_t im = s.values[2 * k + 1];
+		out << "(" << re << ", " << im << ") = (" << re * scale << ", "
+			<< im * scale << ")";
+	}
+	else
+	{
+		out << s.values[k] << " = " << s.values[k] * scale;
+	}
+	return out.str();
+}
+
+static string describeFormat(const TraceSignalData &s)
+{
+	ostringstream out;
+	out << (s.isComplex ? "complex " : "") << "(" << s.format.width() << ", "
+		<< s.format.fracBits() << ")";
+	return out.str();
+}
+
+/* First mismatch of one signal: a merge join over the sample indices */
+static TraceMismatch compareSignal(const TraceSignalData &e,
+	const TraceSignalData *a)
+{
+	TraceMismatch m = { false, e.name, 0, "", 0 };
+	if (a == NULL)
+	{
+		m.found = true;
+		m.description = "missing from actual trace";
+		return m;
+	}
+	if (a->format != e.format || a->isComplex != e.isComplex)
+	{
+		m.found = true;
+		m.description = "format " + describeFormat(e) + " expected, "
+			+ describeFormat(*a) + " actual";
+		return m;
+	}
+
+	size_t perSample = e.isComplex ? 2 : 1;
+	size_t i = 0, j = 0;
+	while (i < e.samples.size() && j < a->samples.size())
+	{
+		if (e.samples[i] < a->samples[j])
+		{
+			i++;
+		}
+		else if (a->samples[j] < e.samples[i])
+		{
+			j++;
+		}
+		else
+		{
+			m.numCompared++;
+			if (memcmp(&e.values[i * perSample], &a->values[j * perSample],
+				perSample * sizeof(int64_t)) != 0)
+			{
+				m.found = true;
+				m.sample = e.samples[i];
+				m.description = "expected " + describeValue(e, i) + ", actual "
+					+ describeValue(*a, j);
+				return m;
+			}
+			i++;
+			j++;
+		}
+	}
+	return m;
+}
+
+TraceMismatch compareTraces(const TraceReader &expected,
+	const TraceReader &actual, unsigned int numThreads)
+{
+	const vector<TraceSignalData> &signals = expected.signals();
+	vector<TraceMismatch> results(signals.size());
+	parallelFor(0, signals.size(), [&](size_t begin, size_t end, unsigned int)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			results[i] = compareSignal(signals[i], actual.find(signals[i].name));
+		}
+	}, numThreads);
+
+	TraceMismatch first = { false, "", 0, "", 0 };
+	uint64_t compared = 0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		compared += results[i].numCompared;
+		if (results[i].found && (!first.found
+			|| results[i].sample < first.sample))
+		{
+			first = results[i];
+		}
+	}
+	first.numCompared = compared;
+	return first;
+}
@@ -0,0 +1,316 @@
+#include "WordLengthOptimizer.h"
+#include "Parallel.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+WordLengthOptimizer::WordLengthOptimizer(const Model &model,
+	const vector<WordLengthSignal> &signals, const vector<double> &stimulus,
+	FixedPointFormat stimulusFormat, unsigned int numThreads)
+	: m_model(model),
+	m_signals(signals),
+	m_numThreads(numThreads),
+	m_haveReference(false),
+	m_numSimulations(0)
+{
+	for (size_t i = 0; i < signals.size(); i++)
+	{
+		const WordLengthSignal &s = signals[i];
+		if (s.minFracBits > s.maxFracBits || s.integerBits + s.minFracBits == 0
+			|| s.integerBits + s.maxFracBits > FixedPoint::MAX_WIDTH)
+		{
+			throw range_error("Invalid search range for signal " + s.name);
+		}
+	}
+
+	/* Quantized once and shared by every simulation */
+	m_stimulus.reserve(stimulus.size());
+	for (size_t i = 0; i < stimulus.size(); i++)
+	{
+		m_stimulus.push_back(Fxp::quantize(stimulus[i], stimulusFormat.width(),
+			stimulusFormat.fracBits()));
+	}
+}
+
+unsigned int WordLengthOptimizer::integerBitsFor(double minVal, double maxVal)
+{
+	unsigned int bits = 1;
+	while (bits < 64 && (minVal < -ldexp(1.0, bits - 1)
+		|| maxVal >= ldexp(1.0, bits - 1)))
+	{
+		bits++;
+	}
+	return bits;
+}
+
+void WordLengthOptimizer::setReference(const vector<double> &reference)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_reference = reference;
+	m_haveReference = true;
+	m_cache.clear();
+}
+
+vector<FixedPointFormat> WordLengthOptimizer::formats(
+	const vector<unsigned int> &fracBits) const
+{
+	if (fracBits.size() != m_signals.size())
+	{
+		throw runtime_error("Need fractional bits for every signal");
+	}
+	vector<FixedPointFormat> result;
+	for (size_t i = 0; i < m_signals.size(); i++)
+	{
+		result.push_back(FixedPointFormat(m_signals[i].integerBits + fracBits[i],
+			fracBits[i]));
+	}
+	return result;
+}
+
+void WordLengthOptimizer::ensureReference(void)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if (m_haveReference)
+		{
+			return;
+		}
+	}
+	vector<unsigned int> maxBits;
+	for (size_t i = 0; i < m_signals.size(); i++)
+	{
+		maxBits.push_back(m_signals[i].maxFracBits);
+	}
+	vector<double> reference = m_model(formats(maxBits), m_stimulus);
+
+	lock_guard<mutex> lock(m_mutex);
+	m_reference = reference;
+	m_haveReference = true;
+	m_numSimulations++;
+}
+
+WordLengthOptimizer::ErrorStats WordLengthOptimizer::simulate(
+	const vector<unsigned int> &fracBits)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		map<vector<unsigned int>, ErrorStats>::const_iterator it =
+			m_cache.find(fracBits);
+		if (it != m_cache.end())
+		{
+			return it->second;
+		}
+	}
+
+	ErrorStats stats;
+	stats.signalPower = 0;
+	stats.noisePower = 0;
+	stats.maxError = 0;
+	try
+	{
+		vector<double> out = m_model(formats(fracBits), m_stimulus);
+		if (out.size() != m_reference.size())
+		{
+			throw runtime_error("Model output length does not match reference");
+		}
+		for (size_t i = 0; i < out.size(); i++)
+		{
+			double error = out[i] - m_reference[i];
+			stats.signalPower += m_reference[i] * m_reference[i];
+			stats.noisePower += error * error;
+			stats.maxError = max(stats.maxError, fabs(error));
+		}
+	}
+	catch (const range_error &)
+	{
+		stats.noisePower = numeric_limits<double>::infinity();
+		stats.maxError = numeric_limits<double>::infinity();
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	m_cache[fracBits] = stats;
+	m_numSimulations++;
+	return stats;
+}
+
+vector<WordLengthOptimizer::ErrorStats> WordLengthOptimizer::simulateAll(
+	const vector<vector<unsigned int> > &candidates)
+{
+	vector<ErrorStats> results(candidates.size());
+	parallelFor(0, candidates.size(), [&](size_t begin, size_t end,
+		unsigned int)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			results[i] = simulate(candidates[i]);
+		}
+	}, m_numThreads);
+	return results;
+}
+
+double WordLengthOptimizer::metricValue(const ErrorStats &stats,
+	AccuracyMetric metric)
+{
+	if (metric == METRIC_MAX_ERROR)
+	{
+		return stats.maxError;
+	}
+	if (stats.noisePower == 0)
+	{
+		return numeric_limits<double>::infinity();
+	}
+	return 10 * log10(stats.signalPower / stats.noisePower);
+}
+
+bool WordLengthOptimizer::meets(const ErrorStats &stats,
+	AccuracyMetric metric, double target)
+{
+	double value = metricValue(stats, metric);
+	return (metric == METRIC_MAX_ERROR) ? value <= target : value >= target;
+}
+
+double WordLengthOptimizer::evaluate(const vector<unsigned int> &fracBits,
+	AccuracyMetric metric)
+{
+	ensureReference();
+	return metricValue(simulate(fracBits), metric);
+}
+
+WordLengthResult WordLengthOptimizer::optimize(AccuracyMetric metric,
+	double target)
+{
+	ensureReference();
+	size_t numSignals = m_signals.size();
+	vector<unsigned int> maxBits(numSignals);
+	for (size_t i = 0; i < numSignals; i++)
+	{
+		maxBits[i] = m_signals[i].maxFracBits;
+	}
+	if (!meets(simulate(maxBits), metric, target))
+	{
+		throw runtime_error("Accuracy target not reachable at maximum widths");
+	}
+
+	/* Smallest fractional bits of each signal with all others at maximum.
+	 * Reducing other signals only adds error, so these are lower bounds. */
+	vector<unsigned int> lower(numSignals);
+	parallelFor(0, numSignals, [&](size_t begin, size_t end, unsigned int)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			unsigned int lo = m_signals[i].minFracBits;
+			unsigned int hi = m_signals[i].maxFracBits;
+			while (lo < hi)
+			{
+				unsigned int mid = lo + (hi - lo) / 2;
+				vector<unsigned int> candidate(maxBits);
+				candidate[i] = mid;
+				if (meets(simulate(candidate), metric, target))
+				{
+					hi = mid;
+				}
+				else
+				{
+					lo = mid + 1;
+				}
+			}
+			lower[i] = lo;
+		}
+	}, m_numThreads);
+
+	/* Combined, the bounds usually miss the target: add a bit where it
+	 * buys the most accuracy per unit cost */
+	vector<unsigned int> current(lower);
+	ErrorStats stats = simulate(current);
+	while (!meets(stats, metric, target))
+	{
+		vector<vector<unsigned int> > candidates;
+		vector<size_t> signalIndex;
+		for (size_t i = 0; i < numSignals; i++)
+		{
+			if (current[i] < maxBits[i])
+			{
+				candidates.push_back(current);
+				candidates.back()[i]++;
+				signalIndex.push_back(i);
+			}
+		}
+		vector<ErrorStats> results = simulateAll(candidates);
+
+		double currentQuality = (metric == METRIC_MAX_ERROR)
+			? -metricValue(stats, metric) : metricValue(stats, metric);
+		size_t best = 0;
+		double bestGain = -numeric_limits<double>::infinity();
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			double quality = (metric == METRIC_MAX_ERROR)
+				? -metricValue(results[c], metric)
+				: metricValue(results[c], metric);
+			double gain = (quality - currentQuality)
+				/ m_signals[signalIndex[c]].cost;
+			if (meets(results[c], metric, target))
+			{
+				gain = numeric_limits<double>::infinity();
+			}
+			if (gain > bestGain)
+			{
+				bestGain = gain;
+				best = c;
+			}
+		}
+		current = candidates[best];
+		stats = results[best];
+	}
+
+	/* Remove bits while the target holds, largest saving first */
+	while (true)
+	{
+		vector<vector<unsigned int> > candidates;
+		vector<size_t> signalIndex;
+		for (size_t i = 0; i < numSignals; i++)
+		{
+			if (current[i] > lower[i])
+			{
+				candidates.push_back(current);
+				candidates.back()[i]--;
+				signalIndex.push_back(i);
+			}
+		}
+		vector<ErrorStats> results = simulateAll(candidates);
+
+		size_t best = candidates.size();
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			if (!meets(results[c], metric, target))
+			{
+				continue;
+			}
+			if (best == candidates.size()
+				|| m_signals[signalIndex[c]].cost
+					> m_signals[signalIndex[best]].cost)
+			{
+				best = c;
+			}
+		}
+		if (best == candidates.size())
+		{
+			break;
+		}
+		current = candidates[best];
+		stats = results[best];
+	}
+
+	WordLengthResult result;
+	result.formats = formats(current);
+	result.metric = metricValue(stats, metric);
+	result.cost = 0;
+	for (size_t i = 0; i < numSignals; i++)
+	{
+		result.cost += m_signals[i].cost * result.formats[i].width();
+	}
+	lock_guard<mutex> lock(m_mutex);
+	result.numSimulations = m_numSimulations;
+	return result;
+}
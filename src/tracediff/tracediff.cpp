@@ -0,0 +1,52 @@
+/* Compares two trace files written by TraceRecorder and reports the first
+ * mismatching signal and sample. Only samples present in both files are
+ * compared. Exits 0 when the traces match, 1 on a mismatch and 2 on
+ * errors. */
+#include "TraceRecorder.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+static void usage(const char *argv0)
+{
+	cerr << "usage: " << argv0 << " [--threads N] expected.trc actual.trc\n";
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int threads = 0;
+	int first = 1;
+	if (argc == 5 && !strcmp(argv[1], "--threads"))
+	{
+		threads = strtoul(argv[2], NULL, 0);
+		first = 3;
+	}
+	else if (argc != 3)
+	{
+		usage(argv[0]);
+	}
+
+	try
+	{
+		TraceReader expected(argv[first]);
+		TraceReader actual(argv[first + 1]);
+		TraceMismatch m = compareTraces(expected, actual, threads);
+		if (m.found)
+		{
+			cout << "mismatch in " << m.signal << " at sample " << m.sample
+				<< ": " << m.description << endl;
+			return 1;
+		}
+		cout << "traces match: " << m.numCompared << " samples of "
+			<< expected.signals().size() << " signals compared" << endl;
+		return 0;
+	}
+	catch (const exception &e)
+	{
+		cerr << e.what() << endl;
+		return 2;
+	}
+}
@@ -0,0 +1,199 @@
+#include "boost_test.h"
+#include "AdaptiveFilter.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+/* x uniform over half of full scale, d = h * x in the data format */
+static void makeSystem(const vector<double> &h, size_t n, vector<int64_t> &x,
+	vector<int64_t> &d)
+{
+	Xoshiro256 rng(11);
+	x.resize(n);
+	d.resize(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		x[i] = rng.uniform(-(1 << 14), (1 << 14) - 1);
+		double sum = 0;
+		for (size_t k = 0; k < h.size() && k <= i; k++)
+		{
+			sum += h[k] * x[i - k];
+		}
+		d[i] = (int64_t)floor(sum + 0.5);
+	}
+}
+
+static void checkConverged(const vector<int64_t> &weights,
+	const vector<double> &h, FixedPointFormat format, double tolerance)
+{
+	for (size_t k = 0; k < weights.size(); k++)
+	{
+		double expected = (k < h.size()) ? h[k] : 0.0;
+		double actual = weights[k] / pow(2.0, format.fracBits());
+		BOOST_CHECK_SMALL(actual - expected, tolerance);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveFilterMatchesReference )
+{
+	/* Unfused leaky LMS: filter, error, then update every weight */
+	AdaptiveFilterConfig config(5, ADAPT_LEAKY_LMS, 1.0 / 16);
+	config.leakage = 1.0 / 4096;
+	AdaptiveFilter filter(config);
+
+	vector<double> h;
+	h.push_back(0.5);
+	h.push_back(-0.25);
+	h.push_back(0.125);
+	vector<int64_t> x, d;
+	makeSystem(h, 500, x, d);
+
+	vector<int64_t> w(5, 0);
+	vector<int64_t> used;
+	int64_t mu = 8192;
+	int64_t leak = 32;
+	for (size_t n = 0; n < x.size(); n++)
+	{
+		int64_t sum = 0;
+		for (size_t k = 0; k < w.size() && k <= n; k++)
+		{
+			sum += w[k] * x[n - k];
+		}
+		int64_t y = saturateValue(roundShift(sum, 17, ROUND_HALF_UP), 24);
+		int64_t e = saturateValue(roundShift((d[n] << 5) - y, 5,
+			ROUND_HALF_UP), 18);
+		int64_t g = saturateValue(roundShift(mu * e, 17, ROUND_HALF_UP), 18);
+		used = w;
+		for (size_t k = 0; k < w.size(); k++)
+		{
+			int64_t xk = (k <= n) ? x[n - k] : 0;
+			w[k] = saturateValue(w[k] - roundShift(w[k] * leak, 17,
+				ROUND_HALF_UP) + roundShift(g * xk, 8, ROUND_HALF_UP), 24);
+		}
+
+		BOOST_CHECK_EQUAL(filter.process(x[n], d[n]), y);
+		BOOST_CHECK_EQUAL(filter.error(), e);
+	}
+	/* The last update is applied at the start of the next sample */
+	BOOST_CHECK(filter.weights() == used);
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveFilterConverges )
+{
+	vector<double> h;
+	h.push_back(0.5);
+	h.push_back(-0.25);
+	h.push_back(0.125);
+	h.push_back(0.0625);
+	vector<int64_t> x, d;
+	makeSystem(h, 6000, x, d);
+
+	AdaptiveAlgorithm algorithms[3] = { ADAPT_LMS, ADAPT_NLMS,
+		ADAPT_SIGN_ERROR };
+	double steps[3] = { 1.0 / 8, 1.0 / 4, 1.0 / 1024 };
+	for (int a = 0; a < 3; a++)
+	{
+		for (unsigned int delay = 0; delay < 4; delay += 3)
+		{
+			AdaptiveFilterConfig config(8, algorithms[a], steps[a]);
+			config.updateDelay = delay;
+			AdaptiveFilter filter(config);
+			vector<int64_t> e(x.size());
+			filter.process(&x[0], &d[0], NULL, &e[0], x.size());
+			checkConverged(filter.weights(), h, config.weightFormat, 0.002);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveFilterBlocksAndLeakage )
+{
+	vector<double> h(1, 0.75);
+	vector<int64_t> x, d;
+	makeSystem(h, 300, x, d);
+
+	/* Block size does not change the result */
+	AdaptiveFilterConfig config(4, ADAPT_NLMS, 0.5);
+	config.updateDelay = 2;
+	AdaptiveFilter whole(config);
+	AdaptiveFilter pieces(config);
+	vector<int64_t> y1(x.size()), y2(x.size());
+	whole.process(&x[0], &d[0], &y1[0], NULL, x.size());
+	for (size_t i = 0; i < x.size(); i += 7)
+	{
+		size_t n = min((size_t)7, x.size() - i);
+		pieces.process(&x[i], &d[i], &y2[i], NULL, n);
+	}
+	BOOST_CHECK(y1 == y2);
+	BOOST_CHECK(whole.weights() == pieces.weights());
+
+	/* Leakage pulls weights to zero when the input is silent */
+	AdaptiveFilterConfig leaky(2, ADAPT_LEAKY_LMS, 1.0 / 16);
+	leaky.leakage = 1.0 / 64;
+	AdaptiveFilter decay(leaky, vector<double>(2, 0.5));
+	BOOST_CHECK_EQUAL(decay.weights()[0], 1 << 21);
+	for (int i = 0; i < 2000; i++)
+	{
+		decay.process(0, 0);
+	}
+	BOOST_CHECK(abs(decay.weights()[0]) < (1 << 8));
+
+	/* FixedPoint interface and invalid configurations */
+	BOOST_CHECK_EQUAL(whole.process(Fxp(0, 16, 15), Fxp(0, 16, 15)).width(),
+		24U);
+	BOOST_CHECK_THROW(whole.process(Fxp(0, 16, 14), Fxp(0, 16, 15)),
+		runtime_error);
+	AdaptiveFilterConfig wide;
+	wide.weightFormat = FxpFormat(48, 40);
+	BOOST_CHECK_THROW(AdaptiveFilter f(wide), range_error);
+	AdaptiveFilterConfig growing;
+	growing.weightFormat = FxpFormat(40, 34);
+	BOOST_CHECK_THROW(AdaptiveFilter f(growing), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( ComplexAdaptiveFilterConverges )
+{
+	complex<double> h[2] = { complex<double>(0.5, 0.25),
+		complex<double>(0.0, -0.125) };
+	Xoshiro256 rng(5);
+	size_t n = 4000;
+	vector<complex<int64_t> > x(n), d(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		x[i] = complex<int64_t>(rng.uniform(-(1 << 14), (1 << 14) - 1),
+			rng.uniform(-(1 << 14), (1 << 14) - 1));
+		complex<double> sum = h[0] * complex<double>(x[i].real(), x[i].imag());
+		if (i > 0)
+		{
+			sum += h[1] * complex<double>(x[i - 1].real(), x[i - 1].imag());
+		}
+		d[i] = complex<int64_t>((int64_t)floor(sum.real() + 0.5),
+			(int64_t)floor(sum.imag() + 0.5));
+	}
+
+	AdaptiveFilterConfig config(4, ADAPT_NLMS, 0.25);
+	ComplexAdaptiveFilter filter(config);
+	filter.process(&x[0], &d[0], NULL, NULL, n);
+	vector<complex<int64_t> > w = filter.weights();
+	double scale = pow(2.0, config.weightFormat.fracBits());
+	for (size_t k = 0; k < w.size(); k++)
+	{
+		complex<double> expected = (k < 2) ? h[k] : 0.0;
+		BOOST_CHECK_SMALL(w[k].real() / scale - expected.real(), 0.002);
+		BOOST_CHECK_SMALL(w[k].imag() / scale - expected.imag(), 0.002);
+	}
+
+	/* With real signals the complex filter matches the real one exactly */
+	vector<double> hr(1, -0.375);
+	vector<int64_t> xr, dr;
+	makeSystem(hr, 200, xr, dr);
+	AdaptiveFilterConfig lms(3, ADAPT_LMS, 1.0 / 8);
+	AdaptiveFilter real(lms);
+	ComplexAdaptiveFilter cplx(lms);
+	for (size_t i = 0; i < xr.size(); i++)
+	{
+		CFxp y = cplx.process(CFxp(xr[i], 0, 16, 15), CFxp(dr[i], 0, 16, 15));
+		BOOST_CHECK_EQUAL(y.real(), real.process(xr[i], dr[i]));
+		BOOST_CHECK_EQUAL(y.imag(), 0);
+	}
+}
@@ -0,0 +1,126 @@
+#include "boost_test.h"
+#include "AutomaticGainControl.h"
+#include <cmath>
+
+using namespace std;
+
+/* A complex tone of the given amplitude, raw in (16, 15) */
+static vector<complex<int64_t> > tone(size_t n, double amplitude)
+{
+	vector<complex<int64_t> > x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		complex<double> v = polar(amplitude, 2 * M_PI * 0.0173 * i);
+		x[i] = complex<int64_t>(quantizeValue(v.real(), FxpFormat(16, 15)),
+			quantizeValue(v.imag(), FxpFormat(16, 15)));
+	}
+	return x;
+}
+
+/* Mean |y|^2 of the last n outputs, in real units */
+static double meanPower(const vector<complex<int64_t> > &y, size_t n)
+{
+	double sum = 0;
+	for (size_t i = y.size() - n; i < y.size(); i++)
+	{
+		sum += norm(complex<double>((double)y[i].real(), (double)y[i].imag()));
+	}
+	return sum / n / powerOfTwo(30);
+}
+
+BOOST_AUTO_TEST_CASE( AgcConvergesOnPower )
+{
+	AgcConfig config(AGC_DETECT_POWER, 0.25, 16);
+	AutomaticGainControl agc(config);
+	BOOST_CHECK_EQUAL(agc.gain(), Fxp(1 << 16, 24, 16));
+	BOOST_CHECK_EQUAL(agc.logGain(), Fxp(0, 16, 10));
+
+	/* 0.01 in needs a gain of 50 for 0.5 out */
+	vector<complex<int64_t> > x = tone(4000, 0.01);
+	vector<complex<int64_t> > y(x.size());
+	agc.process(x.data(), y.data(), x.size());
+	BOOST_CHECK_CLOSE(meanPower(y, 512), 0.25, 3.0);
+	BOOST_CHECK_CLOSE(agc.gain().toDouble(), 50.0, 2.0);
+
+	/* A 20 dB step up is followed back down */
+	vector<complex<int64_t> > loud = tone(4000, 0.1);
+	agc.process(loud.data(), loud.data(), loud.size());
+	BOOST_CHECK_CLOSE(meanPower(loud, 512), 0.25, 3.0);
+	BOOST_CHECK_CLOSE(agc.gain().toDouble(), 5.0, 2.0);
+
+	agc.reset();
+	BOOST_CHECK_EQUAL(agc.gain(), Fxp(1 << 16, 24, 16));
+}
+
+BOOST_AUTO_TEST_CASE( AgcBlocksMatchSamples )
+{
+	AgcConfig config(AGC_DETECT_MAGNITUDE, 0.4, 8);
+	config.loopGain = 0.25;
+	AutomaticGainControl block(config);
+	AutomaticGainControl single(config);
+
+	vector<complex<int64_t> > x = tone(1000, 0.05);
+	vector<complex<int64_t> > y(x.size());
+	/* Pieces that do not line up with the update interval */
+	size_t pieces[4] = { 3, 250, 9, 738 };
+	size_t first = 0;
+	for (int p = 0; p < 4; p++)
+	{
+		block.process(x.data() + first, y.data() + first, pieces[p]);
+		first += pieces[p];
+	}
+
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		CFxp out = single.process(CFxp(x[i], 16, 15));
+		BOOST_CHECK(out == CFxp(y[i], 16, 15));
+	}
+	BOOST_CHECK_EQUAL(block.logGain(), single.logGain());
+
+	/* The magnitude detector settles max + min / 2 on the target */
+	double metric = 0;
+	for (size_t i = 500; i < 1000; i++)
+	{
+		double a = fabs((double)y[i].real());
+		double b = fabs((double)y[i].imag());
+		metric += max(a, b) + min(a, b) / 2;
+	}
+	BOOST_CHECK_CLOSE(metric / 500 / powerOfTwo(15), 0.4, 3.0);
+
+	vector<CFxp> in(4, CFxp(100, -100, 16, 15));
+	vector<CFxp> out;
+	single.process(in, out);
+	BOOST_CHECK_EQUAL(out.size(), 4U);
+	BOOST_CHECK(out[0].format() == FxpFormat(16, 15));
+	vector<CFxp> wrong;
+	wrong.emplace_back(0, 0, 16, 14);
+	BOOST_CHECK_THROW(single.process(wrong, out), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE( AgcUpdateIntervalAndLimits )
+{
+	AgcConfig config(AGC_DETECT_POWER, 0.25, 64);
+	AutomaticGainControl agc(config);
+	vector<complex<int64_t> > x = tone(64, 0.01);
+
+	/* The gain holds for a whole interval */
+	agc.process(x.data(), x.data(), 63);
+	BOOST_CHECK_EQUAL(agc.gain(), Fxp(1 << 16, 24, 16));
+	agc.process(x.data() + 63, x.data() + 63, 1);
+	BOOST_CHECK(agc.gain().toDouble() > 1.0);
+
+	/* Silence drives the gain to its limit and no further */
+	vector<complex<int64_t> > silence(64 * 200, complex<int64_t>(0, 0));
+	agc.process(silence.data(), silence.data(), silence.size());
+	BOOST_CHECK_EQUAL(agc.gain(), Fxp(64 << 16, 24, 16));
+	BOOST_CHECK_EQUAL(agc.logGain(), Fxp(6 << 10, 16, 10));
+
+	config.updateInterval = 12;
+	BOOST_CHECK_THROW(AutomaticGainControl bad(config), range_error);
+	config.updateInterval = 16;
+	config.maxGain = 512;
+	BOOST_CHECK_THROW(AutomaticGainControl bad(config), range_error);
+	config.maxGain = 64;
+	config.initialGain = 0.001;
+	BOOST_CHECK_THROW(AutomaticGainControl bad(config), range_error);
+}
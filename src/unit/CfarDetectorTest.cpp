@@ -0,0 +1,235 @@
+#include "boost_test.h"
+#include "CfarDetector.h"
+#include "Random.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/* Complex Gaussian noise of unit power with a few strong targets, raw in
+ * (16, 12) */
+static vector<complex<int64_t> > radarMap(size_t numDoppler, size_t numRange,
+	uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	FixedPointFormat format(16, 12);
+	vector<complex<int64_t> > map(numDoppler * numRange);
+	for (size_t i = 0; i < map.size(); i++)
+	{
+		/* Box-Muller */
+		double u = max(rng.uniformDouble(), 1e-300);
+		double radius = sqrt(-log(u));
+		double angle = 2 * M_PI * rng.uniformDouble();
+		map[i] = complex<int64_t>(quantizeValue(radius * cos(angle), format),
+			quantizeValue(radius * sin(angle), format));
+	}
+	for (size_t t = 0; t < 6; t++)
+	{
+		size_t d = (t * 37 + 5) % numDoppler;
+		size_t r = (t * 53 + 2) % numRange;
+		map[d * numRange + r] = complex<int64_t>(5 << 12, -(3 << 12));
+	}
+	return map;
+}
+
+/* Direct evaluation of every window, with the detector's edge rules */
+static vector<CfarDetection> bruteForce(const CfarConfig &c,
+	const vector<int64_t> &cells, size_t numDoppler, size_t numRange)
+{
+	int64_t threshold = quantizeValue(c.threshold, c.thresholdFormat);
+	int64_t scale = (int64_t)1 << c.thresholdFormat.fracBits();
+	int64_t reach = c.guardCells + c.trainingCells;
+	vector<CfarDetection> result;
+	for (size_t d = 0; d < numDoppler; d++)
+	{
+		const int64_t *row = &cells[d * numRange];
+		for (int64_t r = 0; r < (int64_t)numRange; r++)
+		{
+			vector<int64_t> lag;
+			vector<int64_t> lead;
+			for (int64_t k = r - reach; k < r - (int64_t)c.guardCells; k++)
+			{
+				if (k >= 0)
+				{
+					lag.push_back(row[k]);
+				}
+			}
+			for (int64_t k = r + c.guardCells + 1; k <= r + reach; k++)
+			{
+				if (k < (int64_t)numRange)
+				{
+					lead.push_back(row[k]);
+				}
+			}
+			int64_t lagSum = 0;
+			int64_t leadSum = 0;
+			for (size_t i = 0; i < lag.size(); i++)
+			{
+				lagSum += lag[i];
+			}
+			for (size_t i = 0; i < lead.size(); i++)
+			{
+				leadSum += lead[i];
+			}
+			int64_t lagN = lag.size();
+			int64_t leadN = lead.size();
+
+			int64_t sum;
+			int64_t n;
+			bool lagGreater = lagSum * leadN >= leadSum * lagN;
+			bool lagSmaller = lagSum * leadN <= leadSum * lagN;
+			switch (c.method)
+			{
+			case CFAR_CA:
+				sum = lagSum + leadSum;
+				n = lagN + leadN;
+				break;
+			case CFAR_GO:
+			case CFAR_SO:
+			{
+				bool useLag = (leadN == 0) || (lagN != 0
+					&& (c.method == CFAR_GO ? lagGreater : lagSmaller));
+				sum = useLag ? lagSum : leadSum;
+				n = useLag ? lagN : leadN;
+				break;
+			}
+			default:
+			{
+				vector<int64_t> all(lag);
+				all.insert(all.end(), lead.begin(), lead.end());
+				sort(all.begin(), all.end());
+				n = all.empty() ? 0 : 1;
+				size_t k = (c.rank * all.size() + 2 * c.trainingCells - 1)
+					/ (2 * c.trainingCells);
+				sum = all.empty() ? 0 : all[max(k, (size_t)1) - 1];
+			}
+			}
+
+			if (n != 0 && row[r] * n * scale > threshold * sum)
+			{
+				CfarDetection det;
+				det.doppler = d;
+				det.range = r;
+				det.cell = row[r];
+				det.noise = (sum + n / 2) / n;
+				result.push_back(det);
+			}
+		}
+	}
+	return result;
+}
+
+static bool sameDetections(const vector<CfarDetection> &a,
+	const vector<CfarDetection> &b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].doppler != b[i].doppler || a[i].range != b[i].range
+			|| a[i].cell != b[i].cell || a[i].noise != b[i].noise)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+BOOST_AUTO_TEST_CASE( CfarMatchesBruteForce )
+{
+	const size_t numDoppler = 21;
+	const size_t numRange = 150;
+	vector<complex<int64_t> > map = radarMap(numDoppler, numRange, 1);
+
+	CfarMethod methods[4] = { CFAR_CA, CFAR_GO, CFAR_SO, CFAR_OS };
+	for (int m = 0; m < 4; m++)
+	{
+		CfarConfig config(methods[m], 2, 8, 6.0);
+		config.cellFormat = FixedPointFormat(33, 24);
+		vector<int64_t> power(map.size());
+		for (size_t i = 0; i < map.size(); i++)
+		{
+			power[i] = map[i].real() * map[i].real()
+				+ map[i].imag() * map[i].imag();
+		}
+
+		vector<CfarDetection> expected = bruteForce(config, power, numDoppler,
+			numRange);
+		BOOST_CHECK(expected.size() >= 6);
+		for (unsigned int threads = 1; threads <= 4; threads += 3)
+		{
+			CfarDetector detector(config, threads);
+			BOOST_CHECK(sameDetections(detector.detect(power.data(),
+				numDoppler, numRange), expected));
+			BOOST_CHECK(sameDetections(detector.detect(map.data(), numDoppler,
+				numRange, FixedPointFormat(16, 12)), expected));
+		}
+	}
+
+	/* Rows shorter than the windows */
+	CfarConfig config(CFAR_GO, 3, 5, 2.0);
+	config.cellFormat = FixedPointFormat(33, 24);
+	vector<int64_t> shortRows(3 * 6);
+	for (size_t i = 0; i < shortRows.size(); i++)
+	{
+		shortRows[i] = (int64_t)((i * 7919) % 23) << 20;
+	}
+	CfarDetector detector(config, 2);
+	BOOST_CHECK(sameDetections(detector.detect(shortRows.data(), 3, 6),
+		bruteForce(config, shortRows, 3, 6)));
+}
+
+BOOST_AUTO_TEST_CASE( CfarFalseAlarmRate )
+{
+	const size_t numDoppler = 64;
+	const size_t numRange = 512;
+	vector<complex<int64_t> > map = radarMap(numDoppler, numRange, 2);
+
+	CfarConfig config(CFAR_CA, 2, 16);
+	config.cellFormat = FixedPointFormat(33, 24);
+	config.threshold = CfarDetector::caThreshold(1e-3, 32);
+	BOOST_CHECK_CLOSE(config.threshold, 32 * (pow(1e-3, -1.0 / 32) - 1), 1e-9);
+	CfarDetector detector(config);
+	vector<CfarDetection> found = detector.detect(map.data(), numDoppler,
+		numRange, FixedPointFormat(16, 12));
+
+	/* The six targets, plus about 33 false alarms */
+	size_t targets = 0;
+	for (size_t i = 0; i < found.size(); i++)
+	{
+		if (found[i].cell == (int64_t)34 << 24)
+		{
+			targets++;
+		}
+		BOOST_CHECK(found[i].cell > found[i].noise);
+		if (i > 0)
+		{
+			BOOST_CHECK(found[i - 1].doppler < found[i].doppler
+				|| (found[i - 1].doppler == found[i].doppler
+				&& found[i - 1].range < found[i].range));
+		}
+	}
+	BOOST_CHECK_EQUAL(targets, 6U);
+	BOOST_CHECK(found.size() < 6 + 80);
+}
+
+BOOST_AUTO_TEST_CASE( CfarConfigErrors )
+{
+	CfarConfig config(CFAR_OS, 2, 4);
+	config.rank = 9;
+	BOOST_CHECK_THROW(CfarDetector detector(config), range_error);
+	config.rank = 0;
+	BOOST_CHECK_THROW(CfarDetector detector(config), range_error);
+	config.rank = 6;
+	config.trainingCells = 0;
+	BOOST_CHECK_THROW(CfarDetector detector(config), range_error);
+	config.trainingCells = 4;
+	config.cellFormat = FixedPointFormat(60, 40);
+	BOOST_CHECK_THROW(CfarDetector detector(config), range_error);
+	config.cellFormat = FixedPointFormat(33, 30);
+	config.threshold = 200.0;
+	BOOST_CHECK_THROW(CfarDetector detector(config), range_error);
+	BOOST_CHECK_THROW(CfarDetector::caThreshold(1.5, 8), range_error);
+}
@@ -0,0 +1,44 @@
+#include "boost_test.h"
+#include "CoefficientCache.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( CoefficientCacheQuantize )
+{
+	vector<double> values;
+	values.push_back(2.34);
+	values.push_back(-0.5);
+
+	/* Same rounding as FixedPoint::quantize */
+	CoefficientTable a = CoefficientCache::quantize(values, FxpFormat(12, 4));
+	BOOST_REQUIRE_EQUAL(a->size(), 2);
+	BOOST_CHECK_EQUAL((*a)[0], 37);
+	BOOST_CHECK_EQUAL((*a)[1], -8);
+
+	/* Too few integer bits */
+	BOOST_CHECK_THROW(CoefficientCache::quantize(values, FxpFormat(12, 10)),
+		range_error);
+}
+
+BOOST_AUTO_TEST_CASE( CoefficientCacheSharing )
+{
+	CoefficientCache::clear();
+	vector<double> values(3, 0.125);
+
+	/* Same values and format share one table */
+	CoefficientTable a = CoefficientCache::quantize(values, FxpFormat(8, 6));
+	CoefficientTable b = CoefficientCache::quantize(values, FxpFormat(8, 6));
+	BOOST_CHECK(a == b);
+	BOOST_CHECK_EQUAL(CoefficientCache::size(), 1);
+
+	/* A different format is a different table */
+	CoefficientTable c = CoefficientCache::quantize(values, FxpFormat(8, 5));
+	BOOST_CHECK(a != c);
+	BOOST_CHECK_EQUAL((*c)[0], 4);
+	BOOST_CHECK_EQUAL(CoefficientCache::size(), 2);
+
+	/* Tables outlive the cache */
+	CoefficientCache::clear();
+	BOOST_CHECK_EQUAL(CoefficientCache::size(), 0);
+	BOOST_CHECK_EQUAL((*a)[2], 8);
+}
@@ -26,6 +26,9 @@ BOOST_AUTO_TEST_CASE( CFxpConstructors )
 	/* Width larger than max allowed width */
 	BOOST_CHECK_THROW(CFxp(0, 0, CFxp::MAX_WIDTH + 1), range_error);
 
+	/* Zero width */
+	BOOST_CHECK_THROW(CFxp(0, 0, 0), range_error);
+
 	/* More fractional bits than total bits */
 	BOOST_CHECK_THROW(CFxp(0, 0, 2, 3), range_error);
 }
@@ -226,6 +229,14 @@ BOOST_AUTO_TEST_CASE( CFxpSaturation )
 	/* Go beyond allowed range */
 	BOOST_CHECK_THROW(a.saturateTo(0), std::range_error);
 	BOOST_CHECK_THROW(a.saturateBy(a.width()), std::range_error);
+
+	/* Full 64 bit width */
+	CFxp b(INT64_MIN, INT64_MAX, 64);
+	BOOST_CHECK_EQUAL(b.saturateTo(64), CFxp(INT64_MIN, INT64_MAX, 64));
+	BOOST_CHECK_EQUAL(b.saturateTo(8), CFxp(-128, 127, 8));
+
+	/* Fewer total bits than fractional bits */
+	BOOST_CHECK_THROW(CFxp(3, -3, 8, 6).saturateTo(5), std::range_error);
 }
 
 BOOST_AUTO_TEST_CASE( CFxpRounding )
@@ -239,6 +250,22 @@ BOOST_AUTO_TEST_CASE( CFxpRounding )
 	/* Go beyond allowed range */
 	BOOST_CHECK_THROW(a.roundTo(0), std::range_error);
 	BOOST_CHECK_THROW(a.roundBy(a.width()), std::range_error);
+
+	/* Rounding by zero bits leaves the value unchanged */
+	CFxp b(-3, 5, 8, 2);
+	BOOST_CHECK_EQUAL(b.roundBy(0), CFxp(-3, 5, 8, 2));
+
+	/* Rounding the largest values up does not fit the narrower width */
+	BOOST_CHECK_THROW(CFxp(0, 127, 8).roundBy(1), std::range_error);
+	BOOST_CHECK_EQUAL(CFxp(125, -128, 8).roundBy(1), CFxp(63, -64, 7));
+
+	/* Other modes apply to both parts */
+	BOOST_CHECK_EQUAL(CFxp(6, -6, 8, 2).roundBy(2, ROUND_HALF_EVEN),
+		CFxp(2, -2, 6, 0));
+	BOOST_CHECK_EQUAL(CFxp(2, -2, 8, 2).roundBy(2, ROUND_HALF_AWAY),
+		CFxp(1, -1, 6, 0));
+	BOOST_CHECK_EQUAL(CFxp(7, -7, 8, 2).roundTo(6, ROUND_TOWARD_ZERO),
+		CFxp(1, -1, 6, 0));
 }
 
 BOOST_AUTO_TEST_CASE( CFxpSignExtension )
@@ -252,6 +279,34 @@ BOOST_AUTO_TEST_CASE( CFxpSignExtension )
 	/* Try to sign extend beyond allowed range */
 	BOOST_CHECK_THROW(a.signExtendTo(CFxp::MAX_WIDTH + 1), std::range_error);
 	BOOST_CHECK_THROW(a.signExtendBy(CFxp::MAX_WIDTH - a.width() + 1), std::range_error);
+
+	/* Sign extending to a narrower width */
+	BOOST_CHECK_THROW(a.signExtendTo(8), std::range_error);
+}
+
+BOOST_AUTO_TEST_CASE( CFxpResize )
+{
+	/* Both parts go through the same rounding and overflow */
+	BOOST_CHECK_EQUAL(CFxp(47, -47, 10, 4).resize(FxpFormat(8, 2)),
+		CFxp(12, -12, 8, 2));
+	BOOST_CHECK_EQUAL(CFxp(47, -47, 10, 4).resize(FxpFormat(8, 2),
+		ROUND_FLOOR), CFxp(11, -12, 8, 2));
+	BOOST_CHECK_EQUAL(CFxp(1000, -1000, 12, 2).resize(FxpFormat(8, 2)),
+		CFxp(127, -128, 8, 2));
+	BOOST_CHECK_EQUAL(CFxp(100, -3, 8).resize(FxpFormat(10, 4), ROUND_HALF_UP,
+		OVERFLOW_WRAP), CFxp(-448, -48, 10, 4));
+	BOOST_CHECK_EQUAL(CFxp(1, -1, 64).resize(FxpFormat(64, 64)),
+		CFxp(INT64_MAX, INT64_MIN, 64, 64));
+	BOOST_CHECK_EQUAL(CFxp(5, -5, 64, 64).resize(FxpFormat(64), ROUND_FLOOR),
+		CFxp(0, -1, 64));
+
+	CFxp reg(0, 0, 8, 4);
+	reg.assign(CFxp(1000, 5, 12, 6));
+	BOOST_CHECK_EQUAL(reg, CFxp(127, 1, 8, 4));
+	BOOST_CHECK(reg.format() == FxpFormat(8, 4));
+	CFxp wide(0, 0, 64, 64);
+	wide.assign(CFxp(1, 0, 64), ROUND_HALF_UP, OVERFLOW_WRAP);
+	BOOST_CHECK_EQUAL(wide, CFxp(0, 0, 64, 64));
 }
 
 BOOST_AUTO_TEST_CASE( CFxpToFloat )
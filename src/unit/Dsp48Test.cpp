@@ -0,0 +1,164 @@
+#include "boost_test.h"
+#include "Dsp48.h"
+#include "Random.h"
+
+using namespace std;
+
+/* Clock a chain of slices linked through ACOUT/PCOUT, one cycle per input */
+static vector<int64_t> clockSlices(const vector<int64_t> &h,
+	const vector<int64_t> &x, const Dsp48Config &config)
+{
+	vector<Dsp48Slice> slices(h.size(), Dsp48Slice(config));
+	vector<int64_t> y;
+	for (size_t n = 0; n < x.size(); n++)
+	{
+		vector<int64_t> acout(h.size());
+		vector<int64_t> pcout(h.size());
+		for (size_t k = 0; k < h.size(); k++)
+		{
+			acout[k] = slices[k].acout();
+			pcout[k] = slices[k].p();
+		}
+		for (size_t k = 0; k < h.size(); k++)
+		{
+			int64_t a = (k == 0) ? x[n] : acout[k - 1];
+			int64_t pcin = (k == 0) ? 0 : pcout[k - 1];
+			slices[k].clock(a, h[k], 0, 0, pcin,
+				(k == 0) ? Dsp48Slice::Z_ZERO : Dsp48Slice::Z_PCIN);
+		}
+		y.push_back(slices.back().p());
+	}
+	return y;
+}
+
+BOOST_AUTO_TEST_CASE( Dsp48SliceAccumulate )
+{
+	Dsp48Slice s;
+
+	/* A * B reaches P after four clocks, then accumulates */
+	int64_t p[6];
+	for (int i = 0; i < 6; i++)
+	{
+		p[i] = s.clock(3, -4, 0, 0, 0, Dsp48Slice::Z_P);
+	}
+	BOOST_CHECK_EQUAL(p[2], 0);
+	BOOST_CHECK_EQUAL(p[3], -12);
+	BOOST_CHECK_EQUAL(p[5], -36);
+
+	/* C port enters at the post-adder */
+	s.reset();
+	for (int i = 0; i < 4; i++)
+	{
+		s.clock(5, 6, 100, 0, 0, Dsp48Slice::Z_C);
+	}
+	BOOST_CHECK_EQUAL(s.p(), 130);
+}
+
+BOOST_AUTO_TEST_CASE( Dsp48SlicePorts )
+{
+	Dsp48Config config;
+	config.usePreAdder = true;
+	config.preSubtract = true;
+	Dsp48Slice s(config);
+
+	/* D - A through the 27 bit pre-adder */
+	BOOST_CHECK_EQUAL(s.multiplierInput(5, 12), 7);
+	BOOST_CHECK_EQUAL(s.multiplierInput(1, -(1LL << 26)), (1LL << 26) - 1);
+	config.preAddOverflow = OVERFLOW_SATURATE;
+	BOOST_CHECK_EQUAL(Dsp48Slice(config).multiplierInput(1, -(1LL << 26)),
+		-(1LL << 26));
+
+	/* Multiplier sees 27 bits of A */
+	Dsp48Slice plain;
+	BOOST_CHECK_EQUAL(plain.multiply((1LL << 27) + 3, 2), 6);
+
+	/* Post-adder wraps or saturates at 48 bits */
+	int64_t pMax = (1LL << 47) - 1;
+	BOOST_CHECK_EQUAL(plain.postAdd(pMax, 1), -(1LL << 47));
+	Dsp48Config saturating;
+	saturating.postAddOverflow = OVERFLOW_SATURATE;
+	BOOST_CHECK_EQUAL(Dsp48Slice(saturating).postAdd(pMax, 1), pMax);
+
+	/* Invalid port widths */
+	Dsp48Config wide;
+	wide.bWidth = 30;
+	BOOST_CHECK_THROW(Dsp48Slice s2(wide), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( Dsp48ChainMatchesFir )
+{
+	vector<int64_t> h;
+	h.push_back(3);
+	h.push_back(-1);
+	h.push_back(7);
+	Dsp48Chain chain(h);
+	BOOST_CHECK_EQUAL(chain.latency(), 5);
+
+	vector<int64_t> x(50), y(50);
+	for (size_t n = 0; n < x.size(); n++)
+	{
+		x[n] = (int64_t)(n * n % 23) - 11;
+	}
+	chain.process(&x[0], &y[0], x.size());
+	for (size_t n = 0; n < x.size(); n++)
+	{
+		int64_t expected = 0;
+		for (size_t k = 0; k < h.size(); k++)
+		{
+			if (n >= chain.latency() + k)
+			{
+				expected += h[k] * x[n - chain.latency() - k];
+			}
+		}
+		BOOST_CHECK_EQUAL(y[n], expected);
+	}
+
+	/* Coefficients must fit the B port */
+	h.push_back(1 << 17);
+	BOOST_CHECK_THROW(Dsp48Chain c2(h), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( Dsp48ChainMatchesSlices )
+{
+	Xoshiro256 rng(7);
+	Dsp48Config configs[3];
+	configs[1].postAddOverflow = OVERFLOW_SATURATE;
+	configs[2].usePreAdder = true;
+	configs[2].preSubtract = true;
+	configs[2].postAddOverflow = OVERFLOW_SATURATE;
+
+	for (int c = 0; c < 3; c++)
+	{
+		/* Full scale operands so the 48 bit post-adder overflows */
+		vector<int64_t> h(24), x(600);
+		for (size_t k = 0; k < h.size(); k++)
+		{
+			h[k] = rng.uniform(-(1 << 17), (1 << 17) - 1);
+		}
+		for (size_t n = 0; n < x.size(); n++)
+		{
+			x[n] = rng.uniform(-(1LL << 29), (1LL << 29) - 1);
+		}
+
+		vector<int64_t> expected = clockSlices(h, x, configs[c]);
+
+		/* Same result in one block, in uneven blocks and one clock at a time */
+		Dsp48Chain chain(h, configs[c]);
+		vector<int64_t> y(x.size());
+		chain.process(&x[0], &y[0], x.size());
+		BOOST_CHECK(y == expected);
+
+		chain.reset();
+		for (size_t n = 0; n < x.size(); n += 37)
+		{
+			chain.process(&x[n], &y[n], min((size_t)37, x.size() - n));
+		}
+		BOOST_CHECK(y == expected);
+
+		chain.reset();
+		for (size_t n = 0; n < 100; n++)
+		{
+			BOOST_CHECK_EQUAL(chain.clock(x[n]), expected[n]);
+		}
+	}
+}
@@ -0,0 +1,148 @@
+#include "boost_test.h"
+#include "FarrowResampler.h"
+#include <cmath>
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( FarrowLagrangeCoefficients )
+{
+	/* Linear interpolation: y = x0 + mu (x1 - x0) */
+	vector<vector<double> > c = FarrowResampler::lagrange(1);
+	BOOST_REQUIRE_EQUAL(c.size(), 2);
+	BOOST_CHECK_CLOSE(c[0][0], 1.0, 1e-9);
+	BOOST_CHECK_SMALL(c[0][1], 1e-12);
+	BOOST_CHECK_CLOSE(c[1][0], -1.0, 1e-9);
+	BOOST_CHECK_CLOSE(c[1][1], 1.0, 1e-9);
+
+	/* Cubic: at mu = 0 only the tap at 0 contributes, and the branches
+	 * evaluated at any mu sum to one */
+	c = FarrowResampler::lagrange(3);
+	BOOST_REQUIRE_EQUAL(c.size(), 4);
+	BOOST_CHECK_CLOSE(c[0][1], 1.0, 1e-9);
+	BOOST_CHECK_SMALL(c[0][0] + c[0][2] + c[0][3], 1e-12);
+	double sum = 0.0;
+	for (size_t m = 0; m < 4; m++)
+	{
+		for (size_t k = 0; k < 4; k++)
+		{
+			sum += c[m][k] * pow(0.3, (double)m);
+		}
+	}
+	BOOST_CHECK_CLOSE(sum, 1.0, 1e-9);
+
+	BOOST_CHECK_THROW(FarrowResampler::lagrange(0), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( FarrowUnityRatio )
+{
+	/* Ratio one always interpolates at mu = 0: a pure delay */
+	FarrowResampler r(1.0, 3, FxpFormat(16, 15), FxpFormat(18, 16),
+		FxpFormat(24, 20), FxpFormat(16, 15));
+	BOOST_CHECK_EQUAL(r.delay(), 2);
+
+	vector<int64_t> x(100), y;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)(i * 997 % 60000) - 30000;
+	}
+	BOOST_CHECK_EQUAL(r.process(&x[0], x.size(), y), x.size());
+	for (size_t i = 2; i < x.size(); i++)
+	{
+		BOOST_CHECK_EQUAL(y[i], x[i - 2]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( FarrowInterpolateByTwo )
+{
+	/* Linear interpolation at half the input period averages neighbours */
+	FarrowResampler r(0.5, 1, FxpFormat(16), FxpFormat(8, 6),
+		FxpFormat(24, 4), FxpFormat(18, 1));
+	vector<int64_t> x, y;
+	x.push_back(10);
+	x.push_back(20);
+	x.push_back(-5);
+	BOOST_CHECK_EQUAL(r.process(&x[0], x.size(), y), 6);
+	BOOST_CHECK_EQUAL(y[0], 0);
+	BOOST_CHECK_EQUAL(y[1], 10);
+	BOOST_CHECK_EQUAL(y[2], 20);
+	BOOST_CHECK_EQUAL(y[3], 30);
+	BOOST_CHECK_EQUAL(y[4], 40);
+	BOOST_CHECK_EQUAL(y[5], 15);
+}
+
+BOOST_AUTO_TEST_CASE( FarrowArbitraryRatio )
+{
+	/* 61.44 -> 50 Msps on a slow tone, against the exact signal */
+	double ratio = 61.44 / 50.0;
+	double freq = 0.01;
+	FarrowResampler r(ratio, 3, FxpFormat(16, 14), FxpFormat(18, 16),
+		FxpFormat(28, 22), FxpFormat(16, 14), 18, 32);
+
+	vector<int64_t> x(20000), whole;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)floor(16000.0 * sin(2 * M_PI * freq * i) + 0.5);
+	}
+	size_t n = r.process(&x[0], x.size(), whole);
+	BOOST_CHECK_CLOSE((double)n, x.size() / ratio, 0.1);
+
+	double maxError = 0.0;
+	for (size_t j = 10; j < n; j++)
+	{
+		double t = j * ratio - r.delay();
+		double exact = 16000.0 * sin(2 * M_PI * freq * t) / 16384.0;
+		maxError = max(maxError, fabs(whole[j] / 16384.0 - exact));
+	}
+	BOOST_CHECK_SMALL(maxError, 3.0 / 16384.0);
+
+	/* Block size does not change the result */
+	r.reset();
+	vector<int64_t> pieces;
+	size_t sizes[] = { 1, 7, 300, 4096, 13 };
+	size_t pos = 0;
+	for (size_t i = 0; pos < x.size(); i = (i + 1) % 5)
+	{
+		size_t len = min(sizes[i], x.size() - pos);
+		r.process(&x[pos], len, pieces);
+		pos += len;
+	}
+	BOOST_CHECK(pieces == whole);
+}
+
+BOOST_AUTO_TEST_CASE( FarrowComplex )
+{
+	/* Real and imaginary parts are resampled independently */
+	FxpFormat in(14, 13);
+	FarrowResampler rc(0.75, 3, in, FxpFormat(18, 16), FxpFormat(24, 20), in);
+	FarrowResampler rr(0.75, 3, in, FxpFormat(18, 16), FxpFormat(24, 20), in);
+	FarrowResampler ri(0.75, 3, in, FxpFormat(18, 16), FxpFormat(24, 20), in);
+
+	vector<complex<int64_t> > x(500), y;
+	vector<int64_t> re(500), im(500), yr, yi;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		re[i] = (int64_t)(i * 37 % 8000) - 4000;
+		im[i] = (int64_t)(i * 91 % 8000) - 4000;
+		x[i] = complex<int64_t>(re[i], im[i]);
+	}
+	rc.process(&x[0], x.size(), y);
+	rr.process(&re[0], re.size(), yr);
+	ri.process(&im[0], im.size(), yi);
+
+	BOOST_REQUIRE_EQUAL(y.size(), yr.size());
+	for (size_t j = 0; j < y.size(); j++)
+	{
+		BOOST_CHECK_EQUAL(y[j].real(), yr[j]);
+		BOOST_CHECK_EQUAL(y[j].imag(), yi[j]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( FarrowInvalid )
+{
+	BOOST_CHECK_THROW(FarrowResampler(0.0, 3, FxpFormat(16), FxpFormat(16),
+		FxpFormat(24), FxpFormat(16)), range_error);
+	BOOST_CHECK_THROW(FarrowResampler(1.0, 3, FxpFormat(40), FxpFormat(24),
+		FxpFormat(24), FxpFormat(16)), range_error);
+	BOOST_CHECK_THROW(FarrowResampler(1.0, 3, FxpFormat(16, 2), FxpFormat(16, 2),
+		FxpFormat(24, 8), FxpFormat(16)), range_error);
+}
@@ -0,0 +1,171 @@
+#include "boost_test.h"
+#include "FastConvolver.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+static vector<complex<int64_t> > randomSignal(size_t n, uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	vector<complex<int64_t> > x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		x[i] = complex<int64_t>(rng.uniform(-(1 << 14), 1 << 14),
+			rng.uniform(-(1 << 14), 1 << 14));
+	}
+	return x;
+}
+
+static vector<complex<double> > randomTaps(size_t n, uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	vector<complex<double> > h(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		h[i] = complex<double>(rng.uniformDouble() - 0.5,
+			rng.uniformDouble() - 0.5) / 8.0;
+	}
+	return h;
+}
+
+/* Largest difference from the direct sum, in output LSBs (2^-15 input and
+ * output) */
+static double maxError(const vector<complex<double> > &h,
+	const vector<complex<int64_t> > &x, const vector<complex<int64_t> > &y,
+	FastConvolutionMode mode)
+{
+	size_t numTaps = h.size();
+	double error = 0;
+	for (size_t n = 0; n < y.size(); n++)
+	{
+		complex<double> sum = 0;
+		for (size_t k = 0; k < numTaps; k++)
+		{
+			complex<double> tap = (mode == FAST_CONVOLUTION) ? h[k]
+				: conj(h[numTaps - 1 - k]);
+			if (n >= k)
+			{
+				sum += tap * complex<double>(x[n - k].real(), x[n - k].imag());
+			}
+		}
+		error = max(error, abs(sum - complex<double>(y[n].real(),
+			y[n].imag())));
+	}
+	return error;
+}
+
+BOOST_AUTO_TEST_CASE( FastConvolverMatchesDirectSum )
+{
+	vector<complex<double> > h = randomTaps(100, 1);
+	vector<complex<int64_t> > x = randomSignal(1000, 2);
+	FastConvolutionMode modes[2] = { FAST_CONVOLUTION, FAST_CORRELATION };
+	FastConvolutionMethod methods[2] = { OVERLAP_SAVE, OVERLAP_ADD };
+
+	for (int m = 0; m < 2; m++)
+	{
+		for (int a = 0; a < 2; a++)
+		{
+			/* Growth is absorbed by a wide datapath; the schedules scale
+			 * the forward transform only */
+			FastConvolver conv(h, modes[m], 256, FxpFormat(16, 15),
+				FxpFormat(32, 19), FxpFormat(20, 14), FxpFormat(18, 16),
+				FxpFormat(24, 15), FixedPointFft::SCALE_ALL, 0, methods[a]);
+			BOOST_CHECK_EQUAL(conv.blockSize(), 157U);
+			vector<complex<int64_t> > y;
+			size_t n = conv.process(&x[0], x.size(), y);
+			BOOST_CHECK_EQUAL(n, 6 * 157U);
+			BOOST_CHECK_EQUAL(y.size(), n);
+			BOOST_CHECK(maxError(h, x, y, modes[m]) < 3.0);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( FastConvolverStreaming )
+{
+	vector<complex<double> > h = randomTaps(40, 3);
+	vector<complex<int64_t> > x = randomSignal(900, 4);
+	FastConvolver whole(h, FAST_CONVOLUTION, 64, FxpFormat(16, 15),
+		FxpFormat(24, 15), FxpFormat(16, 12), FxpFormat(16, 15),
+		FxpFormat(16, 15), 0x3F, 0, OVERLAP_ADD);
+	FastConvolver pieces(h, FAST_CONVOLUTION, 64, FxpFormat(16, 15),
+		FxpFormat(24, 15), FxpFormat(16, 12), FxpFormat(16, 15),
+		FxpFormat(16, 15), 0x3F, 0, OVERLAP_ADD);
+
+	vector<complex<int64_t> > y1, y2;
+	whole.process(&x[0], x.size(), y1);
+	for (size_t i = 0; i < x.size(); i += 11)
+	{
+		pieces.process(&x[i], min((size_t)11, x.size() - i), y2);
+	}
+	BOOST_CHECK(y1 == y2);
+
+	/* reset() restarts from silence */
+	whole.reset();
+	vector<complex<int64_t> > y3;
+	whole.process(&x[0], x.size(), y3);
+	BOOST_CHECK(y1 == y3);
+}
+
+BOOST_AUTO_TEST_CASE( FastConvolverMatchedFilter )
+{
+	/* A real chirp buried at sample 300 */
+	size_t numTaps = 128;
+	vector<double> chirp(numTaps);
+	for (size_t i = 0; i < numTaps; i++)
+	{
+		chirp[i] = 0.25 * cos(M_PI * i * i / (2.0 * numTaps));
+	}
+	vector<int64_t> x(1200, 0);
+	for (size_t i = 0; i < numTaps; i++)
+	{
+		x[300 + i] = (int64_t)floor(chirp[i] * 32768 + 0.5);
+	}
+
+	FastConvolver matched(chirp, FAST_CORRELATION, 512, FxpFormat(16, 15),
+		FxpFormat(28, 15), FxpFormat(18, 12), FxpFormat(18, 16),
+		FxpFormat(24, 15));
+	vector<int64_t> y;
+	matched.process(&x[0], x.size(), y);
+	size_t peak = 0;
+	for (size_t i = 0; i < y.size(); i++)
+	{
+		if (llabs(y[i]) > llabs(y[peak]))
+		{
+			peak = i;
+		}
+	}
+	BOOST_CHECK_EQUAL(peak, 300 + numTaps - 1);
+
+	/* Configurations that cannot work */
+	vector<complex<double> > complexTaps(4, complex<double>(0.0, 0.5));
+	FastConvolver complexFilter(complexTaps, FAST_CONVOLUTION, 16,
+		FxpFormat(16, 15), FxpFormat(24, 15), FxpFormat(16, 12),
+		FxpFormat(16, 15), FxpFormat(16, 15));
+	BOOST_CHECK_THROW(complexFilter.process(&x[0], 10, y), runtime_error);
+	BOOST_CHECK_THROW(FastConvolver(chirp, FAST_CONVOLUTION, 64,
+		FxpFormat(16, 15), FxpFormat(24, 15), FxpFormat(16, 12),
+		FxpFormat(16, 15), FxpFormat(16, 15)), range_error);
+	BOOST_CHECK_THROW(FastConvolver(complexTaps, FAST_CONVOLUTION, 16,
+		FxpFormat(16, 15), FxpFormat(24, 0), FxpFormat(16, 12),
+		FxpFormat(16, 15), FxpFormat(16, 15), FixedPointFft::SCALE_ALL,
+		FixedPointFft::SCALE_ALL), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( FastConvolverOutputSaturates )
+{
+	/* An output with 44 more fractional bits than the result: 3 and -3
+	 * saturate instead of wrapping in the 64-bit shift */
+	vector<double> identity(1, 1.0);
+	FastConvolver conv(identity, FAST_CONVOLUTION, 8, FxpFormat(16),
+		FxpFormat(32, 19), FxpFormat(20, 14), FxpFormat(18, 16),
+		FxpFormat(64, 63), FixedPointFft::SCALE_ALL, 0);
+	vector<int64_t> x(16, 3);
+	fill(x.begin() + 8, x.end(), -3);
+	vector<int64_t> y;
+	BOOST_CHECK_EQUAL(conv.process(&x[0], x.size(), y), 16U);
+	for (size_t i = 0; i < y.size(); i++)
+	{
+		BOOST_CHECK_EQUAL(y[i], (i < 8) ? INT64_MAX : INT64_MIN);
+	}
+}
@@ -0,0 +1,117 @@
+#include "boost_test.h"
+#include "FixedPointExpression.h"
+#include "Random.h"
+
+using namespace std;
+
+static FixedPointArray randomArray(size_t n, FixedPointFormat format,
+	uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	vector<int64_t> values(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		values[i] = rng.uniform(format.minVal(), format.maxVal());
+	}
+	return FixedPointArray(values, format);
+}
+
+BOOST_AUTO_TEST_CASE( ExpressionScalar )
+{
+	Fxp a(-300, 12, 10);
+	Fxp b(1000, 12, 11);
+	Fxp c(77, 8, 3);
+
+	/* Same value and format as the eager chain */
+	Fxp fused = ((lazy(a) * b) + c).roundBy(4).saturateTo(24).value();
+	BOOST_CHECK_EQUAL(fused, ((a * b) + c).roundBy(4).saturateTo(24));
+	BOOST_CHECK(((lazy(a) * b) + c).format() == FxpFormat(43, 21));
+
+	BOOST_CHECK_EQUAL((lazy(a) + b).truncateTo(8).value(),
+		(a + b).truncateTo(8));
+	BOOST_CHECK_EQUAL((lazy(c) * c).signExtendBy(3).value(),
+		(c * c).signExtendBy(3));
+	BOOST_CHECK_EQUAL((lazy(a) * b).roundTo(12, ROUND_HALF_EVEN).value(),
+		(a * b).roundTo(12, ROUND_HALF_EVEN));
+
+	/* Invalid steps throw when the expression is built */
+	Fxp wide(0, 40);
+	BOOST_CHECK_THROW(lazy(wide) * wide, range_error);
+	BOOST_CHECK_THROW(lazy(c).roundBy(8), range_error);
+	BOOST_CHECK_THROW(lazy(c).saturateTo(2), range_error);
+	BOOST_CHECK_THROW(lazy(wide).signExtendBy(25), range_error);
+
+	/* Carries into the sign bit throw on evaluation, as roundBy() */
+	BOOST_CHECK_THROW(lazy(Fxp(127, 8)).roundBy(1).value(), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( ExpressionArrayMatchesEager )
+{
+	FixedPointArray x = randomArray(500, FxpFormat(16, 15), 1);
+	FixedPointArray g = randomArray(500, FxpFormat(12, 10), 2);
+	FixedPointArray z = randomArray(500, FxpFormat(20, 18), 3);
+	Fxp offset(-5, 6, 2);
+
+	RoundingMode modes[3] = { ROUND_HALF_UP, ROUND_HALF_EVEN, ROUND_FLOOR };
+	for (int m = 0; m < 3; m++)
+	{
+		FixedPointArray y(((x * g + z) + offset).roundBy(8, modes[m])
+			.saturateTo(20));
+		BOOST_CHECK_EQUAL(y.size(), 500U);
+		BOOST_CHECK(y.format() == FxpFormat(20, 17));
+		for (size_t i = 0; i < y.size(); i++)
+		{
+			BOOST_CHECK_EQUAL(y[i], (((x[i] * g[i]) + z[i]) + offset)
+				.roundBy(8, modes[m]).saturateTo(20));
+		}
+	}
+
+	/* Assignment needs the inferred format; assign() resizes */
+	FixedPointArray y(500, FxpFormat(20, 17));
+	y = ((x * g + z) + offset).roundBy(8).saturateTo(20);
+	BOOST_CHECK_THROW(y = x * g, runtime_error);
+	FixedPointArray narrow(0, FxpFormat(8, 7));
+	narrow.assign(x * g, ROUND_HALF_EVEN);
+	BOOST_CHECK_EQUAL(narrow.size(), 500U);
+	for (size_t i = 0; i < narrow.size(); i++)
+	{
+		BOOST_CHECK_EQUAL(narrow[i],
+			(x[i] * g[i]).resize(FxpFormat(8, 7), ROUND_HALF_EVEN));
+	}
+
+	/* Operands may alias the destination */
+	FixedPointArray copy(x);
+	x.assign(x * x);
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		BOOST_CHECK_EQUAL(x[i], (copy[i] * copy[i]).resize(FxpFormat(16, 15)));
+	}
+}
+
+BOOST_AUTO_TEST_CASE( ExpressionArrayErrors )
+{
+	FixedPointArray a = randomArray(10, FxpFormat(8, 7), 4);
+	FixedPointArray b = randomArray(11, FxpFormat(8, 7), 5);
+	BOOST_CHECK_THROW(a + b, runtime_error);
+
+	/* A rounding carry anywhere leaves the destination unchanged */
+	FixedPointArray big(vector<int64_t>(4, 127), FxpFormat(8));
+	FixedPointArray out(4, FxpFormat(7));
+	BOOST_CHECK_THROW(out = big.roundBy(1), range_error);
+	BOOST_CHECK_EQUAL(out[0], Fxp(0, 7));
+	out = big.roundBy(1, ROUND_FLOOR);
+	BOOST_CHECK_EQUAL(out[3], Fxp(63, 7));
+
+	/* Scalars fill the destination */
+	out = lazy(Fxp(-3, 7));
+	BOOST_CHECK_EQUAL(out.size(), 4U);
+	BOOST_CHECK_EQUAL(out[2], Fxp(-3, 7));
+
+	BOOST_CHECK_THROW(FixedPointArray(vector<int64_t>(1, 128), FxpFormat(8)),
+		range_error);
+	BOOST_CHECK_THROW(out.set(0, Fxp(0, 8)), runtime_error);
+	FixedPointArray q = FixedPointArray::quantize(vector<double>(2, 0.25),
+		FxpFormat(8, 7));
+	BOOST_CHECK_EQUAL(q[1], Fxp(32, 8, 7));
+	BOOST_CHECK_EQUAL(q.toDouble()[0], 0.25);
+}
@@ -0,0 +1,115 @@
+#include "boost_test.h"
+#include "FixedPointFft.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+static vector<complex<int64_t> > randomVector(size_t n, int64_t amplitude,
+	uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	vector<complex<int64_t> > x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		x[i] = complex<int64_t>(rng.uniform(-amplitude, amplitude),
+			rng.uniform(-amplitude, amplitude));
+	}
+	return x;
+}
+
+BOOST_AUTO_TEST_CASE( FixedPointFftExactCases )
+{
+	/* Impulse and DC pass through the trivial butterflies exactly */
+	FixedPointFft fft(16, FxpFormat(16, 0), FxpFormat(16, 15), 0);
+	BOOST_CHECK_EQUAL(fft.scaleShift(), 0U);
+	vector<complex<int64_t> > x(16);
+	x[0] = complex<int64_t>(100, -3);
+	fft.transform(x);
+	for (size_t k = 0; k < 16; k++)
+	{
+		BOOST_CHECK(x[k] == complex<int64_t>(100, -3));
+	}
+
+	vector<complex<int64_t> > dc(16, complex<int64_t>(3, 0));
+	fft.transform(dc);
+	BOOST_CHECK(dc[0] == complex<int64_t>(48, 0));
+	for (size_t k = 1; k < 16; k++)
+	{
+		BOOST_CHECK(dc[k] == complex<int64_t>(0, 0));
+	}
+
+	BOOST_CHECK_THROW(FixedPointFft(12, FxpFormat(16, 0), FxpFormat(16, 15)),
+		range_error);
+}
+
+BOOST_AUTO_TEST_CASE( FixedPointFftAccuracy )
+{
+	size_t n = 64;
+	FixedPointFft fft(n, FxpFormat(18, 15), FxpFormat(18, 16));
+	BOOST_CHECK_EQUAL(fft.scaleShift(), 6U);
+
+	vector<complex<int64_t> > x = randomVector(n, 1 << 14, 1);
+	vector<complex<int64_t> > y = x;
+	fft.transform(y);
+
+	double maxError = 0;
+	for (size_t k = 0; k < n; k++)
+	{
+		complex<double> sum = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			double angle = -2 * M_PI * k * i / n;
+			sum += complex<double>(x[i].real(), x[i].imag())
+				* complex<double>(cos(angle), sin(angle));
+		}
+		sum /= (double)n;
+		maxError = max(maxError, abs(sum - complex<double>(y[k].real(),
+			y[k].imag())));
+	}
+	BOOST_CHECK(maxError < 3.0);
+
+	/* Unscaled forward then fully scaled inverse is the identity, to within
+	 * the rounding of the inverse stages */
+	FixedPointFft forward(n, FxpFormat(28, 15), FxpFormat(18, 16), 0);
+	FixedPointFft inverse(n, FxpFormat(28, 15), FxpFormat(18, 16),
+		FixedPointFft::SCALE_ALL, true);
+	vector<complex<int64_t> > z = x;
+	forward.transform(z);
+	inverse.transform(z);
+	for (size_t i = 0; i < n; i++)
+	{
+		BOOST_CHECK(abs(z[i].real() - x[i].real()) <= 2);
+		BOOST_CHECK(abs(z[i].imag() - x[i].imag()) <= 2);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( FixedPointFftBatch )
+{
+	/* Interleaved transforms match one at a time */
+	size_t n = 32;
+	size_t count = 5;
+	FixedPointFft fft(n, FxpFormat(16, 15), FxpFormat(16, 15), 0x15, false,
+		ROUND_FLOOR, OVERFLOW_WRAP);
+	vector<int64_t> real(n * count), imag(n * count);
+	vector<vector<complex<int64_t> > > single;
+	for (size_t t = 0; t < count; t++)
+	{
+		single.push_back(randomVector(n, 1 << 13, t));
+		for (size_t i = 0; i < n; i++)
+		{
+			real[i * count + t] = single[t][i].real();
+			imag[i * count + t] = single[t][i].imag();
+		}
+		fft.transform(single[t]);
+	}
+	fft.transform(&real[0], &imag[0], count);
+	for (size_t t = 0; t < count; t++)
+	{
+		for (size_t k = 0; k < n; k++)
+		{
+			BOOST_CHECK_EQUAL(real[k * count + t], single[t][k].real());
+			BOOST_CHECK_EQUAL(imag[k * count + t], single[t][k].imag());
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#include "boost_test.h"
+#include "FixedPointRegister.h"
+#include "Random.h"
+#include <vector>
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( FxpRegisterAssignment )
+{
+	Fxp a = Fxp::quantize(0.5, 8, 7);
+	Fxp b = Fxp::quantize(0.75, 8, 7);
+
+	/* The product is 16.14; the register keeps 16.15 */
+	FxpReg r(FxpFormat(16, 15));
+	r = a * b;
+	BOOST_CHECK_EQUAL(r, Fxp(12288, 16, 15));
+	r = a + a + a;
+	BOOST_CHECK_EQUAL(r, Fxp(32767, 16, 15));
+
+	/* Register to register resizes with the destination's modes */
+	FxpReg narrow(FxpFormat(4, 3), ROUND_FLOOR, OVERFLOW_WRAP);
+	narrow = r;
+	BOOST_CHECK_EQUAL(narrow, Fxp(7, 4, 3));
+	narrow = a + a;
+	BOOST_CHECK_EQUAL(narrow, Fxp(-8, 4, 3));
+	BOOST_CHECK_EQUAL(narrow.rounding(), ROUND_FLOOR);
+	BOOST_CHECK_EQUAL(narrow.overflow(), OVERFLOW_WRAP);
+
+	FxpReg copy(narrow);
+	copy = Fxp::quantize(0.3, 16, 15);
+	BOOST_CHECK_EQUAL(copy, Fxp(2, 4, 3));
+	BOOST_CHECK_EQUAL(narrow, Fxp(-8, 4, 3));
+
+	/* Registers take part in arithmetic as plain values */
+	BOOST_CHECK_EQUAL(copy * copy, Fxp(4, 8, 6));
+}
+
+BOOST_AUTO_TEST_CASE( CFxpRegisterAssignment )
+{
+	CFxp a = CFxp::quantize(complex<double>(0.5, -0.25), 8, 7);
+	CFxp b = CFxp::quantize(complex<double>(0.5, 0.5), 8, 7);
+
+	CFxpReg r(FxpFormat(12, 10));
+	r = a * b;
+	BOOST_CHECK_EQUAL(r, CFxp(384, 128, 12, 10));
+
+	CFxpReg narrow(FxpFormat(4, 3), ROUND_HALF_UP, OVERFLOW_SATURATE);
+	narrow = r;
+	BOOST_CHECK_EQUAL(narrow, CFxp(3, 1, 4, 3));
+	CFxpReg copy(narrow);
+	copy = CFxp(-1000, 1000, 12);
+	BOOST_CHECK_EQUAL(copy, CFxp(-8, 7, 4, 3));
+	BOOST_CHECK_EQUAL(narrow, CFxp(3, 1, 4, 3));
+}
+
+BOOST_AUTO_TEST_CASE( ResizeValuesMatchesFxp )
+{
+	Xoshiro256 rng(5);
+	vector<int64_t> in(1000);
+	for (size_t i = 0; i < in.size(); i++)
+	{
+		in[i] = rng.uniform(-(1 << 19), 1 << 19);
+	}
+
+	FixedPointFormat formats[3] = { FxpFormat(12, 6), FxpFormat(16, 12),
+		FxpFormat(24, 16) };
+	RoundingMode roundings[2] = { ROUND_FLOOR, ROUND_HALF_UP };
+	OverflowMode overflows[2] = { OVERFLOW_WRAP, OVERFLOW_SATURATE };
+	for (int f = 0; f < 3; f++)
+	{
+		for (int r = 0; r < 2; r++)
+		{
+			for (int o = 0; o < 2; o++)
+			{
+				vector<int64_t> out(in.size());
+				resizeValues(&in[0], &out[0], in.size(), 10, formats[f],
+					roundings[r], overflows[o]);
+				for (size_t i = 0; i < in.size(); i++)
+				{
+					Fxp x(in[i], 20, 10);
+					x.resize(formats[f], roundings[r], overflows[o]);
+					BOOST_CHECK_EQUAL(out[i], x.val());
+				}
+
+				/* In place gives the same */
+				vector<int64_t> inPlace(in);
+				resizeValues(&inPlace[0], &inPlace[0], in.size(), 10,
+					formats[f], roundings[r], overflows[o]);
+				BOOST_CHECK(inPlace == out);
+			}
+		}
+	}
+}
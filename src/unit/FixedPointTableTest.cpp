@@ -0,0 +1,65 @@
+#include "boost_test.h"
+#include "FixedPointTable.h"
+#include <cmath>
+
+using namespace std;
+
+/* Tables below are built entirely by the compiler */
+static constexpr double TAPS[] = { 0.125, -0.3, 0.99, -1.0 };
+static constexpr FixedPointTable<4> s_taps(FxpFormat(10, 9), TAPS);
+static constexpr FixedPointTable<64> s_hann(FxpFormat(18, 17),
+	[](size_t i) { return hannWindow(i, 64); });
+static constexpr ComplexFixedPointTable<256> s_twiddles =
+	ComplexFixedPointTable<256>::twiddles(FxpFormat(16, 14));
+
+static_assert(quantizeValue(2.34, FxpFormat(12, 4)) == 37,
+	"constexpr quantize rounds like FixedPoint::quantize");
+static_assert(quantizeValue(-0.5, FxpFormat(4)) == 0, "round half up");
+static_assert(quantizeValue(-1.5, FxpFormat(4)) == -1, "round half up");
+static_assert(s_taps.val(1) == -154, "table values are constant");
+static_assert(s_twiddles.real(0) == 16384 && s_twiddles.imag(64) == -16384,
+	"twiddles are constant");
+
+BOOST_AUTO_TEST_CASE( FixedPointTableValues )
+{
+	BOOST_CHECK_EQUAL(s_taps.size(), 4);
+	for (size_t i = 0; i < 4; i++)
+	{
+		BOOST_CHECK_EQUAL(s_taps[i], Fxp::quantize(TAPS[i], 10, 9));
+	}
+	BOOST_CHECK(s_taps.format() == FxpFormat(10, 9));
+}
+
+BOOST_AUTO_TEST_CASE( FixedPointTableMatchesRuntime )
+{
+	/* Same rounding as the runtime quantize() on libm results */
+	for (size_t i = 0; i < 64; i++)
+	{
+		double hann = 0.5 - 0.5 * cos(2 * M_PI * i / 63);
+		BOOST_CHECK_EQUAL(s_hann.val(i), Fxp::quantize(hann, 18, 17).val());
+	}
+
+	for (size_t k = 0; k < 256; k++)
+	{
+		CFxp expected = CFxp::quantize(polar(1.0, -2 * M_PI * k / 256), 16, 14);
+		BOOST_CHECK_EQUAL(s_twiddles[k], expected);
+	}
+
+	for (double x = -20.0; x < 20.0; x += 0.37)
+	{
+		BOOST_CHECK_SMALL(constexprSin(x) - sin(x), 1e-14);
+		BOOST_CHECK_SMALL(constexprCos(x) - cos(x), 1e-14);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( FixedPointTableRange )
+{
+	/* Out of range values throw at run time (and fail to compile in a
+	 * constant expression) */
+	BOOST_CHECK_THROW(quantizeValue(1.0, FxpFormat(8, 7)), range_error);
+	BOOST_CHECK_THROW(quantizeValue(1e300, FxpFormat(64)), range_error);
+	BOOST_CHECK_THROW(quantizeValue(NAN, FxpFormat(64)), range_error);
+	BOOST_CHECK_THROW(FixedPointTable<2>(FxpFormat(8, 7),
+		[](size_t i) { return i * 1.5; }), range_error);
+	BOOST_CHECK_EQUAL(quantizeValue(-1.0, FxpFormat(8, 7)), -128);
+}
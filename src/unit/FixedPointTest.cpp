@@ -1,5 +1,6 @@
 #include "boost_test.h"
 #include "FixedPoint.h"
+#include <cmath>
 
 using namespace std;
 
@@ -18,6 +19,9 @@ BOOST_AUTO_TEST_CASE( FxpConstructors )
 	/* Width larger than max allowed width */
 	BOOST_CHECK_THROW(Fxp(0, Fxp::MAX_WIDTH + 1), range_error);
 
+	/* Zero width */
+	BOOST_CHECK_THROW(Fxp(0, 0), range_error);
+
 	/* More fractional bits than total bits */
 	BOOST_CHECK_THROW(Fxp(0, 2, 3), range_error);
 }
@@ -205,6 +209,14 @@ BOOST_AUTO_TEST_CASE( FxpSaturation )
 	/* Go beyond allowed range */
 	BOOST_CHECK_THROW(a.saturateTo(0), std::range_error);
 	BOOST_CHECK_THROW(a.saturateBy(a.width()), std::range_error);
+
+	/* Full 64 bit width */
+	Fxp c(INT64_MIN, 64);
+	BOOST_CHECK_EQUAL(c.saturateTo(64), Fxp(INT64_MIN, 64));
+	BOOST_CHECK_EQUAL(c.saturateTo(8), Fxp(-128, 8));
+
+	/* Fewer total bits than fractional bits */
+	BOOST_CHECK_THROW(Fxp(3, 8, 6).saturateTo(5), std::range_error);
 }
 
 BOOST_AUTO_TEST_CASE( FxpRounding )
@@ -218,6 +230,70 @@ BOOST_AUTO_TEST_CASE( FxpRounding )
 	/* Go beyond allowed range */
 	BOOST_CHECK_THROW(a.roundTo(0), std::range_error);
 	BOOST_CHECK_THROW(a.roundBy(a.width()), std::range_error);
+
+	/* Rounding by zero bits leaves the value unchanged */
+	Fxp b(-3, 8, 2);
+	BOOST_CHECK_EQUAL(b.roundBy(0), Fxp(-3, 8, 2));
+
+	/* Rounding the largest values up does not fit the narrower width */
+	BOOST_CHECK_THROW(Fxp(127, 8).roundBy(1), std::range_error);
+	BOOST_CHECK_EQUAL(Fxp(125, 8).roundBy(1), Fxp(63, 7));
+	BOOST_CHECK_EQUAL(Fxp(-128, 8).roundBy(1), Fxp(-64, 7));
+}
+
+BOOST_AUTO_TEST_CASE( FxpRoundingModes )
+{
+	/* Quarters rounded to integers, one column per mode */
+	RoundingMode modes[6] = { ROUND_FLOOR, ROUND_HALF_UP, ROUND_HALF_EVEN,
+		ROUND_HALF_AWAY, ROUND_TOWARD_ZERO, ROUND_CEIL };
+	int64_t values[7] = { 6, 2, -2, -6, 5, -5, -7 };
+	int64_t expected[7][6] = {
+		{ 1, 2, 2, 2, 1, 2 },
+		{ 0, 1, 0, 1, 0, 1 },
+		{ -1, 0, 0, -1, 0, 0 },
+		{ -2, -1, -2, -2, -1, -1 },
+		{ 1, 1, 1, 1, 1, 2 },
+		{ -2, -1, -1, -1, -1, -1 },
+		{ -2, -2, -2, -2, -1, -1 },
+	};
+	for (int v = 0; v < 7; v++)
+	{
+		for (int m = 0; m < 6; m++)
+		{
+			BOOST_CHECK_EQUAL(Fxp(values[v], 8, 2).roundBy(2, modes[m]),
+				Fxp(expected[v][m], 6, 0));
+			BOOST_CHECK_EQUAL(roundShift(values[v], 2, modes[m]),
+				expected[v][m]);
+		}
+	}
+	BOOST_CHECK_EQUAL(Fxp(-6, 8, 2).roundTo(6, ROUND_HALF_EVEN), Fxp(-2, 6));
+
+	/* Zero LSBs and the widest shifts leave nothing to overflow */
+	for (int m = 0; m < 6; m++)
+	{
+		BOOST_CHECK_EQUAL(roundShift(-3, 0, modes[m]), -3);
+		BOOST_CHECK_EQUAL(roundShift(INT64_MIN, 63, modes[m]), -1);
+		BOOST_CHECK(roundShift(INT64_MAX, 63, modes[m]) <= 1);
+	}
+	BOOST_CHECK_EQUAL(roundShift(INT64_MAX, 63, ROUND_CEIL), 1);
+	BOOST_CHECK_EQUAL(roundShift(INT64_MAX, 63, ROUND_FLOOR), 0);
+
+	/* Modes that round the largest values up still overflow the width */
+	BOOST_CHECK_THROW(Fxp(127, 8).roundBy(1, ROUND_CEIL), std::range_error);
+	BOOST_CHECK_EQUAL(Fxp(127, 8).roundBy(1, ROUND_TOWARD_ZERO), Fxp(63, 7));
+	BOOST_CHECK_EQUAL(Fxp(-127, 8).roundBy(1, ROUND_HALF_AWAY), Fxp(-64, 7));
+
+	/* The batch kernel matches the scalar one */
+	int64_t in[9] = { -9, -6, -5, -2, 0, 2, 5, 6, 9 };
+	for (int m = 0; m < 6; m++)
+	{
+		int64_t out[9];
+		roundShiftValues(in, out, 9, 2, modes[m]);
+		for (int i = 0; i < 9; i++)
+		{
+			BOOST_CHECK_EQUAL(out[i], roundShift(in[i], 2, modes[m]));
+		}
+	}
 }
 
 BOOST_AUTO_TEST_CASE( FxpSignExtension )
@@ -234,6 +310,61 @@ BOOST_AUTO_TEST_CASE( FxpSignExtension )
 	/* Try to sign extend beyond allowed range */
 	BOOST_CHECK_THROW(a.signExtendTo(Fxp::MAX_WIDTH + 1), std::range_error);
 	BOOST_CHECK_THROW(a.signExtendBy(Fxp::MAX_WIDTH - a.width() + 1), std::range_error);
+
+	/* Sign extending to a narrower width */
+	BOOST_CHECK_THROW(b.signExtendTo(8), std::range_error);
+}
+
+BOOST_AUTO_TEST_CASE( FxpResize )
+{
+	/* Fewer fractional bits: rounded, then saturated or wrapped */
+	BOOST_CHECK_EQUAL(Fxp(47, 10, 4).resize(FxpFormat(8, 2)), Fxp(12, 8, 2));
+	BOOST_CHECK_EQUAL(Fxp(47, 10, 4).resize(FxpFormat(8, 2), ROUND_FLOOR),
+		Fxp(11, 8, 2));
+	BOOST_CHECK_EQUAL(Fxp(1000, 12, 2).resize(FxpFormat(8, 2)),
+		Fxp(127, 8, 2));
+	BOOST_CHECK_EQUAL(Fxp(1000, 12, 2).resize(FxpFormat(8, 2), ROUND_HALF_UP,
+		OVERFLOW_WRAP), Fxp(-24, 8, 2));
+
+	/* More fractional bits: shifted up, clamped before the shift */
+	BOOST_CHECK_EQUAL(Fxp(100, 8).resize(FxpFormat(10, 4)), Fxp(511, 10, 4));
+	BOOST_CHECK_EQUAL(Fxp(100, 8).resize(FxpFormat(10, 4), ROUND_HALF_UP,
+		OVERFLOW_WRAP), Fxp(-448, 10, 4));
+	BOOST_CHECK_EQUAL(Fxp(-100, 64).resize(FxpFormat(64, 62)),
+		Fxp(INT64_MIN, 64, 62));
+	BOOST_CHECK_EQUAL(Fxp(-1, 4).resize(FxpFormat(8, 8)), Fxp(-128, 8, 8));
+	BOOST_CHECK_EQUAL(Fxp(3, 4, 1).resize(FxpFormat(16, 8)), Fxp(384, 16, 8));
+
+	/* Unlike roundBy(), rounding into the sign bit saturates */
+	BOOST_CHECK_EQUAL(Fxp(127, 8).resize(FxpFormat(7)), Fxp(63, 7));
+
+	/* The binary point moves by all 64 bits */
+	BOOST_CHECK_EQUAL(Fxp(1, 64).resize(FxpFormat(64, 64), ROUND_HALF_UP,
+		OVERFLOW_WRAP), Fxp(0, 64, 64));
+	BOOST_CHECK_EQUAL(Fxp(1, 64).resize(FxpFormat(64, 64)),
+		Fxp(INT64_MAX, 64, 64));
+	BOOST_CHECK_EQUAL(Fxp(-1, 64).resize(FxpFormat(64, 64)),
+		Fxp(INT64_MIN, 64, 64));
+	BOOST_CHECK_EQUAL(Fxp(0, 64).resize(FxpFormat(64, 64)), Fxp(0, 64, 64));
+	BOOST_CHECK_EQUAL(Fxp(5, 64, 64).resize(FxpFormat(64)), Fxp(0, 64));
+	BOOST_CHECK_EQUAL(Fxp(5, 64, 64).resize(FxpFormat(64), ROUND_CEIL),
+		Fxp(1, 64));
+	BOOST_CHECK_EQUAL(Fxp(-5, 64, 64).resize(FxpFormat(64), ROUND_FLOOR),
+		Fxp(-1, 64));
+	BOOST_CHECK_EQUAL(Fxp(INT64_MIN, 64, 64).resize(FxpFormat(64)),
+		Fxp(0, 64));
+	BOOST_CHECK_EQUAL(Fxp(INT64_MIN, 64, 64).resize(FxpFormat(64),
+		ROUND_HALF_AWAY), Fxp(-1, 64));
+
+	/* assign() keeps the destination format */
+	Fxp reg(0, 8, 4);
+	reg.assign(Fxp(1000, 12, 6));
+	BOOST_CHECK_EQUAL(reg, Fxp(127, 8, 4));
+	BOOST_CHECK_EQUAL(reg.maxHeldVal(), 127);
+	reg.assign(Fxp(-3, 4, 1), ROUND_FLOOR, OVERFLOW_WRAP);
+	BOOST_CHECK_EQUAL(reg, Fxp(-24, 8, 4));
+	BOOST_CHECK_EQUAL(reg.minHeldVal(), -24);
+	BOOST_CHECK(reg.format() == FxpFormat(8, 4));
 }
 
 BOOST_AUTO_TEST_CASE( FxpToFloat )
@@ -0,0 +1,112 @@
+#include "boost_test.h"
+#include "MonteCarloAnalyzer.h"
+#include <cmath>
+
+using namespace std;
+
+static vector<double> uniformStimulus(Xoshiro256 &rng)
+{
+	vector<double> x(1024);
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = 2 * rng.uniformDouble() - 1;
+	}
+	return x;
+}
+
+static vector<double> identity(const vector<double> &x)
+{
+	return x;
+}
+
+/* Rounds to 12 fractional bits */
+static vector<double> quantized(const vector<double> &x)
+{
+	vector<double> y(x.size());
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		y[i] = floor(x[i] * 4096 + 0.5) / 4096;
+	}
+	return y;
+}
+
+BOOST_AUTO_TEST_CASE( MonteCarloQuantizationNoise )
+{
+	MonteCarloAnalyzer analyzer(uniformStimulus, quantized, identity, 256);
+	MonteCarloReport report = analyzer.run(100, 7);
+	BOOST_CHECK_EQUAL(report.numTrials, 100U);
+	BOOST_CHECK_EQUAL(report.numSamples, 102400U);
+
+	/* Uniform signal power 1/3, rounding noise 2^-24 / 12 */
+	double expected = 10 * log10((1.0 / 3) / (ldexp(1.0, -24) / 12));
+	BOOST_CHECK(fabs(report.sqnrDb - expected) < 0.2);
+	BOOST_CHECK(fabs(report.enob - (expected - 1.76) / 6.02) < 0.05);
+	BOOST_CHECK(report.maxError <= ldexp(1.0, -13));
+	BOOST_CHECK(fabs(report.meanError) < 1e-5);
+	BOOST_CHECK(report.worstTrialSqnrDb <= report.sqnrDb);
+	BOOST_CHECK(report.worstTrial < 100U);
+
+	/* White error: flat spectrum summing to the noise power */
+	BOOST_CHECK_EQUAL(report.errorSpectrum.size(), 256U);
+	double sum = 0;
+	for (size_t k = 0; k < report.errorSpectrum.size(); k++)
+	{
+		sum += report.errorSpectrum[k];
+		BOOST_CHECK(report.errorSpectrum[k] < 2 * report.noisePower / 256);
+	}
+	BOOST_CHECK(fabs(sum / report.noisePower - 1) < 0.05);
+	BOOST_CHECK(report.summary().find("100 trials") == 0);
+}
+
+BOOST_AUTO_TEST_CASE( MonteCarloDeterministic )
+{
+	MonteCarloAnalyzer serial(uniformStimulus, quantized, identity, 64, 1);
+	MonteCarloAnalyzer threaded(uniformStimulus, quantized, identity, 64, 4);
+	MonteCarloReport a = serial.run(37, 123);
+	MonteCarloReport b = threaded.run(37, 123);
+	BOOST_CHECK_EQUAL(a.sqnrDb, b.sqnrDb);
+	BOOST_CHECK_EQUAL(a.meanError, b.meanError);
+	BOOST_CHECK_EQUAL(a.maxError, b.maxError);
+	BOOST_CHECK_EQUAL(a.worstTrial, b.worstTrial);
+	BOOST_CHECK(a.errorSpectrum == b.errorSpectrum);
+	BOOST_CHECK_EQUAL(a.summary(), b.summary());
+
+	/* Another seed draws other stimuli */
+	BOOST_CHECK(serial.run(37, 124).sqnrDb != a.sqnrDb);
+}
+
+BOOST_AUTO_TEST_CASE( MonteCarloErrorSpectrum )
+{
+	/* A small tone on bin 8 of 64 dominates the error spectrum */
+	MonteCarloAnalyzer analyzer(uniformStimulus,
+		[](const vector<double> &x)
+		{
+			vector<double> y(x);
+			for (size_t i = 0; i < y.size(); i++)
+			{
+				y[i] += 1e-3 * cos(2 * M_PI * 8 * i / 64);
+			}
+			return y;
+		}, identity, 64);
+	MonteCarloReport report = analyzer.run(8, 1);
+	size_t peak = 0;
+	for (size_t k = 1; k < 32; k++)
+	{
+		if (report.errorSpectrum[k] > report.errorSpectrum[peak])
+		{
+			peak = k;
+		}
+	}
+	BOOST_CHECK_EQUAL(peak, 8U);
+	BOOST_CHECK(fabs(report.errorSpectrum[8] + report.errorSpectrum[56]
+		- 0.5e-6 * 2.0 / 3) < 1e-9);
+
+	/* Identical models: no error at all */
+	MonteCarloAnalyzer exact(uniformStimulus, identity, identity);
+	MonteCarloReport none = exact.run(4, 1);
+	BOOST_CHECK(std::isinf(none.sqnrDb));
+	BOOST_CHECK_EQUAL(none.maxError, 0.0);
+	BOOST_CHECK(none.errorSpectrum.empty());
+	BOOST_CHECK_THROW(MonteCarloAnalyzer(uniformStimulus, identity, identity,
+		100), range_error);
+}
@@ -0,0 +1,239 @@
+#include "boost_test.h"
+#include "Multichannel.h"
+#include "Random.h"
+
+using namespace std;
+
+static void fillRandom(MultichannelBuffer &buffer, uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	FixedPointFormat format = buffer.format();
+	for (size_t i = 0; i < buffer.numChannels() * buffer.numFrames(); i++)
+	{
+		buffer.data()[i] = rng.uniform(format.minVal(), format.maxVal());
+	}
+}
+
+BOOST_AUTO_TEST_CASE( MultichannelBufferLayout )
+{
+	MultichannelBuffer buffer(3, 4, FxpFormat(12, 4));
+	buffer.set(2, 1, Fxp(-7, 12, 4));
+	BOOST_CHECK_EQUAL(buffer.data()[2 * 3 + 1], -7);
+	BOOST_CHECK_EQUAL(buffer.frame(2)[1], -7);
+	BOOST_CHECK_EQUAL(buffer.get(2, 1), Fxp(-7, 12, 4));
+
+	int64_t channel[4] = { 1, 2, 3, 4 };
+	buffer.writeChannel(0, channel);
+	BOOST_CHECK_EQUAL(buffer.frame(3)[0], 4);
+	int64_t check[4];
+	buffer.readChannel(1, check);
+	BOOST_CHECK_EQUAL(check[2], -7);
+
+	BOOST_CHECK_THROW(buffer.set(0, 0, Fxp(0, 12, 5)), runtime_error);
+	BOOST_CHECK_THROW(buffer.get(4, 0), range_error);
+
+	ComplexMultichannelBuffer complexBuffer(2, 2, FxpFormat(8, 2));
+	complexBuffer.set(1, 1, CFxp(3, -4, 8, 2));
+	BOOST_CHECK_EQUAL(complexBuffer.real().frame(1)[1], 3);
+	BOOST_CHECK_EQUAL(complexBuffer.imag().frame(1)[1], -4);
+	BOOST_CHECK_EQUAL(complexBuffer.get(1, 1), CFxp(3, -4, 8, 2));
+}
+
+BOOST_AUTO_TEST_CASE( MultichannelEngineOperations )
+{
+	unsigned int channels = 100;
+	size_t frames = 20;
+	MultichannelBuffer a(channels, frames, FxpFormat(16, 12));
+	MultichannelBuffer b(channels, frames, FxpFormat(16, 15));
+	fillRandom(a, 1);
+	fillRandom(b, 2);
+	vector<int64_t> gains(channels);
+	for (unsigned int c = 0; c < channels; c++)
+	{
+		gains[c] = (int64_t)c * 301 - 15000;
+	}
+
+	/* Thread count and group size do not change any result */
+	MultichannelEngine serial(1, 1);
+	MultichannelEngine parallel(4, 8);
+	MultichannelBuffer out1(channels, 0, FxpFormat(12, 6));
+	MultichannelBuffer out2(channels, 0, FxpFormat(12, 6));
+
+	serial.requantize(a, out1);
+	parallel.requantize(a, out2, ROUND_HALF_UP, OVERFLOW_SATURATE);
+	BOOST_CHECK_EQUAL(out1.numFrames(), frames);
+	for (size_t i = 0; i < channels * frames; i++)
+	{
+		int64_t expected = saturateValue(roundShift(a.data()[i], 6,
+			ROUND_HALF_UP), 12);
+		BOOST_CHECK_EQUAL(out1.data()[i], expected);
+		BOOST_CHECK_EQUAL(out2.data()[i], expected);
+	}
+
+	serial.multiply(a, b, out1, ROUND_FLOOR, OVERFLOW_WRAP);
+	parallel.multiply(a, b, out2, ROUND_FLOOR, OVERFLOW_WRAP);
+	for (size_t i = 0; i < channels * frames; i++)
+	{
+		int64_t expected = wrapValue((a.data()[i] * b.data()[i]) >> 21, 12);
+		BOOST_CHECK_EQUAL(out1.data()[i], expected);
+		BOOST_CHECK_EQUAL(out2.data()[i], expected);
+	}
+
+	serial.multiply(a, gains, FxpFormat(16, 15), out1);
+	parallel.multiply(a, gains, FxpFormat(16, 15), out2);
+	BOOST_CHECK(out1.get(5, 17) == out2.get(5, 17));
+	BOOST_CHECK_EQUAL(out1.frame(5)[17], saturateValue(roundShift(
+		a.frame(5)[17] * gains[17], 21, ROUND_HALF_UP), 12));
+
+	/* Accumulating twice into a zeroed accumulator doubles the input */
+	MultichannelBuffer acc(channels, frames, FxpFormat(24, 12));
+	serial.accumulate(a, acc);
+	parallel.accumulate(a, acc);
+	BOOST_CHECK_EQUAL(acc.frame(7)[99], 2 * a.frame(7)[99]);
+
+	/* Accumulating a buffer into itself doubles it */
+	parallel.accumulate(acc, acc);
+	for (size_t i = 0; i < channels * frames; i++)
+	{
+		BOOST_CHECK_EQUAL(acc.data()[i], 4 * a.data()[i]);
+	}
+
+	/* Products shifted up into more fractional bits saturate, not wrap */
+	MultichannelBuffer small(2, 1, FxpFormat(16));
+	small.frame(0)[0] = 1000;
+	small.frame(0)[1] = -1000;
+	MultichannelBuffer wide(2, 0, FxpFormat(64, 62));
+	serial.multiply(small, small, wide);
+	BOOST_CHECK_EQUAL(wide.frame(0)[0], INT64_MAX);
+	BOOST_CHECK_EQUAL(wide.frame(0)[1], INT64_MAX);
+	parallel.multiply(small, vector<int64_t>(2, 1), FxpFormat(16), wide);
+	BOOST_CHECK_EQUAL(wide.frame(0)[0], INT64_MAX);
+	BOOST_CHECK_EQUAL(wide.frame(0)[1], INT64_MIN);
+
+	/* Mismatched shapes */
+	MultichannelBuffer other(channels + 1, frames, FxpFormat(16, 12));
+	BOOST_CHECK_THROW(serial.requantize(other, out1), runtime_error);
+	MultichannelBuffer shortAcc(channels, frames - 1, FxpFormat(24, 12));
+	BOOST_CHECK_THROW(serial.accumulate(a, shortAcc), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE( MultichannelEngineComplex )
+{
+	unsigned int channels = 70;
+	size_t frames = 9;
+	ComplexMultichannelBuffer x(channels, frames, FxpFormat(16, 14));
+	fillRandom(x.real(), 3);
+	fillRandom(x.imag(), 4);
+
+	/* Per-channel phase rotation, as a beamformer steering vector */
+	vector<complex<int64_t> > steer(channels);
+	for (unsigned int c = 0; c < channels; c++)
+	{
+		steer[c] = complex<int64_t>(c % 3 == 0 ? 16384 : 0,
+			c % 3 == 1 ? 16384 : (c % 3 == 2 ? -16384 : 0));
+	}
+	ComplexMultichannelBuffer y(channels, 0, FxpFormat(18, 14));
+	MultichannelEngine(3, 16).multiply(x, steer, FxpFormat(16, 14), y);
+	for (size_t f = 0; f < frames; f++)
+	{
+		for (unsigned int c = 0; c < channels; c++)
+		{
+			complex<int64_t> v = x.get(f, c);
+			complex<int64_t> expected = (c % 3 == 0) ? v
+				: ((c % 3 == 1) ? complex<int64_t>(-v.imag(), v.real())
+				: complex<int64_t>(v.imag(), -v.real()));
+			BOOST_CHECK(complex<int64_t>(y.get(f, c)) == expected);
+		}
+	}
+
+	/* Full precision complex product against CFxp multiplication */
+	ComplexMultichannelBuffer z(channels, 0, FxpFormat(33, 28));
+	MultichannelEngine(2, 8).multiply(x, x, z);
+	CFxp expected = x.get(4, 33) * x.get(4, 33);
+	BOOST_CHECK_EQUAL(z.get(4, 33), expected);
+
+	/* Shifted up by 63 bits, (1 + 1j)^2 saturates the imaginary part and
+	 * leaves the zero real part */
+	ComplexMultichannelBuffer unit(1, 1, FxpFormat(8));
+	unit.set(0, 0, CFxp(1, 1, 8));
+	ComplexMultichannelBuffer wide(1, 0, FxpFormat(64, 63));
+	MultichannelEngine(1, 1).multiply(unit, unit, wide);
+	BOOST_CHECK_EQUAL(wide.real().frame(0)[0], 0);
+	BOOST_CHECK_EQUAL(wide.imag().frame(0)[0], INT64_MAX);
+	MultichannelEngine(1, 1).multiply(unit,
+		vector<complex<int64_t> >(1, complex<int64_t>(0, -3)), FxpFormat(8),
+		wide);
+	BOOST_CHECK_EQUAL(wide.real().frame(0)[0], INT64_MAX);
+	BOOST_CHECK_EQUAL(wide.imag().frame(0)[0], INT64_MIN);
+}
+
+BOOST_AUTO_TEST_CASE( MultichannelFilters )
+{
+	unsigned int channels = 40;
+	size_t frames = 64;
+	MultichannelBuffer x(channels, frames, FxpFormat(16, 15));
+	fillRandom(x, 9);
+
+	vector<double> h;
+	h.push_back(0.25);
+	h.push_back(-0.5);
+	h.push_back(0.75);
+	h.push_back(0.125);
+	MultichannelFir fir(h, FxpFormat(16, 14), channels, FxpFormat(16, 15),
+		FxpFormat(20, 15));
+	MultichannelFir firBlocks(h, FxpFormat(16, 14), channels,
+		FxpFormat(16, 15), FxpFormat(20, 15));
+	MultichannelBuffer y(channels, 0, FxpFormat(20, 15));
+	fir.process(x, y, MultichannelEngine(1));
+
+	/* Same output when fed in short blocks on several threads */
+	MultichannelBuffer yBlocks(channels, 0, FxpFormat(20, 15));
+	for (size_t f0 = 0; f0 < frames; f0 += 2)
+	{
+		MultichannelBuffer in(channels, 2, FxpFormat(16, 15));
+		copy(x.frame(f0), x.frame(f0) + 2 * channels, in.data());
+		firBlocks.process(in, yBlocks, MultichannelEngine(3, 8));
+		for (size_t i = 0; i < 2 * channels; i++)
+		{
+			BOOST_CHECK_EQUAL(yBlocks.data()[i], y.frame(f0)[i]);
+		}
+	}
+
+	int64_t coefs[4] = { 4096, -8192, 12288, 2048 };
+	for (unsigned int c = 0; c < channels; c += 13)
+	{
+		for (size_t f = 0; f < frames; f++)
+		{
+			int64_t sum = 0;
+			for (size_t k = 0; k < 4 && k <= f; k++)
+			{
+				sum += coefs[k] * x.frame(f - k)[c];
+			}
+			BOOST_CHECK_EQUAL(y.frame(f)[c], roundShift(sum, 14, ROUND_HALF_UP));
+		}
+	}
+
+	/* One-pole smoother y = x / 4 + 3 y / 4, checked per channel */
+	vector<double> b(3, 0.0);
+	vector<double> a(3, 0.0);
+	b[0] = 0.25;
+	a[0] = 1.0;
+	a[1] = -0.75;
+	MultichannelBiquad iir(b, a, FxpFormat(16, 14), channels,
+		FxpFormat(16, 15), FxpFormat(18, 15));
+	MultichannelBuffer smoothed(channels, 0, FxpFormat(18, 15));
+	iir.process(x, smoothed, MultichannelEngine(4, 8));
+	for (unsigned int c = 0; c < channels; c += 7)
+	{
+		int64_t state = 0;
+		for (size_t f = 0; f < frames; f++)
+		{
+			state = roundShift(4096 * x.frame(f)[c] + 12288 * state, 14,
+				ROUND_HALF_UP);
+			BOOST_CHECK_EQUAL(smoothed.frame(f)[c], state);
+		}
+	}
+
+	BOOST_CHECK_THROW(MultichannelBiquad(b, b, FxpFormat(16, 14), channels,
+		FxpFormat(16, 15), FxpFormat(18, 15)), runtime_error);
+}
@@ -0,0 +1,138 @@
+#include "boost_test.h"
+#include "NoiseShaper.h"
+#include <cstdlib>
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( NoiseShaperPlainRounding )
+{
+	/* Without feedback or dither this is round half up plus saturation */
+	NoiseShaper q(FxpFormat(12, 6), FxpFormat(8, 2));
+	for (int64_t v = -2048; v < 2048; v += 7)
+	{
+		int64_t rounded = (v + 8) >> 4;
+		int64_t clipped = max(min(rounded, (int64_t)127), (int64_t)-128);
+		BOOST_CHECK_EQUAL(q.process(Fxp(v, 12, 6)), Fxp(clipped, 8, 2));
+	}
+
+	/* Invalid configurations */
+	BOOST_CHECK_THROW(NoiseShaper(FxpFormat(12, 2), FxpFormat(8, 2)),
+		range_error);
+	BOOST_CHECK_THROW(q.process(Fxp(0, 12, 5)), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE( NoiseShaperFirstOrder )
+{
+	/* NTF = 1 - z^-1: the accumulated error telescopes, so the output
+	 * tracks the mean of the input to within one output LSB */
+	NoiseShaper q(FxpFormat(16, 4), FxpFormat(16, 0), vector<double>(1, 1.0));
+	vector<int64_t> x(1000), y(1000);
+	int64_t inputSum = 0;
+	int64_t outputSum = 0;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)(i * 37 % 101) - 50;
+		inputSum += x[i];
+	}
+	q.process(&x[0], &y[0], x.size());
+	for (size_t i = 0; i < y.size(); i++)
+	{
+		outputSum += y[i];
+	}
+	BOOST_CHECK(llabs(outputSum * 16 - inputSum) <= 16);
+
+	/* A constant quarter LSB is dithered by the loop, not rounded away */
+	q.reset();
+	vector<int64_t> quarter(400, 4);
+	q.process(&quarter[0], &y[0], quarter.size());
+	outputSum = 0;
+	for (size_t i = 0; i < 400; i++)
+	{
+		outputSum += y[i];
+	}
+	BOOST_CHECK_EQUAL(outputSum, 100);
+}
+
+BOOST_AUTO_TEST_CASE( NoiseShaperSecondOrder )
+{
+	/* NTF = (1 - z^-1)^2: the doubly accumulated error is bounded too */
+	vector<double> h;
+	h.push_back(2.0);
+	h.push_back(-1.0);
+	NoiseShaper q(FxpFormat(20, 8), FxpFormat(16, 0), h);
+	vector<int64_t> x(2000), y(2000);
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)((i * 2654435761ULL) % 4096) - 2048;
+	}
+	q.process(&x[0], &y[0], x.size());
+
+	int64_t sum = 0;
+	int64_t sumOfSums = 0;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		sum += y[i] * 256 - x[i];
+		sumOfSums += sum;
+	}
+	BOOST_CHECK(llabs(sumOfSums) <= 4 * 256);
+}
+
+BOOST_AUTO_TEST_CASE( NoiseShaperDither )
+{
+	const unsigned int channels = 4;
+	NoiseShaper a(FxpFormat(16, 4), FxpFormat(12, 0), vector<double>(), 12,
+		true, 99, channels);
+	NoiseShaper b(FxpFormat(16, 4), FxpFormat(12, 0), vector<double>(), 12,
+		true, 99, channels);
+
+	vector<int64_t> x(channels * 1000, 40);
+	vector<int64_t> ya(x.size()), yb(x.size());
+	a.process(&x[0], &ya[0], 1000);
+	b.process(&x[0], &yb[0], 1000);
+
+	/* Deterministic for a given seed; channels get independent streams */
+	BOOST_CHECK(ya == yb);
+	bool channelsDiffer = false;
+	int64_t sum = 0;
+	for (size_t i = 0; i < ya.size(); i++)
+	{
+		/* 2.5 LSB +/- 1 LSB of triangular dither */
+		BOOST_CHECK(ya[i] >= 1 && ya[i] <= 4);
+		channelsDiffer |= (ya[i] != ya[i - i % channels]);
+		sum += ya[i];
+	}
+	BOOST_CHECK(channelsDiffer);
+
+	/* Dither is zero mean */
+	BOOST_CHECK_CLOSE((double)sum / ya.size(), 2.5, 4.0);
+
+	/* Reset restarts the dither sequence */
+	a.reset();
+	a.process(&x[0], &yb[0], 1000);
+	BOOST_CHECK(ya == yb);
+}
+
+BOOST_AUTO_TEST_CASE( NoiseShaperChannels )
+{
+	/* Interleaved channels match separate single channel shapers */
+	const unsigned int channels = 3;
+	vector<double> h(1, 1.0);
+	NoiseShaper multi(FxpFormat(16, 6), FxpFormat(10, 0), h, 12, false, 0,
+		channels);
+	vector<int64_t> x(channels * 500), y(x.size());
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)((i * 7919) % 30000) - 15000;
+	}
+	multi.process(&x[0], &y[0], 500);
+
+	for (unsigned int c = 0; c < channels; c++)
+	{
+		NoiseShaper single(FxpFormat(16, 6), FxpFormat(10, 0), h);
+		for (size_t f = 0; f < 500; f++)
+		{
+			BOOST_CHECK_EQUAL(single.process(Fxp(x[f * channels + c], 16, 6)).val(),
+				y[f * channels + c]);
+		}
+	}
+}
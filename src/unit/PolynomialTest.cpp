@@ -0,0 +1,123 @@
+#include "boost_test.h"
+#include "Polynomial.h"
+#include <cmath>
+
+using namespace std;
+
+BOOST_AUTO_TEST_CASE( PolynomialEvaluate )
+{
+	/* 0.5 + 0.25 x - 0.125 x^2, all exactly representable */
+	vector<double> c;
+	c.push_back(0.5);
+	c.push_back(0.25);
+	c.push_back(-0.125);
+	FixedPointPolynomial p(c, FxpFormat(12, 8), FxpFormat(12, 10),
+		FxpFormat(24, 16), FxpFormat(16, 12));
+	BOOST_CHECK_EQUAL(p.order(), 2);
+
+	/* x = 2: 0.5 + 0.5 - 0.5 = 0.5 */
+	BOOST_CHECK_EQUAL(p.evaluate(Fxp(512, 12, 8)), Fxp(2048, 16, 12));
+
+	/* x = -1.5: 0.5 - 0.375 - 0.28125 = -0.15625 */
+	BOOST_CHECK_EQUAL(p.evaluate(Fxp(-384, 12, 8)), Fxp(-640, 16, 12));
+
+	/* Input format must match */
+	BOOST_CHECK_THROW(p.evaluate(Fxp(0, 12, 7)), runtime_error);
+
+	/* Batch and scalar evaluation agree, and stay close to the exact value
+	 * wherever it fits the output format */
+	vector<int64_t> x(3584), y(3584);
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)i - 1536;
+	}
+	p.evaluate(&x[0], &y[0], x.size());
+	for (size_t i = 0; i < x.size(); i += 37)
+	{
+		BOOST_CHECK_EQUAL(y[i], p.evaluate(Fxp(x[i], 12, 8)).val());
+		double v = x[i] / 256.0;
+		double exact = 0.5 + 0.25 * v - 0.125 * v * v;
+		BOOST_CHECK_SMALL(y[i] / 4096.0 - exact, 1.0 / 4096.0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( PolynomialOverflow )
+{
+	/* 4 x^2 overflows an 8 bit integer output for |x| > 5 */
+	vector<double> c(3, 0.0);
+	c[2] = 4.0;
+	FixedPointPolynomial sat(c, FxpFormat(8), FxpFormat(4), FxpFormat(20),
+		FxpFormat(8), ROUND_FLOOR, OVERFLOW_SATURATE);
+	FixedPointPolynomial wrap(c, FxpFormat(8), FxpFormat(4), FxpFormat(20),
+		FxpFormat(8), ROUND_FLOOR, OVERFLOW_WRAP);
+	BOOST_CHECK_EQUAL(sat.evaluate(Fxp(5, 8)).val(), 100);
+	BOOST_CHECK_EQUAL(sat.evaluate(Fxp(6, 8)).val(), 127);
+	BOOST_CHECK_EQUAL(wrap.evaluate(Fxp(6, 8)).val(), 144 - 256);
+
+	/* Accumulator plus input wider than the datapath */
+	BOOST_CHECK_THROW(FixedPointPolynomial(c, FxpFormat(32), FxpFormat(4),
+		FxpFormat(32), FxpFormat(8)), range_error);
+
+	/* Coefficient does not fit the accumulator */
+	BOOST_CHECK_THROW(FixedPointPolynomial(c, FxpFormat(8), FxpFormat(4),
+		FxpFormat(3), FxpFormat(8)), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( PiecewisePolynomialSegments )
+{
+	/* Constant per segment picks out the MSBs of the input */
+	vector<vector<double> > segments(4, vector<double>(1));
+	for (size_t s = 0; s < 4; s++)
+	{
+		segments[s][0] = (double)s;
+	}
+	PiecewisePolynomial p(segments, 2, FxpFormat(8, 4), FxpFormat(4),
+		FxpFormat(8), FxpFormat(8));
+	BOOST_CHECK_EQUAL(p.evaluate(Fxp(-128, 8, 4)).val(), 0);
+	BOOST_CHECK_EQUAL(p.evaluate(Fxp(-1, 8, 4)).val(), 1);
+	BOOST_CHECK_EQUAL(p.evaluate(Fxp(0, 8, 4)).val(), 2);
+	BOOST_CHECK_EQUAL(p.evaluate(Fxp(127, 8, 4)).val(), 3);
+
+	/* Linear in t reproduces the local offset */
+	for (size_t s = 0; s < 4; s++)
+	{
+		segments[s].assign(2, 0.0);
+		segments[s][1] = 1.0;
+	}
+	PiecewisePolynomial q(segments, 2, FxpFormat(8, 4), FxpFormat(8, 6),
+		FxpFormat(16, 6), FxpFormat(8, 6));
+	BOOST_CHECK_EQUAL(q.evaluate(Fxp(-128 + 16, 8, 4)).val(), 16);
+	BOOST_CHECK_EQUAL(q.evaluate(Fxp(63, 8, 4)).val(), 63);
+
+	/* Segment count must match */
+	segments.pop_back();
+	BOOST_CHECK_THROW(PiecewisePolynomial(segments, 2, FxpFormat(8, 4),
+		FxpFormat(8, 6), FxpFormat(16, 6), FxpFormat(8, 6)), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE( PiecewisePolynomialFit )
+{
+	/* sin(x) over [-4, 4) with 16 cubic segments */
+	FxpFormat in(16, 13);
+	vector<vector<double> > segments = PiecewisePolynomial::fit(
+		[](double x) { return sin(x); }, in, 4, 3);
+	BOOST_REQUIRE_EQUAL(segments.size(), 16);
+	PiecewisePolynomial p(segments, 4, in, FxpFormat(18, 15),
+		FxpFormat(32, 20), FxpFormat(16, 14));
+
+	vector<int64_t> x(1 << 16), y(1 << 16);
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		x[i] = (int64_t)i - 32768;
+	}
+	p.evaluate(&x[0], &y[0], x.size());
+
+	double maxError = 0.0;
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		double err = fabs(y[i] / 16384.0 - sin(x[i] / 8192.0));
+		maxError = max(maxError, err);
+	}
+	BOOST_CHECK_SMALL(maxError, 1e-4);
+	BOOST_CHECK_EQUAL(y[1000], p.evaluate(Fxp(x[1000], 16, 13)).val());
+}
@@ -0,0 +1,144 @@
+#include "boost_test.h"
+#include "PolyphaseChannelizer.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+/* Hann windowed sinc lowpass with cutoff pi / M and unit DC gain */
+static vector<double> prototypeFilter(unsigned int numChannels,
+	unsigned int length)
+{
+	vector<double> h(length);
+	double sum = 0;
+	for (unsigned int n = 0; n < length; n++)
+	{
+		double t = n - (length - 1) / 2.0;
+		double sinc = (t == 0) ? 1.0 : sin(M_PI * t / numChannels)
+			/ (M_PI * t / numChannels);
+		h[n] = sinc * (0.5 - 0.5 * cos(2 * M_PI * (n + 1) / (length + 1)));
+		sum += h[n];
+	}
+	for (unsigned int n = 0; n < length; n++)
+	{
+		h[n] /= sum;
+	}
+	return h;
+}
+
+static void checkAgainstReference(bool oversampled)
+{
+	unsigned int m = 8;
+	vector<double> h = prototypeFilter(m, 48);
+	FxpFormat coefFormat(18, 17);
+	PolyphaseChannelizer channelizer(m, h, oversampled, FxpFormat(16, 15),
+		coefFormat, FxpFormat(20, 17), FxpFormat(18, 16), FxpFormat(20, 17),
+		0);
+	size_t decimation = channelizer.decimation();
+	BOOST_CHECK_EQUAL(decimation, oversampled ? 4U : 8U);
+
+	size_t n = 400;
+	Xoshiro256 rng(3);
+	vector<complex<int64_t> > x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		x[i] = complex<int64_t>(rng.uniform(-(1 << 14), 1 << 14),
+			rng.uniform(-(1 << 14), 1 << 14));
+	}
+	ComplexMultichannelBuffer y(m, 0, FxpFormat(20, 17));
+	size_t frames = channelizer.process(&x[0], n, y);
+	BOOST_CHECK_EQUAL(frames, n / decimation);
+
+	/* y_k[m] from its definition, with the quantized prototype */
+	vector<double> hq(h.size());
+	for (size_t i = 0; i < h.size(); i++)
+	{
+		hq[i] = floor(h[i] * pow(2.0, 17) + 0.5) / pow(2.0, 17);
+	}
+	double maxError = 0;
+	for (size_t f = 0; f < frames; f++)
+	{
+		long newest = (long)((f + 1) * decimation) - 1;
+		for (size_t k = 0; k < m; k++)
+		{
+			complex<double> sum = 0;
+			for (size_t i = 0; i < hq.size() && (long)i <= newest; i++)
+			{
+				complex<double> v(x[newest - i].real(), x[newest - i].imag());
+				sum += hq[i] * v * polar(1.0, 2 * M_PI * k * i / m);
+			}
+			sum *= polar(1.0, -2 * M_PI * k * f * decimation / m);
+			/* input LSB 2^-15, output LSB 2^-17 */
+			sum *= 4.0;
+			CFxp actual = y.get(f, k);
+			maxError = max(maxError, abs(sum - complex<double>(actual.real(),
+				actual.imag())));
+		}
+	}
+	BOOST_CHECK(maxError < 8.0);
+}
+
+BOOST_AUTO_TEST_CASE( PolyphaseChannelizerCriticallySampled )
+{
+	checkAgainstReference(false);
+}
+
+BOOST_AUTO_TEST_CASE( PolyphaseChannelizerOversampled )
+{
+	checkAgainstReference(true);
+}
+
+BOOST_AUTO_TEST_CASE( PolyphaseChannelizerSeparatesTones )
+{
+	unsigned int m = 16;
+	vector<double> h = prototypeFilter(m, 128);
+	PolyphaseChannelizer channelizer(m, h, true, FxpFormat(16, 15),
+		FxpFormat(18, 17), FxpFormat(18, 15), FxpFormat(16, 15),
+		FxpFormat(16, 15), 0x0);
+
+	/* A tone at the centre of channel 5 */
+	size_t n = 2048;
+	vector<complex<int64_t> > x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		complex<double> v = polar(16000.0, 2 * M_PI * 5 * i / m);
+		x[i] = complex<int64_t>((int64_t)floor(v.real() + 0.5),
+			(int64_t)floor(v.imag() + 0.5));
+	}
+
+	/* Block boundaries do not change the output */
+	ComplexMultichannelBuffer whole(m, 0, FxpFormat(16, 15));
+	ComplexMultichannelBuffer pieces(m, 0, FxpFormat(16, 15));
+	channelizer.process(&x[0], n, whole);
+	channelizer.reset();
+	for (size_t i = 0; i < n; i += 37)
+	{
+		channelizer.process(&x[i], min((size_t)37, n - i), pieces);
+	}
+	BOOST_CHECK_EQUAL(pieces.numFrames(), whole.numFrames());
+	for (size_t i = 0; i < whole.numFrames() * m; i++)
+	{
+		BOOST_CHECK_EQUAL(pieces.real().data()[i], whole.real().data()[i]);
+		BOOST_CHECK_EQUAL(pieces.imag().data()[i], whole.imag().data()[i]);
+	}
+
+	/* After the filter settles, channel 5 holds the tone at baseband */
+	for (size_t f = 40; f < whole.numFrames(); f++)
+	{
+		for (size_t k = 0; k < m; k++)
+		{
+			double power = norm(whole.get(f, k).toDouble());
+			if (k == 5)
+			{
+				BOOST_CHECK(power > 0.2);
+			}
+			else
+			{
+				BOOST_CHECK(power < 1e-4);
+			}
+		}
+	}
+
+	ComplexMultichannelBuffer wrong(m, 0, FxpFormat(16, 14));
+	BOOST_CHECK_THROW(channelizer.process(&x[0], 1, wrong), runtime_error);
+}
@@ -0,0 +1,257 @@
+#include "boost_test.h"
+#include "SlidingWindow.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+static MultichannelBuffer randomBuffer(unsigned int channels, size_t frames,
+	FixedPointFormat format, uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	MultichannelBuffer buffer(channels, frames, format);
+	for (size_t i = 0; i < channels * frames; i++)
+	{
+		buffer.data()[i] = rng.uniform(format.minVal(), format.maxVal());
+	}
+	return buffer;
+}
+
+/* Frames [first, first + count) of a buffer */
+static MultichannelBuffer slice(const MultichannelBuffer &in, size_t first,
+	size_t count)
+{
+	MultichannelBuffer out(in.numChannels(), count, in.format());
+	for (size_t f = 0; f < count; f++)
+	{
+		for (unsigned int c = 0; c < in.numChannels(); c++)
+		{
+			out.frame(f)[c] = in.frame(first + f)[c];
+		}
+	}
+	return out;
+}
+
+/* x[f - k] for channel c, zero before the start */
+static int64_t past(const MultichannelBuffer &x, size_t f, size_t k,
+	unsigned int c)
+{
+	return (k > f) ? 0 : x.frame(f - k)[c];
+}
+
+BOOST_AUTO_TEST_CASE( MovingSumMatchesBruteForce )
+{
+	const unsigned int channels = 5;
+	const size_t length = 37;
+	FixedPointFormat inFormat(16, 15);
+	BOOST_CHECK(MovingSum::accumulatorFormat(inFormat, length)
+		== FixedPointFormat(22, 15));
+
+	MultichannelBuffer x = randomBuffer(channels, 300, inFormat, 1);
+	MovingSum exact(length, channels, inFormat, FixedPointFormat(22, 15));
+	MovingSum rounded(length, channels, inFormat, FixedPointFormat(12, 7),
+		ROUND_HALF_EVEN);
+	MultichannelBuffer y(channels, 0, FixedPointFormat(22, 15));
+	MultichannelBuffer r(channels, 0, FixedPointFormat(12, 7));
+
+	/* Blocks of uneven length, some longer than the window */
+	size_t blocks[5] = { 1, 36, 90, 0, 173 };
+	size_t first = 0;
+	for (int b = 0; b < 5; b++)
+	{
+		MultichannelBuffer in = slice(x, first, blocks[b]);
+		exact.process(in, y);
+		rounded.process(in, r, MultichannelEngine(2, 3));
+		BOOST_CHECK_EQUAL(y.numFrames(), blocks[b]);
+		for (size_t f = 0; f < blocks[b]; f++)
+		{
+			for (unsigned int c = 0; c < channels; c++)
+			{
+				int64_t sum = 0;
+				for (size_t k = 0; k < length; k++)
+				{
+					sum += past(x, first + f, k, c);
+				}
+				BOOST_CHECK_EQUAL(y.frame(f)[c], sum);
+				BOOST_CHECK_EQUAL(r.frame(f)[c], resizeValue(sum, 15,
+					FixedPointFormat(12, 7), ROUND_HALF_EVEN, OVERFLOW_SATURATE));
+			}
+		}
+		first += blocks[b];
+	}
+
+	exact.reset();
+	exact.process(slice(x, 0, 1), y);
+	BOOST_CHECK_EQUAL(y.frame(0)[4], x.frame(0)[4]);
+
+	MultichannelBuffer wrong(channels, 1, FixedPointFormat(16, 14));
+	BOOST_CHECK_THROW(exact.process(wrong, y), runtime_error);
+	MultichannelBuffer fewer(channels - 1, 1, inFormat);
+	BOOST_CHECK_THROW(exact.process(fewer, y), runtime_error);
+	BOOST_CHECK_THROW(MovingSum(0, 1, inFormat, inFormat), range_error);
+	BOOST_CHECK_THROW(MovingSum(1 << 20, 1, FixedPointFormat(48), inFormat),
+		range_error);
+}
+
+BOOST_AUTO_TEST_CASE( MovingPowerAndRms )
+{
+	const unsigned int channels = 3;
+	const size_t length = 20;
+	FixedPointFormat inFormat(12, 11);
+	FixedPointFormat powerFormat = MovingSum::accumulatorFormat(
+		MovingPower::squareFormat(inFormat, true), length);
+	BOOST_CHECK(powerFormat == FixedPointFormat(30, 22));
+
+	ComplexMultichannelBuffer x(channels, 100, inFormat);
+	x.real() = randomBuffer(channels, 100, inFormat, 2);
+	x.imag() = randomBuffer(channels, 100, inFormat, 3);
+
+	MovingPower power(length, channels, inFormat, true, powerFormat);
+	BOOST_CHECK(power.accumulatorFormat() == powerFormat);
+	MovingRms rms(length, channels, inFormat, true, FixedPointFormat(16, 15));
+	MultichannelBuffer p(channels, 0, powerFormat);
+	MultichannelBuffer r(channels, 0, FixedPointFormat(16, 15));
+	power.process(x, p);
+	rms.process(x, r, MultichannelEngine(1, 1));
+
+	for (size_t f = 0; f < 100; f++)
+	{
+		for (unsigned int c = 0; c < channels; c++)
+		{
+			int64_t sum = 0;
+			for (size_t k = 0; k < length && k <= f; k++)
+			{
+				int64_t re = x.real().frame(f - k)[c];
+				int64_t im = x.imag().frame(f - k)[c];
+				sum += re * re + im * im;
+			}
+			BOOST_CHECK_EQUAL(p.frame(f)[c], sum);
+
+			/* Rounded down, with 4 more fractional bits than the input */
+			double expected = sqrt((double)sum / length) * 16;
+			BOOST_CHECK(r.frame(f)[c] <= expected + 1e-9);
+			BOOST_CHECK(r.frame(f)[c] > expected - 1);
+		}
+	}
+
+	/* A constant input has that RMS exactly */
+	MovingRms realRms(8, 1, inFormat, false, inFormat);
+	MultichannelBuffer dc(1, 16, inFormat);
+	for (size_t f = 0; f < 16; f++)
+	{
+		dc.frame(f)[0] = -1000;
+	}
+	MultichannelBuffer y(1, 0, inFormat);
+	realRms.process(dc, y);
+	BOOST_CHECK_EQUAL(y.frame(3)[0], 707);
+	BOOST_CHECK_EQUAL(y.frame(15)[0], 1000);
+
+	BOOST_CHECK_THROW(realRms.process(x, y), runtime_error);
+	BOOST_CHECK_THROW(power.process(dc, p), runtime_error);
+	BOOST_CHECK_THROW(MovingRms(8, 1, inFormat, false,
+		FixedPointFormat(48, 44)), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( SlidingPeakModes )
+{
+	const unsigned int channels = 4;
+	const size_t length = 9;
+	FixedPointFormat format(8, 4);
+	MultichannelBuffer x = randomBuffer(channels, 200, format, 4);
+	/* Runs of the extreme values */
+	for (size_t f = 50; f < 70; f++)
+	{
+		x.frame(f)[1] = format.minVal();
+		x.frame(f)[2] = format.maxVal();
+	}
+
+	PeakMode modes[3] = { PEAK_MAX, PEAK_MIN, PEAK_ABS };
+	for (int m = 0; m < 3; m++)
+	{
+		SlidingPeak peak(length, channels, format, modes[m]);
+		MultichannelBuffer y(channels, 0, format);
+		MultichannelBuffer first(channels, 0, format);
+		peak.process(slice(x, 0, 13), first, MultichannelEngine(2, 1));
+		peak.process(slice(x, 13, 187), y);
+
+		for (size_t f = 0; f < 200; f++)
+		{
+			for (unsigned int c = 0; c < channels; c++)
+			{
+				int64_t expected = (modes[m] == PEAK_ABS) ? 0 : past(x, f, 0, c);
+				for (size_t k = 0; k < length; k++)
+				{
+					int64_t v = past(x, f, k, c);
+					switch (modes[m])
+					{
+					case PEAK_MAX: expected = max(expected, v); break;
+					case PEAK_MIN: expected = min(expected, v); break;
+					default: expected = max(expected, min(abs(v), format.maxVal()));
+					}
+				}
+				int64_t actual = (f < 13) ? first.frame(f)[c]
+					: y.frame(f - 13)[c];
+				BOOST_CHECK_EQUAL(actual, expected);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( ExponentialAverageStep )
+{
+	const unsigned int shift = 4;
+	FixedPointFormat inFormat(10, 9);
+	FixedPointFormat outFormat(14, 13);
+	ExponentialAverage average(shift, 2, inFormat, outFormat);
+	BOOST_CHECK(average.accumulatorFormat() == FixedPointFormat(15, 13));
+
+	MultichannelBuffer x(2, 300, inFormat);
+	for (size_t f = 0; f < 300; f++)
+	{
+		x.frame(f)[0] = 400;
+		x.frame(f)[1] = (f < 150) ? inFormat.minVal() : inFormat.maxVal();
+	}
+	MultichannelBuffer y(2, 0, outFormat);
+	average.process(x, y, MultichannelEngine(1, 1));
+
+	/* Reference recursion in the accumulator's LSBs */
+	int64_t acc = 0;
+	for (size_t f = 0; f < 300; f++)
+	{
+		acc += 400 - roundShift(acc, shift, ROUND_HALF_UP);
+		BOOST_CHECK_EQUAL(y.frame(f)[0], acc);
+	}
+	/* Settles on the input, now with 4 more fractional bits */
+	BOOST_CHECK(abs(y.frame(299)[0] - (400 << shift)) <= 8);
+	BOOST_CHECK(abs(y.frame(149)[1] + (512 << shift)) <= 8);
+	BOOST_CHECK(abs(y.frame(299)[1] - (511 << shift)) <= 8);
+	BOOST_CHECK(y.frame(20)[0] > (200 << shift));
+
+	average.reset();
+	average.process(slice(x, 0, 1), y);
+	BOOST_CHECK_EQUAL(y.frame(0)[0], 400);
+	BOOST_CHECK_THROW(ExponentialAverage(40, 1, FixedPointFormat(32),
+		outFormat), range_error);
+}
+
+BOOST_AUTO_TEST_CASE( SlidingWindowIndependentOfEngine )
+{
+	const unsigned int channels = 11;
+	FixedPointFormat format(14, 10);
+	MultichannelBuffer x = randomBuffer(channels, 120, format, 5);
+
+	MovingSum sum1(16, channels, format, format);
+	MovingSum sum2(16, channels, format, format);
+	SlidingPeak peak1(7, channels, format, PEAK_ABS);
+	SlidingPeak peak2(7, channels, format, PEAK_ABS);
+	MultichannelBuffer a(channels, 0, format);
+	MultichannelBuffer b(channels, 0, format);
+	MultichannelBuffer c(channels, 0, format);
+	MultichannelBuffer d(channels, 0, format);
+	sum1.process(x, a, MultichannelEngine(1));
+	sum2.process(x, b, MultichannelEngine(3, 2));
+	peak1.process(x, c, MultichannelEngine(1));
+	peak2.process(x, d, MultichannelEngine(4, 1));
+	BOOST_CHECK(equal(a.data(), a.data() + 120 * channels, b.data()));
+	BOOST_CHECK(equal(c.data(), c.data() + 120 * channels, d.data()));
+}
@@ -0,0 +1,146 @@
+#include "boost_test.h"
+#include "TestVectorIO.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace std;
+
+static string tempPath(const char *name)
+{
+	stringstream path;
+	path << "/tmp/" << name << "_" << getpid() << ".txt";
+	return path.str();
+}
+
+static string readFile(const string &path)
+{
+	ifstream in(path.c_str());
+	stringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static void writeFile(const string &path, const string &contents)
+{
+	ofstream out(path.c_str());
+	out << contents;
+}
+
+BOOST_AUTO_TEST_CASE( TestVectorWriteFormats )
+{
+	string path = tempPath("TestVectorWriteFormats");
+
+	{
+		TestVectorWriter w(path, TV_HEX, 12);
+		w.write(Fxp(-1, 12, 4));
+		w.write(Fxp(0x123, 12));
+		w.write(CFxp(-2048, 2047, 12));
+	}
+	BOOST_CHECK_EQUAL(readFile(path), "fff\n123\n800 7ff\n");
+
+	{
+		TestVectorWriter w(path, TV_BINARY, 5);
+		w.write(-3);
+		w.write(4);
+	}
+	BOOST_CHECK_EQUAL(readFile(path), "11101\n00100\n");
+
+	{
+		TestVectorWriter w(path, TV_DECIMAL, 64);
+		w.write(INT64_MIN);
+		w.write(CFxp(17, -4, 8));
+	}
+	BOOST_CHECK_EQUAL(readFile(path), "-9223372036854775808\n17 -4\n");
+
+	/* Values that do not fit the declared width */
+	TestVectorWriter w(path, TV_HEX, 8);
+	BOOST_CHECK_THROW(w.write(128), range_error);
+	BOOST_CHECK_THROW(w.write(-129), range_error);
+
+	/* Invalid widths */
+	BOOST_CHECK_THROW(TestVectorWriter(path, TV_HEX, 0), range_error);
+	BOOST_CHECK_THROW(TestVectorWriter(path, TV_HEX, 65), range_error);
+
+	remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( TestVectorReadFormats )
+{
+	string path = tempPath("TestVectorReadFormats");
+
+	writeFile(path, "// header comment\nfff\n\n123 // trailing\r\n800 7ff\n");
+	vector<int64_t> raw = TestVectorReader(path, TV_HEX, 12).readRaw();
+	BOOST_REQUIRE_EQUAL(raw.size(), 4);
+	BOOST_CHECK_EQUAL(raw[0], -1);
+	BOOST_CHECK_EQUAL(raw[1], 0x123);
+	BOOST_CHECK_EQUAL(raw[2], -2048);
+	BOOST_CHECK_EQUAL(raw[3], 2047);
+
+	vector<CFxp> c = TestVectorReader(path, TV_HEX, 12).readComplexFixedPoint(3);
+	BOOST_REQUIRE_EQUAL(c.size(), 2);
+	BOOST_CHECK_EQUAL(c[1], CFxp(-2048, 2047, 12, 3));
+
+	writeFile(path, "11101\n00100\n");
+	vector<Fxp> f = TestVectorReader(path, TV_BINARY, 5).readFixedPoint(1);
+	BOOST_REQUIRE_EQUAL(f.size(), 2);
+	BOOST_CHECK_EQUAL(f[0], Fxp(-3, 5, 1));
+	BOOST_CHECK_EQUAL(f[1], Fxp(4, 5, 1));
+
+	writeFile(path, "-9223372036854775808\n9223372036854775807\n");
+	raw = TestVectorReader(path, TV_DECIMAL, 64).readRaw();
+	BOOST_REQUIRE_EQUAL(raw.size(), 2);
+	BOOST_CHECK_EQUAL(raw[0], INT64_MIN);
+	BOOST_CHECK_EQUAL(raw[1], INT64_MAX);
+
+	/* Empty file */
+	writeFile(path, "");
+	BOOST_CHECK_EQUAL(TestVectorReader(path, TV_HEX, 8).readRaw().size(), 0);
+
+	/* Values wider than the declared width */
+	writeFile(path, "1ff\n");
+	BOOST_CHECK_THROW(TestVectorReader(path, TV_HEX, 8).readRaw(), range_error);
+	writeFile(path, "128\n");
+	BOOST_CHECK_THROW(TestVectorReader(path, TV_DECIMAL, 8).readRaw(),
+		range_error);
+
+	/* Malformed values */
+	writeFile(path, "12g\n");
+	BOOST_CHECK_THROW(TestVectorReader(path, TV_HEX, 12).readRaw(),
+		runtime_error);
+	writeFile(path, "1\n2\n3\n");
+	BOOST_CHECK_THROW(
+		TestVectorReader(path, TV_DECIMAL, 8).readComplexFixedPoint(0),
+		runtime_error);
+
+	remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( TestVectorRoundTripParallel )
+{
+	string path = tempPath("TestVectorRoundTripParallel");
+	const TestVectorFormat formats[] = { TV_HEX, TV_BINARY, TV_DECIMAL };
+
+	/* Large enough to be split into several chunks */
+	vector<int64_t> values(200000);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		values[i] = (int64_t)((i * 2654435761ULL) % 65536) - 32768;
+	}
+
+	for (int f = 0; f < 3; f++)
+	{
+		{
+			TestVectorWriter w(path, formats[f], 16);
+			w.write(&values[0], values.size());
+		}
+		TestVectorReader r(path, formats[f], 16);
+		vector<int64_t> single = r.readRaw(1);
+		vector<int64_t> parallel = r.readRaw(7);
+		BOOST_CHECK(single == values);
+		BOOST_CHECK(parallel == values);
+	}
+
+	remove(path.c_str());
+}
@@ -0,0 +1,192 @@
+#include "boost_test.h"
+#include "ToneDetector.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+/* A quantized tone plus uniform noise, as raw values in format */
+static vector<int64_t> toneSignal(size_t n, double frequency, double amplitude,
+	FixedPointFormat format, uint64_t seed)
+{
+	Xoshiro256 rng(seed);
+	vector<int64_t> x(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		double v = amplitude * cos(2 * M_PI * frequency * i + 0.3)
+			+ 0.05 * (rng.uniformDouble() - 0.5);
+		x[i] = quantizeValue(v, format);
+	}
+	return x;
+}
+
+/* sum_m x[first + m] exp(-j w m) over length samples, in real units */
+static complex<double> dtft(const vector<complex<double> > &x, size_t first,
+	size_t length, double frequency)
+{
+	complex<double> sum(0.0, 0.0);
+	for (size_t m = 0; m < length; m++)
+	{
+		sum += x[first + m] * polar(1.0, -2 * M_PI * frequency * m);
+	}
+	return sum;
+}
+
+static complex<double> toDouble(complex<int64_t> v, FixedPointFormat format)
+{
+	double scale = powerOfTwo(format.fracBits());
+	return complex<double>(v.real() / scale, v.imag() / scale);
+}
+
+BOOST_AUTO_TEST_CASE( GoertzelMatchesDft )
+{
+	const size_t length = 64;
+	FixedPointFormat inFormat(16, 15);
+	FixedPointFormat outFormat(28, 17);
+	vector<double> frequencies;
+	size_t bins[5] = { 0, 3, 5, 10, 31 };
+	for (int k = 0; k < 5; k++)
+	{
+		frequencies.push_back((double)bins[k] / length);
+	}
+	GoertzelBank bank(frequencies, length, inFormat, FixedPointFormat(20, 17),
+		FixedPointFormat(32, 17), outFormat);
+	BOOST_CHECK_EQUAL(bank.numBins(), 5U);
+
+	/* Three blocks, fed in uneven pieces */
+	vector<int64_t> x = toneSignal(3 * length + 10, 5.0 / length, 0.5,
+		inFormat, 1);
+	vector<complex<int64_t> > out;
+	BOOST_CHECK_EQUAL(bank.process(x.data(), 50, out), 0U);
+	BOOST_CHECK_EQUAL(bank.process(x.data() + 50, 100, out), 2U);
+	BOOST_CHECK_EQUAL(bank.process(x.data() + 150, x.size() - 150, out), 1U);
+	BOOST_CHECK_EQUAL(out.size(), 3 * 5U);
+
+	vector<complex<double> > xd(x.size());
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		xd[i] = x[i] / powerOfTwo(15);
+	}
+	for (size_t r = 0; r < 3; r++)
+	{
+		for (int k = 0; k < 5; k++)
+		{
+			complex<double> expected = dtft(xd, r * length, length,
+				frequencies[k]);
+			BOOST_CHECK_SMALL(abs(toDouble(out[r * 5 + k], outFormat)
+				- expected), 0.01);
+		}
+		/* The tone's bin dominates */
+		BOOST_CHECK(abs(toDouble(out[r * 5 + 2], outFormat)) > 15.0);
+		BOOST_CHECK(abs(toDouble(out[r * 5 + 3], outFormat)) < 1.0);
+	}
+
+	/* Sample by sample with FixedPoint values */
+	bank.reset();
+	vector<CFxp> result;
+	for (size_t i = 0; i < length - 1; i++)
+	{
+		BOOST_CHECK(!bank.process(Fxp(x[i], 16, 15), result));
+	}
+	BOOST_CHECK(bank.process(Fxp(x[length - 1], 16, 15), result));
+	BOOST_CHECK_EQUAL(result.size(), 5U);
+	BOOST_CHECK(result[2] == CFxp(out[2], 28, 17));
+	BOOST_CHECK_THROW(bank.process(Fxp(0, 16, 14), result), runtime_error);
+
+	/* 2 cos(0) = 2 does not fit without two integer bits */
+	BOOST_CHECK_THROW(GoertzelBank(frequencies, length, inFormat,
+		FixedPointFormat(18, 17), FixedPointFormat(32, 17), outFormat),
+		range_error);
+}
+
+BOOST_AUTO_TEST_CASE( GoertzelComplexOffGrid )
+{
+	const size_t length = 100;
+	FixedPointFormat inFormat(14, 13);
+	FixedPointFormat outFormat(24, 14);
+	vector<double> frequencies(3);
+	frequencies[0] = 0.1234;
+	frequencies[1] = -0.2;
+	frequencies[2] = 0.31;
+
+	Xoshiro256 rng(2);
+	vector<complex<int64_t> > x(length);
+	vector<complex<double> > xd(length);
+	for (size_t i = 0; i < length; i++)
+	{
+		complex<double> v = 0.7 * polar(1.0, 2 * M_PI * 0.1234 * i);
+		x[i] = complex<int64_t>(quantizeValue(v.real(), inFormat),
+			quantizeValue(v.imag(), inFormat));
+		xd[i] = toDouble(x[i], inFormat);
+	}
+
+	GoertzelBank bank(frequencies, length, inFormat, FixedPointFormat(20, 17),
+		FixedPointFormat(30, 16), outFormat);
+	vector<complex<int64_t> > out;
+	BOOST_CHECK_EQUAL(bank.process(x.data(), length, out), 1U);
+	for (int k = 0; k < 3; k++)
+	{
+		double expected = abs(dtft(xd, 0, length, frequencies[k]));
+		BOOST_CHECK_SMALL(abs(toDouble(out[k], outFormat)) - expected, 0.02);
+	}
+	BOOST_CHECK(abs(toDouble(out[0], outFormat)) > 69.0);
+}
+
+BOOST_AUTO_TEST_CASE( SlidingDftTracksWindow )
+{
+	const size_t length = 32;
+	const double damping = 1 - 1.0 / 1024;
+	FixedPointFormat inFormat(16, 15);
+	FixedPointFormat outFormat(24, 16);
+	vector<size_t> bins(4);
+	bins[0] = 0;
+	bins[1] = 1;
+	bins[2] = 4;
+	bins[3] = 9;
+	SlidingDftBank bank(bins, length, inFormat, FixedPointFormat(28, 26),
+		FixedPointFormat(32, 24), outFormat, damping);
+
+	vector<int64_t> x = toneSignal(300, 4.0 / length, 0.6, inFormat, 3);
+	vector<complex<int64_t> > out;
+	bank.process(x.data(), 120, out);
+	bank.process(x.data() + 120, 180, out);
+	BOOST_CHECK_EQUAL(out.size(), 300 * 4U);
+
+	vector<complex<double> > xd(x.size() + length, 0.0);
+	for (size_t i = 0; i < x.size(); i++)
+	{
+		xd[i + length] = x[i] / powerOfTwo(15);
+	}
+	for (size_t n = 0; n < x.size(); n += 7)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			/* Damped DFT of the window ending at n */
+			double w = 2 * M_PI * bins[k] / length;
+			complex<double> expected(0.0, 0.0);
+			for (size_t m = 0; m < length; m++)
+			{
+				expected += xd[n + length - m] * pow(damping, (double)(m + 1))
+					* polar(1.0, w * (m + 1));
+			}
+			BOOST_CHECK_SMALL(abs(toDouble(out[n * 4 + k], outFormat)
+				- expected), 0.001);
+		}
+	}
+	BOOST_CHECK(abs(toDouble(out[299 * 4 + 2], outFormat)) > 9.0);
+
+	/* FixedPoint input gives the same bins */
+	bank.reset();
+	vector<CFxp> result;
+	for (size_t i = 0; i < 40; i++)
+	{
+		bank.process(Fxp(x[i], 16, 15), result);
+	}
+	BOOST_CHECK_EQUAL(result.size(), 4U);
+	BOOST_CHECK(result[3] == CFxp(out[39 * 4 + 3], 24, 16));
+
+	/* Undamped twiddles are not strictly inside the unit circle */
+	BOOST_CHECK_THROW(SlidingDftBank(bins, length, inFormat,
+		FixedPointFormat(28, 26), FixedPointFormat(32, 24), outFormat, 1.0),
+		range_error);
+}
@@ -0,0 +1,149 @@
+#include "boost_test.h"
+#include "TraceRecorder.h"
+#include "Parallel.h"
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
+
+using namespace std;
+
+static string tempPath(const char *name)
+{
+	stringstream path;
+	path << "/tmp/" << name << "_" << getpid() << ".trc";
+	return path.str();
+}
+
+BOOST_AUTO_TEST_CASE( TraceRoundTrip )
+{
+	string path = tempPath("TraceRoundTrip");
+	{
+		TraceRecorder recorder(path);
+		TraceSignal &x = recorder.addSignal("x", FxpFormat(16, 15));
+		TraceSignal &y = recorder.addSignal("y", FxpFormat(12, 4), true);
+		for (int n = 0; n < 10000; n++)
+		{
+			x.record(Fxp(n % 30000 - 15000, 16, 15));
+			y.record(CFxp(n % 2000, -(n % 2000), 12, 4));
+		}
+		BOOST_CHECK_EQUAL(x.numSamples(), 10000U);
+		BOOST_CHECK_THROW(x.record(Fxp(0, 16, 14)), runtime_error);
+		BOOST_CHECK_THROW(y.record(3), runtime_error);
+		BOOST_CHECK_THROW(recorder.addSignal("x", FxpFormat(8)),
+			runtime_error);
+	}
+
+	TraceReader reader(path);
+	BOOST_CHECK_EQUAL(reader.signals().size(), 2U);
+	const TraceSignalData *x = reader.find("x");
+	const TraceSignalData *y = reader.find("y");
+	BOOST_REQUIRE(x != NULL && y != NULL);
+	BOOST_CHECK(reader.find("z") == NULL);
+	BOOST_CHECK(x->format == FxpFormat(16, 15));
+	BOOST_CHECK(y->isComplex);
+	BOOST_CHECK_EQUAL(x->samples.size(), 10000U);
+	BOOST_CHECK_EQUAL(y->values.size(), 20000U);
+	BOOST_CHECK_EQUAL(x->samples[9999], 9999U);
+	BOOST_CHECK_EQUAL(x->values[1234], 1234 - 15000);
+	BOOST_CHECK_EQUAL(y->values[2 * 1999 + 1], -1999);
+	remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( TraceFilters )
+{
+	string path = tempPath("TraceFilters");
+	{
+		TraceRecorder recorder(path);
+		TraceSignal &s = recorder.addSignal("s", FxpFormat(32),
+			false, TraceFilter(100, 200, 7));
+		for (int64_t n = 0; n < 1000; n++)
+		{
+			s.record(n);
+		}
+		BOOST_CHECK_THROW(TraceFilter bad(0, 10, 0);
+			recorder.addSignal("bad", FxpFormat(8), false, bad), range_error);
+		recorder.close();
+
+		/* Nothing is dropped silently once the file is closed */
+		BOOST_CHECK_THROW(recorder.addSignal("late", FxpFormat(8)),
+			runtime_error);
+		BOOST_CHECK_THROW(s.record(1000), runtime_error);
+		BOOST_CHECK_EQUAL(s.numSamples(), 1000U);
+	}
+
+	TraceReader reader(path);
+	const TraceSignalData &s = reader.signals()[0];
+	BOOST_CHECK_EQUAL(s.samples.size(), 15U);
+	for (size_t k = 0; k < s.samples.size(); k++)
+	{
+		BOOST_CHECK_EQUAL(s.samples[k], 100 + 7 * k);
+		BOOST_CHECK_EQUAL(s.values[k], (int64_t)(100 + 7 * k));
+	}
+	remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( TraceDiff )
+{
+	string expectedPath = tempPath("TraceDiffExpected");
+	string actualPath = tempPath("TraceDiffActual");
+
+	/* Four signals recorded from four threads; the actual trace keeps every
+	 * other sample of "b" and differs in "c" at 7000 and "d" at 9000 */
+	for (int t = 0; t < 2; t++)
+	{
+		TraceRecorder recorder(t ? actualPath : expectedPath);
+		vector<TraceSignal *> signals;
+		const char *names[4] = { "a", "b", "c", "d" };
+		for (int i = 0; i < 4; i++)
+		{
+			TraceFilter filter = (t && i == 1) ? TraceFilter(0, UINT64_MAX, 2)
+				: TraceFilter();
+			signals.push_back(&recorder.addSignal(names[i], FxpFormat(24, 8),
+				false, filter));
+		}
+		parallelFor(0, 4, [&](size_t begin, size_t end, unsigned int)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				for (int64_t n = 0; n < 20000; n++)
+				{
+					bool wrong = t && ((i == 2 && n == 7000)
+						|| (i == 3 && n == 9000));
+					signals[i]->record(n * (int64_t)(i + 1) + wrong);
+				}
+			}
+		}, 4);
+	}
+
+	TraceReader expected(expectedPath);
+	TraceReader actual(actualPath);
+	TraceMismatch m = compareTraces(expected, actual);
+	BOOST_CHECK(m.found);
+	BOOST_CHECK_EQUAL(m.signal, "c");
+	BOOST_CHECK_EQUAL(m.sample, 7000U);
+	BOOST_CHECK(m.description.find("21000") != string::npos);
+	BOOST_CHECK(m.description.find("21001") != string::npos);
+
+	/* A trace matches itself; a missing signal is found at sample 0 */
+	TraceMismatch same = compareTraces(expected, expected, 1);
+	BOOST_CHECK(!same.found);
+	BOOST_CHECK_EQUAL(same.numCompared, 80000U);
+
+	string partialPath = tempPath("TraceDiffPartial");
+	{
+		TraceRecorder recorder(partialPath);
+		recorder.addSignal("a", FxpFormat(24, 8)).record(0);
+		recorder.addSignal("b", FxpFormat(24, 7)).record(0);
+	}
+	TraceReader partial(partialPath);
+	m = compareTraces(expected, partial);
+	BOOST_CHECK(m.found);
+	BOOST_CHECK_EQUAL(m.signal, "b");
+	BOOST_CHECK_EQUAL(m.sample, 0U);
+
+	BOOST_CHECK_THROW(TraceReader missing("/nonexistent/trace.trc"),
+		runtime_error);
+	remove(expectedPath.c_str());
+	remove(actualPath.c_str());
+	remove(partialPath.c_str());
+}
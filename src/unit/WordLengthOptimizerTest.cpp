@@ -0,0 +1,131 @@
+#include "boost_test.h"
+#include "WordLengthOptimizer.h"
+#include <cmath>
+
+using namespace std;
+
+static Fxp toFormat(const Fxp &value, FixedPointFormat format)
+{
+	Fxp v(value.val(), value.width(), value.fracBits());
+	if (v.fracBits() < format.fracBits())
+	{
+		return Fxp::quantize(v.toDouble(), format.width(), format.fracBits());
+	}
+	v.roundBy(v.fracBits() - format.fracBits());
+	if (v.width() > format.width())
+	{
+		v.saturateTo(format.width());
+	}
+	else
+	{
+		v.signExtendTo(format.width());
+	}
+	return Fxp(v.val(), v.width(), v.fracBits());
+}
+
+/* y[n] = c x[n] + c x[n-1] with a quantized coefficient, product and sum */
+static vector<double> model(const vector<FixedPointFormat> &formats,
+	const vector<Fxp> &stimulus)
+{
+	Fxp c = Fxp::quantize(0.70710678, formats[0].width(),
+		formats[0].fracBits());
+	vector<double> y;
+	Fxp previous(0, formats[1].width(), formats[1].fracBits());
+	for (size_t n = 0; n < stimulus.size(); n++)
+	{
+		Fxp product = toFormat(stimulus[n] * c, formats[1]);
+		y.push_back(toFormat(product + previous, formats[2]).toDouble());
+		previous = product;
+	}
+	return y;
+}
+
+static vector<double> stimulus(void)
+{
+	vector<double> x;
+	for (int n = 0; n < 2000; n++)
+	{
+		x.push_back(0.9 * sin(0.0123 * n * n) * cos(0.071 * n));
+	}
+	return x;
+}
+
+static vector<WordLengthSignal> signals(void)
+{
+	vector<WordLengthSignal> s;
+	s.push_back(WordLengthSignal("coef", 1, 2, 24, 2.0));
+	s.push_back(WordLengthSignal("product", 1, 2, 24));
+	s.push_back(WordLengthSignal("sum", 2, 2, 24));
+	return s;
+}
+
+BOOST_AUTO_TEST_CASE( WordLengthIntegerBits )
+{
+	BOOST_CHECK_EQUAL(WordLengthOptimizer::integerBitsFor(-1.0, 0.99), 1U);
+	BOOST_CHECK_EQUAL(WordLengthOptimizer::integerBitsFor(-1.0, 1.0), 2U);
+	BOOST_CHECK_EQUAL(WordLengthOptimizer::integerBitsFor(0.0, 3.5), 3U);
+	BOOST_CHECK_EQUAL(WordLengthOptimizer::integerBitsFor(-4.5, 0.0), 4U);
+}
+
+BOOST_AUTO_TEST_CASE( WordLengthOptimizerSqnr )
+{
+	WordLengthOptimizer optimizer(model, signals(), stimulus(),
+		FxpFormat(16, 15));
+	WordLengthResult result = optimizer.optimize(METRIC_SQNR_DB, 60.0);
+	BOOST_CHECK(result.metric >= 60.0);
+	BOOST_CHECK_EQUAL(result.formats.size(), 3U);
+
+	/* Locally minimal: dropping any further bit misses the target */
+	vector<unsigned int> fracBits;
+	for (size_t i = 0; i < result.formats.size(); i++)
+	{
+		fracBits.push_back(result.formats[i].fracBits());
+	}
+	BOOST_CHECK(optimizer.evaluate(fracBits, METRIC_SQNR_DB) >= 60.0);
+	for (size_t i = 0; i < fracBits.size(); i++)
+	{
+		vector<unsigned int> smaller(fracBits);
+		smaller[i]--;
+		BOOST_CHECK(optimizer.evaluate(smaller, METRIC_SQNR_DB) < 60.0);
+	}
+
+	/* Same answer on one thread; a tighter target costs more */
+	WordLengthOptimizer serial(model, signals(), stimulus(), FxpFormat(16, 15),
+		1);
+	WordLengthResult serialResult = serial.optimize(METRIC_SQNR_DB, 60.0);
+	for (size_t i = 0; i < fracBits.size(); i++)
+	{
+		BOOST_CHECK(serialResult.formats[i] == result.formats[i]);
+	}
+	BOOST_CHECK(serial.optimize(METRIC_SQNR_DB, 80.0).cost > result.cost);
+}
+
+BOOST_AUTO_TEST_CASE( WordLengthOptimizerMaxError )
+{
+	/* Against the exact response rather than the widest simulation */
+	vector<double> x = stimulus();
+	vector<double> reference;
+	for (size_t n = 0; n < x.size(); n++)
+	{
+		double xq = floor(x[n] * 32768 + 0.5) / 32768;
+		double previous = (n > 0) ? floor(x[n - 1] * 32768 + 0.5) / 32768 : 0;
+		reference.push_back(0.70710678 * (xq + previous));
+	}
+
+	WordLengthOptimizer optimizer(model, signals(), x, FxpFormat(16, 15));
+	optimizer.setReference(reference);
+	WordLengthResult result = optimizer.optimize(METRIC_MAX_ERROR, 1e-3);
+	BOOST_CHECK(result.metric <= 1e-3);
+	BOOST_CHECK(result.numSimulations > 0);
+
+	/* Roughly 10 fractional bits are needed everywhere for 1e-3 */
+	for (size_t i = 0; i < result.formats.size(); i++)
+	{
+		BOOST_CHECK(result.formats[i].fracBits() >= 8);
+		BOOST_CHECK(result.formats[i].fracBits() <= 14);
+	}
+
+	/* Even the widest formats miss this */
+	BOOST_CHECK_THROW(optimizer.optimize(METRIC_MAX_ERROR, 1e-12),
+		runtime_error);
+}
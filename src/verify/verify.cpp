@@ -0,0 +1,930 @@
+/* Bit-exactness verification of FixedPoint and ComplexFixedPoint.
+ *
+ * Every arithmetic operator and requantization method, including resize()
+ * and assign() in every rounding and overflow mode, is compared against an
+ * independent reference computed with __int128. Small formats are enumerated
+ * exhaustively (all formats, all operand values); wider formats up to
+ * MAX_WIDTH are covered by seeded random sweeps. Work is spread over all
+ * cores and throughput is reported per section. Exits non-zero on any
+ * mismatch. */
+#include "FixedPoint.h"
+#include "ComplexFixedPoint.h"
+#include "Parallel.h"
+#include "Random.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef __int128 int128;
+
+static const unsigned int MAX_REPORTED_FAILURES = 20;
+static const size_t RANDOM_CHUNK_SIZE = 1 << 16;
+
+struct Format
+{
+	unsigned int width;
+	unsigned int fracBits;
+};
+
+/* Outcome of one operation: either a range_error or a value and format */
+struct Result
+{
+	bool threw;
+	int128 re;
+	int128 im;
+	unsigned int width;
+	unsigned int fracBits;
+};
+
+struct Options
+{
+	unsigned int unaryWidth;
+	unsigned int formatWidth;
+	unsigned int pairWidth;
+	unsigned int complexWidth;
+	unsigned int resizeWidth;
+	unsigned long long randomSamples;
+	unsigned long long seed;
+	unsigned int threads;
+};
+
+static bool fits(int128 v, unsigned int width)
+{
+	int128 limit = (int128)1 << (width - 1);
+	return (v >= -limit) && (v < limit);
+}
+
+static Result thrown(void)
+{
+	Result r = { true, 0, 0, 0, 0 };
+	return r;
+}
+
+/* Reference result: throws exactly when the format or value is invalid */
+static Result value(int128 re, int128 im, unsigned int width,
+	unsigned int fracBits)
+{
+	if ((width == 0) || (width > (unsigned int)Fxp::MAX_WIDTH)
+		|| (fracBits > width) || !fits(re, width) || !fits(im, width))
+	{
+		return thrown();
+	}
+	Result r = { false, re, im, width, fracBits };
+	return r;
+}
+
+static Result of(const Fxp &x)
+{
+	Result r = { false, x.val(), 0, x.width(), x.fracBits() };
+	return r;
+}
+
+static Result of(const CFxp &x)
+{
+	Result r = { false, x.real(), x.imag(), x.width(), x.fracBits() };
+	return r;
+}
+
+template <typename Op>
+static Result run(Op op)
+{
+	try
+	{
+		return op();
+	}
+	catch (range_error &)
+	{
+		return thrown();
+	}
+}
+
+static bool same(const Result &a, const Result &b)
+{
+	if (a.threw || b.threw)
+	{
+		return a.threw == b.threw;
+	}
+	return a.re == b.re && a.im == b.im && a.width == b.width
+		&& a.fracBits == b.fracBits;
+}
+
+/* Decimal digits of the full 128-bit value */
+static string toString(int128 v)
+{
+	unsigned __int128 magnitude = (v < 0) ? -(unsigned __int128)v
+		: (unsigned __int128)v;
+	string digits;
+	do
+	{
+		digits.insert(digits.begin(), (char)('0' + (int)(magnitude % 10)));
+		magnitude /= 10;
+	} while (magnitude != 0);
+	return (v < 0) ? "-" + digits : digits;
+}
+
+static string describe(const Result &r)
+{
+	if (r.threw)
+	{
+		return "range_error";
+	}
+	stringstream s;
+	s << "(" << toString(r.re) << ", " << toString(r.im) << ") w=" << r.width
+		<< " f=" << r.fracBits;
+	return s.str();
+}
+
+static string describe(int64_t re, int64_t im, Format f)
+{
+	stringstream s;
+	s << "(" << re << ", " << im << ") w=" << f.width << " f=" << f.fracBits;
+	return s.str();
+}
+
+/* Reference operations, all on the (re, im) pair. Real values use im = 0. */
+
+static Result refAdd(int128 aRe, int128 aIm, Format a, int128 bRe, int128 bIm,
+	Format b)
+{
+	unsigned int fracBits = max(a.fracBits, b.fracBits);
+	unsigned int diff = max(a.fracBits, b.fracBits) - min(a.fracBits, b.fracBits);
+	unsigned int width = max(a.width, b.width) + 1 + diff;
+	if (width > (unsigned int)Fxp::MAX_WIDTH)
+	{
+		return thrown();
+	}
+	int128 sa = (int128)1 << (fracBits - a.fracBits);
+	int128 sb = (int128)1 << (fracBits - b.fracBits);
+	return value(aRe * sa + bRe * sb, aIm * sa + bIm * sb, width, fracBits);
+}
+
+static Result refMul(int128 a, Format fa, int128 b, Format fb)
+{
+	return value(a * b, 0, fa.width + fb.width, fa.fracBits + fb.fracBits);
+}
+
+static Result refComplexMul(int128 aRe, int128 aIm, Format a, int128 bRe,
+	int128 bIm, Format b)
+{
+	return value(aRe * bRe - aIm * bIm, aRe * bIm + aIm * bRe,
+		a.width + b.width + 1, a.fracBits + b.fracBits);
+}
+
+static Result refScalarMul(int128 aRe, int128 aIm, Format a, int128 b,
+	Format fb)
+{
+	return value(aRe * b, aIm * b, a.width + fb.width,
+		a.fracBits + fb.fracBits);
+}
+
+static unsigned int reducedFracBits(Format f, unsigned int n)
+{
+	return (f.fracBits > n) ? f.fracBits - n : 0;
+}
+
+static Result refTruncate(int128 re, int128 im, Format f, unsigned int n)
+{
+	if (n >= f.width)
+	{
+		return thrown();
+	}
+	return value(re >> n, im >> n, f.width - n, reducedFracBits(f, n));
+}
+
+/* Defined from the quotient and remainder, independently of the bias used
+ * by roundShift() */
+static int128 roundRef(int128 v, unsigned int n, RoundingMode mode)
+{
+	if (n == 0)
+	{
+		return v;
+	}
+	int128 q = v >> n;
+	int128 r = v - (q << n);
+	int128 half = (int128)1 << (n - 1);
+	switch (mode)
+	{
+	case ROUND_FLOOR: return q;
+	case ROUND_HALF_UP: return q + (r >= half);
+	case ROUND_HALF_EVEN: return q + (r > half || (r == half && (q & 1)));
+	case ROUND_HALF_AWAY: return q + ((v < 0) ? r > half : r >= half);
+	case ROUND_TOWARD_ZERO: return q + (v < 0 && r != 0);
+	case ROUND_CEIL: return q + (r != 0);
+	}
+	return q;
+}
+
+static Result refRound(int128 re, int128 im, Format f, unsigned int n,
+	RoundingMode mode = ROUND_HALF_UP)
+{
+	if (n >= f.width)
+	{
+		return thrown();
+	}
+	return value(roundRef(re, n, mode), roundRef(im, n, mode), f.width - n,
+		reducedFracBits(f, n));
+}
+
+/* Every rounding mode, named for failure reports */
+struct Rounding
+{
+	RoundingMode mode;
+	const char *name;
+	const char *realRoundBy;
+	const char *realRoundTo;
+	const char *complexRoundBy;
+};
+
+static const Rounding ROUNDINGS[] = {
+	{ ROUND_FLOOR, "FLOOR", "Fxp::roundBy(FLOOR)", "Fxp::roundTo(FLOOR)",
+		"CFxp::roundBy(FLOOR)" },
+	{ ROUND_HALF_UP, "HALF_UP", "Fxp::roundBy(HALF_UP)", "Fxp::roundTo(HALF_UP)",
+		"CFxp::roundBy(HALF_UP)" },
+	{ ROUND_HALF_EVEN, "HALF_EVEN", "Fxp::roundBy(HALF_EVEN)", "Fxp::roundTo(HALF_EVEN)",
+		"CFxp::roundBy(HALF_EVEN)" },
+	{ ROUND_HALF_AWAY, "HALF_AWAY", "Fxp::roundBy(HALF_AWAY)", "Fxp::roundTo(HALF_AWAY)",
+		"CFxp::roundBy(HALF_AWAY)" },
+	{ ROUND_TOWARD_ZERO, "TOWARD_ZERO", "Fxp::roundBy(TOWARD_ZERO)",
+		"Fxp::roundTo(TOWARD_ZERO)", "CFxp::roundBy(TOWARD_ZERO)" },
+	{ ROUND_CEIL, "CEIL", "Fxp::roundBy(CEIL)", "Fxp::roundTo(CEIL)",
+		"CFxp::roundBy(CEIL)" },
+};
+static const unsigned int NUM_ROUNDINGS =
+	sizeof(ROUNDINGS) / sizeof(ROUNDINGS[0]);
+
+static int128 clamp(int128 v, unsigned int width)
+{
+	int128 limit = (int128)1 << (width - 1);
+	return min(max(v, -limit), limit - 1);
+}
+
+static Result refSaturate(int128 re, int128 im, Format f, unsigned int n)
+{
+	if ((n == 0) || (n > f.width))
+	{
+		return thrown();
+	}
+	return value(clamp(re, n), clamp(im, n), n, f.fracBits);
+}
+
+/* Two's complement wrap to width bits */
+static int128 wrapRef(int128 v, unsigned int width)
+{
+	unsigned int shift = 128 - width;
+	return (int128)((unsigned __int128)v << shift) >> shift;
+}
+
+/* resize() and assign(): the exact value moved to t's binary point, rounded
+ * when LSBs are removed, then saturated or wrapped to t's width */
+static int128 resizeRef(int128 v, Format f, Format t, RoundingMode rounding,
+	OverflowMode overflow)
+{
+	int128 aligned = (t.fracBits >= f.fracBits)
+		? v * ((int128)1 << (t.fracBits - f.fracBits))
+		: roundRef(v, f.fracBits - t.fracBits, rounding);
+	return (overflow == OVERFLOW_SATURATE) ? clamp(aligned, t.width)
+		: wrapRef(aligned, t.width);
+}
+
+static Result refResize(int128 re, int128 im, Format f, Format t,
+	RoundingMode rounding, OverflowMode overflow)
+{
+	return value(resizeRef(re, f, t, rounding, overflow),
+		resizeRef(im, f, t, rounding, overflow), t.width, t.fracBits);
+}
+
+struct Overflow
+{
+	OverflowMode mode;
+	const char *name;
+};
+
+static const Overflow OVERFLOWS[] = {
+	{ OVERFLOW_WRAP, "WRAP" },
+	{ OVERFLOW_SATURATE, "SATURATE" },
+};
+static const unsigned int NUM_OVERFLOWS =
+	sizeof(OVERFLOWS) / sizeof(OVERFLOWS[0]);
+
+static Result refSignExtend(int128 re, int128 im, Format f, unsigned int n)
+{
+	if (n > Fxp::MAX_WIDTH - f.width)
+	{
+		return thrown();
+	}
+	return value(re, im, f.width + n, f.fracBits);
+}
+
+/* Collects failures from all worker threads */
+class Checker
+{
+public:
+
+	Checker(void) : m_failures(0) {}
+
+	template <typename Describe>
+	void expect(const char *op, const Result &expected, const Result &actual,
+		Describe describeOperands)
+	{
+		if (same(expected, actual))
+		{
+			return;
+		}
+		unsigned long long n = m_failures++;
+		if (n < MAX_REPORTED_FAILURES)
+		{
+			lock_guard<mutex> lock(m_mutex);
+			cout << "FAIL " << op << " " << describeOperands()
+				<< ": expected " << describe(expected)
+				<< ", got " << describe(actual) << endl;
+		}
+	}
+
+	unsigned long long failures(void) const { return m_failures; }
+
+private:
+
+	atomic<unsigned long long> m_failures;
+	mutex m_mutex;
+};
+
+/* All unary requantization methods of one real value, plus the out of range
+ * shift amounts when checkInvalid is set */
+static unsigned long long checkRealUnary(Checker &c, int64_t v, Format f,
+	bool checkInvalid)
+{
+	unsigned long long ops = 0;
+	auto operands = [&]() { return describe(v, 0, f); };
+	unsigned int maxN = checkInvalid ? f.width + 1 : f.width;
+
+	for (unsigned int n = 0; n <= maxN; n++)
+	{
+		if ((n < f.width) || checkInvalid)
+		{
+			c.expect("Fxp::truncateBy", refTruncate(v, 0, f, n),
+				run([&]() { return of(Fxp(v, f.width, f.fracBits).truncateBy(n)); }),
+				operands);
+			c.expect("Fxp::roundBy", refRound(v, 0, f, n),
+				run([&]() { return of(Fxp(v, f.width, f.fracBits).roundBy(n)); }),
+				operands);
+			for (unsigned int m = 0; m < NUM_ROUNDINGS; m++)
+			{
+				const Rounding &r = ROUNDINGS[m];
+				c.expect(r.realRoundBy, refRound(v, 0, f, n, r.mode),
+					run([&]() { return of(Fxp(v, f.width, f.fracBits).roundBy(n, r.mode)); }),
+					operands);
+			}
+			ops += 2 + NUM_ROUNDINGS;
+		}
+		if ((n >= 1 && n <= f.width) || checkInvalid)
+		{
+			c.expect("Fxp::saturateTo", refSaturate(v, 0, f, n),
+				run([&]() { return of(Fxp(v, f.width, f.fracBits).saturateTo(n)); }),
+				operands);
+			ops++;
+		}
+	}
+
+	unsigned int extensions[] = { 0, 1, Fxp::MAX_WIDTH - f.width,
+		Fxp::MAX_WIDTH - f.width + 1 };
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		unsigned int n = extensions[i];
+		if (f.width + n > (unsigned int)Fxp::MAX_WIDTH && !checkInvalid)
+		{
+			continue;
+		}
+		c.expect("Fxp::signExtendBy", refSignExtend(v, 0, f, n),
+			run([&]() { return of(Fxp(v, f.width, f.fracBits).signExtendBy(n)); }),
+			operands);
+		ops++;
+	}
+	return ops;
+}
+
+static unsigned long long checkComplexUnary(Checker &c, int64_t re, int64_t im,
+	Format f, unsigned int n)
+{
+	auto operands = [&]() { return describe(re, im, f); };
+	c.expect("CFxp::truncateBy", refTruncate(re, im, f, n),
+		run([&]() { return of(CFxp(re, im, f.width, f.fracBits).truncateBy(n)); }),
+		operands);
+	c.expect("CFxp::roundBy", refRound(re, im, f, n),
+		run([&]() { return of(CFxp(re, im, f.width, f.fracBits).roundBy(n)); }),
+		operands);
+	for (unsigned int m = 0; m < NUM_ROUNDINGS; m++)
+	{
+		const Rounding &r = ROUNDINGS[m];
+		c.expect(r.complexRoundBy, refRound(re, im, f, n, r.mode),
+			run([&]() { return of(CFxp(re, im, f.width, f.fracBits).roundBy(n, r.mode)); }),
+			operands);
+	}
+	c.expect("CFxp::saturateTo", refSaturate(re, im, f, n),
+		run([&]() { return of(CFxp(re, im, f.width, f.fracBits).saturateTo(n)); }),
+		operands);
+	c.expect("CFxp::signExtendBy", refSignExtend(re, im, f, n),
+		run([&]() { return of(CFxp(re, im, f.width, f.fracBits).signExtendBy(n)); }),
+		operands);
+	return 4 + NUM_ROUNDINGS;
+}
+
+/* resizeValue(), resize() and assign() of a real and a complex value from f
+ * to t, for every rounding and overflow mode */
+static unsigned long long checkResize(Checker &c, int64_t re, int64_t im,
+	Format f, Format t)
+{
+	FixedPointFormat to(t.width, t.fracBits);
+	for (unsigned int m = 0; m < NUM_ROUNDINGS; m++)
+	{
+		for (unsigned int o = 0; o < NUM_OVERFLOWS; o++)
+		{
+			RoundingMode rounding = ROUNDINGS[m].mode;
+			OverflowMode overflow = OVERFLOWS[o].mode;
+			auto operands = [&]() { return describe(re, im, f) + " to w="
+				+ to_string(t.width) + " f=" + to_string(t.fracBits) + " "
+				+ ROUNDINGS[m].name + " " + OVERFLOWS[o].name; };
+			Result real = refResize(re, 0, f, t, rounding, overflow);
+			Result complex = refResize(re, im, f, t, rounding, overflow);
+
+			Result raw = { false, resizeValue(re, f.fracBits, to, rounding,
+				overflow), 0, t.width, t.fracBits };
+			c.expect("resizeValue", real, raw, operands);
+			c.expect("Fxp::resize", real,
+				run([&]() { return of(Fxp(re, f.width, f.fracBits).resize(to, rounding, overflow)); }),
+				operands);
+			c.expect("Fxp::assign", real,
+				run([&]() { return of(Fxp(0, t.width, t.fracBits).assign(Fxp(re, f.width, f.fracBits), rounding, overflow)); }),
+				operands);
+			c.expect("CFxp::resize", complex,
+				run([&]() { return of(CFxp(re, im, f.width, f.fracBits).resize(to, rounding, overflow)); }),
+				operands);
+			c.expect("CFxp::assign", complex,
+				run([&]() { return of(CFxp(0, 0, t.width, t.fracBits).assign(CFxp(re, im, f.width, f.fracBits), rounding, overflow)); }),
+				operands);
+		}
+	}
+	return 5 * NUM_ROUNDINGS * NUM_OVERFLOWS;
+}
+
+static unsigned long long checkRealBinary(Checker &c, int64_t a, Format fa,
+	int64_t b, Format fb)
+{
+	auto operands = [&]() { return describe(a, 0, fa) + " and " + describe(b, 0, fb); };
+	c.expect("Fxp::operator+", refAdd(a, 0, fa, b, 0, fb),
+		run([&]() { return of(Fxp(a, fa.width, fa.fracBits)
+			+ Fxp(b, fb.width, fb.fracBits)); }),
+		operands);
+	c.expect("Fxp::operator*", refMul(a, fa, b, fb),
+		run([&]() { return of(Fxp(a, fa.width, fa.fracBits)
+			* Fxp(b, fb.width, fb.fracBits)); }),
+		operands);
+	return 2;
+}
+
+static unsigned long long checkComplexBinary(Checker &c, int64_t aRe,
+	int64_t aIm, Format fa, int64_t bRe, int64_t bIm, Format fb)
+{
+	auto operands = [&]() { return describe(aRe, aIm, fa) + " and " + describe(bRe, bIm, fb); };
+	c.expect("CFxp::operator+", refAdd(aRe, aIm, fa, bRe, bIm, fb),
+		run([&]() { return of(CFxp(aRe, aIm, fa.width, fa.fracBits)
+			+ CFxp(bRe, bIm, fb.width, fb.fracBits)); }),
+		operands);
+	c.expect("CFxp::operator*", refComplexMul(aRe, aIm, fa, bRe, bIm, fb),
+		run([&]() { return of(CFxp(aRe, aIm, fa.width, fa.fracBits)
+			* CFxp(bRe, bIm, fb.width, fb.fracBits)); }),
+		operands);
+	c.expect("CFxp::operator*(Fxp)", refScalarMul(aRe, aIm, fa, bRe, fb),
+		run([&]() { return of(CFxp(aRe, aIm, fa.width, fa.fracBits)
+			* Fxp(bRe, fb.width, fb.fracBits)); }),
+		operands);
+	c.expect("Fxp::operator*(CFxp)", refScalarMul(aRe, aIm, fa, bRe, fb),
+		run([&]() { return of(Fxp(bRe, fb.width, fb.fracBits)
+			* CFxp(aRe, aIm, fa.width, fa.fracBits)); }),
+		operands);
+	return 4;
+}
+
+static int64_t minOf(unsigned int width)
+{
+	return (width == 64) ? INT64_MIN : -(1LL << (width - 1));
+}
+
+static int64_t maxOf(unsigned int width)
+{
+	return (width == 64) ? INT64_MAX : (1LL << (width - 1)) - 1;
+}
+
+static vector<Format> allFormats(unsigned int maxWidth)
+{
+	vector<Format> formats;
+	for (unsigned int w = 1; w <= maxWidth; w++)
+	{
+		for (unsigned int f = 0; f <= w; f++)
+		{
+			Format format = { w, f };
+			formats.push_back(format);
+		}
+	}
+	return formats;
+}
+
+/* Runs one section and prints its throughput */
+template <typename Body>
+static void section(const string &name, Checker &c, Body body)
+{
+	unsigned long long failuresBefore = c.failures();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	unsigned long long ops = body();
+	double seconds = chrono::duration<double>(
+		chrono::steady_clock::now() - start).count();
+	cout << left << setw(44) << name << right << setw(14) << ops << " ops "
+		<< fixed << setprecision(2) << setw(8) << seconds << " s "
+		<< setw(8) << (ops / seconds / 1e6) << " Mops/s "
+		<< (c.failures() - failuresBefore) << " failures" << endl;
+}
+
+static unsigned long long exhaustiveUnary(Checker &c, const Options &o)
+{
+	atomic<unsigned long long> ops(0);
+	for (unsigned int w = 1; w <= o.unaryWidth; w++)
+	{
+		unsigned int fracs[] = { 0, w / 2, w };
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			if (i > 0 && fracs[i] == fracs[i - 1])
+			{
+				continue;
+			}
+			Format f = { w, fracs[i] };
+			int64_t lo = minOf(w);
+			parallelFor(0, 1ULL << w, [&](size_t begin, size_t end, unsigned int)
+			{
+				unsigned long long local = 0;
+				for (size_t k = begin; k < end; k++)
+				{
+					int64_t v = lo + (int64_t)k;
+					bool extreme = (v == lo) || (v == 0) || (v == maxOf(w));
+					local += checkRealUnary(c, v, f, extreme);
+				}
+				ops += local;
+			}, o.threads);
+		}
+	}
+	return ops;
+}
+
+static unsigned long long exhaustiveFormats(Checker &c, const Options &o)
+{
+	vector<Format> formats = allFormats(o.formatWidth);
+	atomic<unsigned long long> ops(0);
+	parallelFor(0, formats.size(), [&](size_t begin, size_t end, unsigned int)
+	{
+		unsigned long long local = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			Format fa = formats[i];
+			for (size_t j = 0; j < formats.size(); j++)
+			{
+				Format fb = formats[j];
+				for (int64_t a = minOf(fa.width); a <= maxOf(fa.width); a++)
+				{
+					for (int64_t b = minOf(fb.width); b <= maxOf(fb.width); b++)
+					{
+						local += checkRealBinary(c, a, fa, b, fb);
+					}
+				}
+			}
+		}
+		ops += local;
+	}, o.threads);
+	return ops;
+}
+
+static unsigned long long exhaustivePairs(Checker &c, const Options &o)
+{
+	unsigned int w = o.pairWidth;
+	Format formats[][2] = {
+		{ { w, 0 }, { w, 0 } },
+		{ { w, 0 }, { w, w / 2 } },
+		{ { w, w }, { w, 1 } },
+	};
+	atomic<unsigned long long> ops(0);
+	for (unsigned int p = 0; p < 3; p++)
+	{
+		Format fa = formats[p][0];
+		Format fb = formats[p][1];
+		parallelFor(0, 1ULL << w, [&](size_t begin, size_t end, unsigned int)
+		{
+			unsigned long long local = 0;
+			for (size_t k = begin; k < end; k++)
+			{
+				int64_t a = minOf(w) + (int64_t)k;
+				for (int64_t b = minOf(w); b <= maxOf(w); b++)
+				{
+					local += checkRealBinary(c, a, fa, b, fb);
+				}
+			}
+			ops += local;
+		}, o.threads);
+	}
+	return ops;
+}
+
+static unsigned long long exhaustiveComplex(Checker &c, const Options &o)
+{
+	vector<Format> formats = allFormats(o.complexWidth);
+	atomic<unsigned long long> ops(0);
+	parallelFor(0, formats.size(), [&](size_t begin, size_t end, unsigned int)
+	{
+		unsigned long long local = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			Format fa = formats[i];
+			int64_t lo = minOf(fa.width);
+			int64_t hi = maxOf(fa.width);
+			for (int64_t aRe = lo; aRe <= hi; aRe++)
+			for (int64_t aIm = lo; aIm <= hi; aIm++)
+			{
+				for (unsigned int n = 0; n <= fa.width + 1; n++)
+				{
+					local += checkComplexUnary(c, aRe, aIm, fa, n);
+				}
+				for (size_t j = 0; j < formats.size(); j++)
+				{
+					Format fb = formats[j];
+					for (int64_t bRe = minOf(fb.width); bRe <= maxOf(fb.width); bRe++)
+					for (int64_t bIm = minOf(fb.width); bIm <= maxOf(fb.width); bIm++)
+					{
+						local += checkComplexBinary(c, aRe, aIm, fa, bRe, bIm, fb);
+					}
+				}
+			}
+		}
+		ops += local;
+	}, o.threads);
+	return ops;
+}
+
+/* Formats whose binary points are 63 or 64 bits apart */
+static const Format EDGE_FORMATS[] = {
+	{ 64, 0 }, { 64, 1 }, { 64, 63 }, { 64, 64 }, { 63, 63 }, { 1, 0 },
+	{ 1, 1 },
+};
+static const unsigned int NUM_EDGE_FORMATS =
+	sizeof(EDGE_FORMATS) / sizeof(EDGE_FORMATS[0]);
+
+/* Every value of every format up to resizeWidth, into every such format and
+ * the edge formats; then the extreme values of the edge formats into all of
+ * them */
+static unsigned long long exhaustiveResize(Checker &c, const Options &o)
+{
+	vector<Format> formats = allFormats(o.resizeWidth);
+	vector<Format> targets(formats);
+	targets.insert(targets.end(), EDGE_FORMATS,
+		EDGE_FORMATS + NUM_EDGE_FORMATS);
+	atomic<unsigned long long> ops(0);
+	parallelFor(0, formats.size(), [&](size_t begin, size_t end, unsigned int)
+	{
+		unsigned long long local = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			Format f = formats[i];
+			for (int64_t v = minOf(f.width); v <= maxOf(f.width); v++)
+			{
+				for (size_t j = 0; j < targets.size(); j++)
+				{
+					local += checkResize(c, v, ~v, f, targets[j]);
+				}
+			}
+		}
+		ops += local;
+	}, o.threads);
+
+	for (unsigned int i = 0; i < NUM_EDGE_FORMATS; i++)
+	{
+		Format f = EDGE_FORMATS[i];
+		int64_t lo = minOf(f.width);
+		int64_t hi = maxOf(f.width);
+		int64_t values[] = { lo, lo + 1, lo / 2, -2, -1, 0, 1, 2, hi / 2,
+			hi - 1, hi };
+		for (unsigned int k = 0; k < sizeof(values) / sizeof(values[0]); k++)
+		{
+			int64_t v = min(max(values[k], lo), hi);
+			for (size_t j = 0; j < targets.size(); j++)
+			{
+				ops += checkResize(c, v, ~v, f, targets[j]);
+			}
+		}
+	}
+	return ops;
+}
+
+static Format randomFormat(Xoshiro256 &rng)
+{
+	Format f;
+	f.width = (unsigned int)rng.uniform(1, Fxp::MAX_WIDTH);
+	f.fracBits = (unsigned int)rng.uniform(0, f.width);
+	return f;
+}
+
+/* Uniform values, with a bias towards the edges of the range */
+static int64_t randomValue(Xoshiro256 &rng, unsigned int width)
+{
+	int64_t lo = minOf(width);
+	int64_t hi = maxOf(width);
+	switch (rng.next() % 8)
+	{
+	case 0: return lo;
+	case 1: return hi;
+	case 2: return rng.uniform(-1, min((int64_t)1, hi));
+	case 3: return rng.uniform(lo, lo / 2);
+	default: return rng.uniform(lo, hi);
+	}
+}
+
+/* A random format, or one at the edges of the binary point range */
+static Format randomResizeFormat(Xoshiro256 &rng)
+{
+	Format f;
+	switch (rng.next() % 4)
+	{
+	case 0:
+		f.width = 64;
+		f.fracBits = (unsigned int)rng.uniform(0, 1) * 63
+			+ (unsigned int)rng.uniform(0, 1);
+		return f;
+	case 1:
+		f.width = (unsigned int)rng.uniform(1, Fxp::MAX_WIDTH);
+		f.fracBits = (rng.next() % 2) ? f.width : 0;
+		return f;
+	default:
+		return randomFormat(rng);
+	}
+}
+
+static unsigned long long randomResize(Checker &c, const Options &o)
+{
+	size_t numChunks = (o.randomSamples + RANDOM_CHUNK_SIZE - 1)
+		/ RANDOM_CHUNK_SIZE;
+	atomic<unsigned long long> ops(0);
+	parallelFor(0, numChunks, [&](size_t begin, size_t end, unsigned int)
+	{
+		unsigned long long local = 0;
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			Xoshiro256 rng(o.seed + 1, chunk);
+			for (size_t s = 0; s < RANDOM_CHUNK_SIZE / 16; s++)
+			{
+				Format f = randomResizeFormat(rng);
+				Format t = randomResizeFormat(rng);
+				int64_t re = randomValue(rng, f.width);
+				int64_t im = randomValue(rng, f.width);
+				local += checkResize(c, re, im, f, t);
+			}
+		}
+		ops += local;
+	}, o.threads);
+	return ops;
+}
+
+static unsigned long long randomSweep(Checker &c, const Options &o)
+{
+	size_t numChunks = (o.randomSamples + RANDOM_CHUNK_SIZE - 1)
+		/ RANDOM_CHUNK_SIZE;
+	atomic<unsigned long long> ops(0);
+	parallelFor(0, numChunks, [&](size_t begin, size_t end, unsigned int)
+	{
+		unsigned long long local = 0;
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			/* One stream per chunk keeps results independent of thread count */
+			Xoshiro256 rng(o.seed, chunk);
+			for (size_t s = 0; s < RANDOM_CHUNK_SIZE; s++)
+			{
+				Format fa = randomFormat(rng);
+				Format fb = randomFormat(rng);
+				int64_t a = randomValue(rng, fa.width);
+				int64_t b = randomValue(rng, fb.width);
+				int64_t aIm = randomValue(rng, fa.width);
+				int64_t bIm = randomValue(rng, fb.width);
+				unsigned int n = (unsigned int)rng.uniform(0, fa.width + 1);
+				auto operands = [&]() { return describe(a, 0, fa); };
+
+				local += checkRealBinary(c, a, fa, b, fb);
+				local += checkComplexBinary(c, a, aIm, fa, b, bIm, fb);
+				local += checkComplexUnary(c, a, aIm, fa, n);
+
+				c.expect("Fxp::truncateTo", refTruncate(a, 0, fa, fa.width - n),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).truncateTo(n)); }),
+					operands);
+				c.expect("Fxp::roundTo", refRound(a, 0, fa, fa.width - n),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).roundTo(n)); }),
+					operands);
+				const Rounding &r = ROUNDINGS[rng.next() % NUM_ROUNDINGS];
+				c.expect(r.realRoundTo, refRound(a, 0, fa, fa.width - n, r.mode),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).roundTo(n, r.mode)); }),
+					operands);
+				c.expect("Fxp::saturateBy", refSaturate(a, 0, fa, fa.width - n),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).saturateBy(n)); }),
+					operands);
+				c.expect("Fxp::signExtendTo", refSignExtend(a, 0, fa, n - fa.width),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).signExtendTo(n)); }),
+					operands);
+				c.expect("Fxp::truncateBy", refTruncate(a, 0, fa, n),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).truncateBy(n)); }),
+					operands);
+				c.expect("Fxp::roundBy", refRound(a, 0, fa, n),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).roundBy(n)); }),
+					operands);
+				c.expect("Fxp::saturateTo", refSaturate(a, 0, fa, n),
+					run([&]() { return of(Fxp(a, fa.width, fa.fracBits).saturateTo(n)); }),
+					operands);
+				local += 8;
+			}
+		}
+		ops += local;
+	}, o.threads);
+	return ops;
+}
+
+static void usage(const char *argv0)
+{
+	cerr << "usage: " << argv0 << " [options]\n"
+		<< "  --unary-width N     exhaustive requantization up to N bits (16)\n"
+		<< "  --format-width N    exhaustive +,* over all formats up to N bits (6)\n"
+		<< "  --pair-width N      exhaustive +,* over all operand pairs at N bits (12)\n"
+		<< "  --complex-width N   exhaustive complex ops up to N bits (3)\n"
+		<< "  --resize-width N    exhaustive resize/assign up to N bits (8)\n"
+		<< "  --random N          random samples at widths up to 64 (1048576)\n"
+		<< "  --seed S            random seed (1)\n"
+		<< "  --threads N         worker threads, 0 for all cores (0)\n";
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	Options o = { 16, 6, 12, 3, 8, 1ULL << 20, 1, 0 };
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			usage(argv[0]);
+		}
+		unsigned long long arg = strtoull(argv[i + 1], NULL, 0);
+		if (!strcmp(argv[i], "--unary-width")) o.unaryWidth = arg;
+		else if (!strcmp(argv[i], "--format-width")) o.formatWidth = arg;
+		else if (!strcmp(argv[i], "--pair-width")) o.pairWidth = arg;
+		else if (!strcmp(argv[i], "--complex-width")) o.complexWidth = arg;
+		else if (!strcmp(argv[i], "--resize-width")) o.resizeWidth = arg;
+		else if (!strcmp(argv[i], "--random")) o.randomSamples = arg;
+		else if (!strcmp(argv[i], "--seed")) o.seed = arg;
+		else if (!strcmp(argv[i], "--threads")) o.threads = arg;
+		else usage(argv[0]);
+		i++;
+	}
+
+	if (o.unaryWidth > 24 || o.formatWidth > 10 || o.pairWidth == 0
+		|| o.pairWidth > 16 || o.complexWidth > 5 || o.resizeWidth > 12)
+	{
+		usage(argv[0]);
+	}
+
+	Checker c;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	section("exhaustive requantization, width <= "
+		+ to_string(o.unaryWidth), c,
+		[&]() { return exhaustiveUnary(c, o); });
+	section("exhaustive +,* all formats, width <= "
+		+ to_string(o.formatWidth), c,
+		[&]() { return exhaustiveFormats(c, o); });
+	section("exhaustive +,* all pairs, width "
+		+ to_string(o.pairWidth), c,
+		[&]() { return exhaustivePairs(c, o); });
+	section("exhaustive complex, width <= "
+		+ to_string(o.complexWidth), c,
+		[&]() { return exhaustiveComplex(c, o); });
+	section("exhaustive resize/assign, width <= "
+		+ to_string(o.resizeWidth), c,
+		[&]() { return exhaustiveResize(c, o); });
+	section("random, width <= " + to_string(Fxp::MAX_WIDTH), c,
+		[&]() { return randomSweep(c, o); });
+	section("random resize/assign, width <= " + to_string(Fxp::MAX_WIDTH), c,
+		[&]() { return randomResize(c, o); });
+
+	double seconds = chrono::duration<double>(
+		chrono::steady_clock::now() - start).count();
+	cout << c.failures() << " failures in " << seconds << " s" << endl;
+	return c.failures() ? 1 : 0;
+}